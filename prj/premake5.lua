@@ -2,7 +2,79 @@ function AddVulkanSDK()
     VULKAN_SDK = os.getenv("VULKAN_SDK")
     includedirs "%{VULKAN_SDK}/Include"
     libdirs "%{VULKAN_SDK}/Lib"
-    links "vulkan-1"
+
+    filter "system:windows"
+        links "vulkan-1"
+    filter "system:linux"
+        links "vulkan"
+    filter{}
+end
+
+-- Turns every shaders/*.spv into a constexpr word array that is compiled into the executable.
+-- Runs on project generation and before every build through "premake5 embed-shaders".
+function EmbedShaders()
+    local shaderFiles = os.matchfiles(path.join(_MAIN_SCRIPT_DIR, "../shaders/*.spv"))
+    local outputFile = path.join(_MAIN_SCRIPT_DIR, "../src/VulkanAPI/EmbeddedShaders.inl")
+    table.sort(shaderFiles)
+
+    if #shaderFiles == 0 then
+        error("no compiled shaders in shaders/, run shaders/compiler.bat first")
+    end
+
+    local lines = { "// Generated by \"premake5 embed-shaders\" from shaders/*.spv, do not edit", "" }
+    local entries = {}
+    for _, shaderFile in ipairs(shaderFiles) do
+        local name = (path.getbasename(shaderFile):gsub("[^%w_]", "_"))
+        local file = assert(io.open(shaderFile, "rb"))
+        local data = file:read("a")
+        file:close()
+
+        if #data % 4 ~= 0 then
+            error(shaderFile .. " is not a whole number of SPIR-V words")
+        end
+
+        local words = {}
+        for i = 1, #data, 4 do
+            table.insert(words, string.format("0x%08x", string.unpack("<I4", data, i)))
+        end
+
+        table.insert(lines, "constexpr uint32_t k_" .. name .. "Code[] = {")
+        for i = 1, #words, 8 do
+            table.insert(lines, "    " .. table.concat(words, ", ", i, math.min(i + 7, #words)) .. ",")
+        end
+        table.insert(lines, "};")
+        table.insert(lines, "")
+        table.insert(entries, "    { \"" .. name .. "\", k_" .. name .. "Code, sizeof(k_" .. name .. "Code) },")
+    end
+
+    table.insert(lines, "constexpr EmbeddedShader k_embeddedShaders[] = {")
+    for _, entry in ipairs(entries) do
+        table.insert(lines, entry)
+    end
+    table.insert(lines, "};")
+
+    -- Rewritten only on change, an untouched file does not trigger a recompile
+    local content = table.concat(lines, "\n") .. "\n"
+    if io.readfile(outputFile) ~= content then
+        io.writefile(outputFile, content)
+    end
+end
+
+newaction
+{
+    trigger = "embed-shaders",
+    description = "Regenerate src/VulkanAPI/EmbeddedShaders.inl from shaders/*.spv",
+    execute = EmbedShaders,
+}
+
+newoption
+{
+    trigger = "no-cpu-trace",
+    description = "Compile every CPU_TRACE_ZONE out of the build",
+}
+
+if _ACTION ~= nil and _ACTION ~= "embed-shaders" then
+    EmbedShaders()
 end
 
 workspace "LearnVulkan"
@@ -30,6 +102,11 @@ project "LearnVulkan"
     pchheader "stdafx.h"
     pchsource "../src/stdafx.cpp"
 
+    prebuildcommands
+    {
+        "\"" .. _PREMAKE_COMMAND .. "\" --file=\"" .. _MAIN_SCRIPT .. "\" embed-shaders"
+    }
+
     files 
     {
         "../src/**.h"
@@ -51,14 +128,65 @@ project "LearnVulkan"
         , "../libs/glm"
     }
     
-    libdirs
+    filter "system:windows"
+        libdirs
+        {
+            "../libs/glfw/lib-vc2022"
+        }
+
+        links
+        {
+            "glfw3"
+        }
+    filter{}
+
+    -- Headless runs on build machines without a display, glfw still has to link
+    filter "system:linux"
+        links
+        {
+            "glfw"
+            , "pthread"
+            , "dl"
+        }
+    filter{}
+
+    filter "configurations:Debug"
+        defines { "DEBUG" }
+        symbols "On"
+    filter{}
+
+    filter "configurations:Release"
+        defines { "NDEBUG" }
+        optimize "On"
+    filter{}
+
+    filter "options:no-cpu-trace"
+        defines { "CPU_TRACE_ENABLED=0" }
+    filter{}
+
+    AddVulkanSDK()
+project "AssetPacker"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++17"
+    staticruntime "off"
+
+    targetdir("%{wks.location}/bin/" .. outputdir .. "/%{prj.name}")
+    objdir("%{wks.location}/obj/" .. outputdir .. "/%{prj.name}")
+
+    files
     {
-        "../libs/glfw/lib-vc2022"
+        "../tools/AssetPacker/**.cpp"
+        , "../src/AssetArchiveFormat.h"
+        , "../src/Compression.h"
+        , "../src/Compression.cpp"
     }
 
-    links
+    -- stdafx.h pulls in vulkan.h, the packer itself never calls Vulkan
+    includedirs
     {
-        "glfw3"
+        "../src"
+        , "%{VULKAN_SDK}/Include"
     }
 
     filter "configurations:Debug"
@@ -70,5 +198,3 @@ project "LearnVulkan"
         defines { "NDEBUG" }
         optimize "On"
     filter{}
-
-    AddVulkanSDK()
\ No newline at end of file
@@ -1,9 +1,16 @@
 #version 450
 
+// Feature switches, bit N of the permutation mask turns on constant_id N, see ShaderPermutation
+layout(constant_id = 0) const bool k_grayscale = false;
+
 layout(location = 0) in vec3 fragColor;
 
 layout(location = 0) out vec4 outColor;
 
 void main() {
-    outColor = vec4(fragColor, 1.0);
+    vec3 color = fragColor;
+    if (k_grayscale) {
+        color = vec3(dot(color, vec3(0.299, 0.587, 0.114)));
+    }
+    outColor = vec4(color, 1.0);
 }
\ No newline at end of file
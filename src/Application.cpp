@@ -1,16 +1,73 @@
 #include "stdafx.h"
 #include "Application.h"
 
+#include "CpuTrace.h"
 #include "FileSystem.h"
+#include "JobSystem.h"
+#include "StartupReport.h"
 #include "Window.h"
 #include "VulkanAPI/VulkanAPI.h"
+#include "VulkanAPI/PresentTarget.h"
 #include "VulkanAPI/RequiredInstanceExtensionsInfo.h"
 
-Application::Application()
-    :m_window(std::make_unique<Window>())
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <thread>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+    // Iterations of the dummy work of one parallel-for item in the job benchmark
+    constexpr uint32_t k_jobBenchmarkWorkIterations = 2000;
+    constexpr uint32_t k_jobBenchmarkGrainSize = 64;
+
+    constexpr const char* k_fileBenchmarkFileName = "file_benchmark.tmp";
+    // Each size is read until about this many bytes went through, small files need many runs to time
+    constexpr uint64_t k_fileBenchmarkBytesPerSize = 256ull * 1024 * 1024;
+    constexpr uint32_t k_fileBenchmarkMaxRuns = 10000;
+    // Many small assets, the startup case where per-call latency dominates
+    constexpr uint32_t k_fileBenchmarkBatchFileCount = 256;
+    constexpr size_t k_fileBenchmarkBatchFileSize = 64 * 1024;
+
+    // Touches every byte so both paths pay for actually getting the data in
+    uint64_t Checksum(const char* i_data, size_t i_size)
+    {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < i_size; i++)
+        {
+            sum += static_cast<unsigned char>(i_data[i]);
+        }
+        return sum;
+    }
+
+    uint64_t BusyWork(uint32_t i_seed)
+    {
+        uint64_t value = i_seed;
+        for (uint32_t i = 0; i < k_jobBenchmarkWorkIterations; i++)
+        {
+            value = value * 6364136223846793005ull + 1442695040888963407ull;
+        }
+        return value;
+    }
+}
+///////////////////////////////////////////////////////////////////////////////
+
+Application::Application(const ApplicationConfig& i_config)
+    : m_config(i_config)
+    , m_window(i_config.Headless || i_config.JobBenchmarkJobs > 0 || i_config.FileBenchmarkMaxMiB > 0 ? nullptr : std::make_unique<Window>())
     , m_vulkanAPI(nullptr)
     , m_fileSystem(std::make_unique<FileSystem>())
+    , m_frameCount(0)
+    , m_mainLoopSeconds(0.0)
 {
+    if (m_fileSystem->FileExists(m_config.ArchiveFileName))
+    {
+        m_fileSystem->Mount(m_config.ArchiveFileName);
+        std::cout << "mounted " << m_config.ArchiveFileName << std::endl;
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -23,48 +80,387 @@ Application::~Application()
 
 void Application::Run()
 {
-    InitVulkan();
-    MainLoop();
-    Cleanup();
+    if (!m_config.CpuTraceFileName.empty())
+    {
+        CpuTrace::Start();
+    }
+
+    if (m_config.JobBenchmarkJobs > 0)
+    {
+        RunJobBenchmark();
+    }
+    else if (m_config.FileBenchmarkMaxMiB > 0)
+    {
+        RunFileBenchmark();
+    }
+    else if (m_config.StartupBenchmarkRuns > 0)
+    {
+        RunStartupBenchmark();
+    }
+    else
+    {
+        // Each step needs the objects of the previous one, there is nothing to spread over jobs here
+        const StartupReport startupReport = InitVulkan();
+        startupReport.Print();
+        WriteStartupReport({ startupReport });
+
+        if (m_config.RecordBenchmarkDraws > 0)
+        {
+            m_vulkanAPI->BenchmarkCommandRecording(m_config.RecordBenchmarkDraws);
+        }
+        else if (m_config.UploadBenchmarkUploads > 0)
+        {
+            m_vulkanAPI->BenchmarkUploads(m_config.UploadBenchmarkUploads);
+        }
+        else
+        {
+            MainLoop();
+        }
+        Cleanup();
+    }
+
+    if (!m_config.CpuTraceFileName.empty())
+    {
+        WriteCpuTrace();
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void Application::InitVulkan()
+StartupReport Application::InitVulkan()
 {
+    CPU_TRACE_ZONE("Application::InitVulkan");
+
 #if defined(NDEBUG)
     const std::vector<const char*> k_validationLayers;
 #else
     const std::vector<const char*> k_validationLayers {"VK_LAYER_KHRONOS_validation"};
 #endif
-    VulkanAPI::RequiredInstanceExtensionsInfo info = m_window->GetRequiredInstanceExtensionsInfo();
+    // Headless runs never touch GLFW, the instance adds whatever its present target needs
+    VulkanAPI::RequiredInstanceExtensionsInfo info;
+    VulkanAPI::PresentTarget presentTarget = VulkanAPI::PresentTarget::Window;
+    if (m_window != nullptr)
+    {
+        info = m_window->GetRequiredInstanceExtensionsInfo();
+    }
+    else
+    {
+        // Swapchain images can't be read back, capturing needs images we own
+        presentTarget = m_config.CaptureFileName.empty() ? VulkanAPI::PresentTarget::HeadlessSurface : VulkanAPI::PresentTarget::Offscreen;
+    }
+
+    StartupReport report;
     m_vulkanAPI = std::make_unique<VulkanAPI::VulkanAPI>();
-    m_vulkanAPI->CreateInstance(k_validationLayers, info, m_window, m_fileSystem);
-    m_vulkanAPI->SetupDebugMessenger();
-    m_vulkanAPI->CreateSurface();
-    m_vulkanAPI->PickPhysicalDevice();
-    m_vulkanAPI->CreateLogicalDevice();
-    m_vulkanAPI->CreateSwapChain();
-    m_vulkanAPI->CreateImageViews();
-    m_vulkanAPI->CreateRenderPass();
-    m_vulkanAPI->CreateGraphicsPipeline();
+    report.Time("CreateInstance", [&]() { m_vulkanAPI->CreateInstance(k_validationLayers, info, m_window, m_fileSystem, presentTarget, m_config.HostAllocation); });
+    report.Time("SetupDebugMessenger", [&]() { m_vulkanAPI->SetupDebugMessenger(); });
+    report.Time("CreateSurface", [&]() { m_vulkanAPI->CreateSurface(); });
+    report.Time("PickPhysicalDevice", [&]() { m_vulkanAPI->PickPhysicalDevice(); });
+    report.Time("CreateLogicalDevice", [&]() { m_vulkanAPI->CreateLogicalDevice(m_config.DynamicRendering); });
+    report.Time("CreateSwapChain", [&]() { m_vulkanAPI->CreateSwapChain(); });
+    report.Time("CreateImageViews", [&]() { m_vulkanAPI->CreateImageViews(); });
+    report.Time("CreateRenderPass", [&]() { m_vulkanAPI->CreateRenderPass(); });
+    // Only queues the compile, WaitForPipelines in the startup benchmark measures the rest
+    report.Time("CreateGraphicsPipeline", [&]() { m_vulkanAPI->CreateGraphicsPipeline(m_config.ShaderOverrideDirectory, m_config.ShaderPermutation); });
+    report.Time("CreateFramebuffers", [&]() { m_vulkanAPI->CreateFramebuffers(); });
+    report.Time("CreateCommandPool", [&]() { m_vulkanAPI->CreateCommandPool(); });
+    report.Time("CreateCommandBuffers", [&]() { m_vulkanAPI->CreateCommandBuffers(m_config.FramesInFlight, m_config.GpuCounters); });
+    report.Time("CreateSyncObjects", [&]() { m_vulkanAPI->CreateSyncObjects(); });
+    return report;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
 void Application::MainLoop()
 {
-    while (!m_window->IsExiting())
+    using Clock = std::chrono::steady_clock;
+
+    const Clock::time_point loopStart = Clock::now();
+    Clock::time_point reportStart = loopStart;
+    uint64_t reportFrameCount = 0;
+
+    while (m_config.FrameLimit == 0 || m_frameCount < m_config.FrameLimit)
     {
-        m_window->Update();
+        CPU_TRACE_ZONE("frame");
+
+        if (m_window != nullptr)
+        {
+            if (m_window->IsExiting())
+            {
+                break;
+            }
+
+            {
+                CPU_TRACE_ZONE("Window::Update");
+                m_window->Update();
+            }
+
+            // A minimized window has a zero sized surface, there is no swapchain to render to
+            if (m_window->IsMinimized())
+            {
+                m_window->WaitEvents();
+                continue;
+            }
+        }
+
+        m_vulkanAPI->DrawFrame();
+
+        m_frameCount++;
+        reportFrameCount++;
+
+        const Clock::time_point now = Clock::now();
+        const double reportSeconds = std::chrono::duration<double>(now - reportStart).count();
+        if (reportSeconds >= 1.0)
+        {
+            const double fps = reportFrameCount / reportSeconds;
+            std::cout << std::fixed << std::setprecision(1)
+                << "fps: " << fps << " (" << std::setprecision(2) << 1000.0 / fps << " ms/frame, "
+                << m_config.FramesInFlight << " frames in flight)" << std::endl;
+
+            reportStart = now;
+            reportFrameCount = 0;
+        }
     }
+
+    m_mainLoopSeconds = std::chrono::duration<double>(Clock::now() - loopStart).count();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
 void Application::Cleanup()
 {
+    // Frames may still be in flight, nothing can be destroyed before the GPU is done with them
+    m_vulkanAPI->WaitIdle();
+    m_vulkanAPI->SavePipelineCache();
+    m_vulkanAPI->PrintMemoryStatistics();
+    m_vulkanAPI->PrintPipelineStatistics();
+    m_vulkanAPI->PrintGpuStatistics();
+    m_vulkanAPI->PrintHostAllocationStatistics();
+
+    if (!m_config.CaptureFileName.empty())
+    {
+        m_vulkanAPI->CaptureFrame(m_config.CaptureFileName);
+    }
+
+    if (m_frameCount > 0 && m_mainLoopSeconds > 0.0)
+    {
+        std::cout << std::fixed << std::setprecision(1)
+            << "sustained fps: " << m_frameCount / m_mainLoopSeconds
+            << " over " << m_frameCount << " frames" << std::endl;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Application::WriteCpuTrace()
+{
+    CpuTrace::Stop();
+#if !CPU_TRACE_ENABLED
+    std::cout << "cpu zones were compiled out, the trace only holds thread names" << std::endl;
+#endif
+
+    const std::string trace = CpuTrace::ExportChromeTrace();
+    m_fileSystem->WriteFile(m_config.CpuTraceFileName, std::vector<char>(trace.begin(), trace.end()));
+    std::cout << "wrote cpu trace to " << m_config.CpuTraceFileName << std::endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Application::WriteStartupReport(const std::vector<StartupReport>& i_runs)
+{
+    if (m_config.StartupReportFileName.empty())
+    {
+        return;
+    }
+
+    const std::string json = StartupReport::ToJson(i_runs);
+    m_fileSystem->WriteFile(m_config.StartupReportFileName, std::vector<char>(json.begin(), json.end()));
+    std::cout << "wrote startup report to " << m_config.StartupReportFileName << std::endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Application::RunStartupBenchmark()
+{
+    std::vector<StartupReport> runs;
+    runs.reserve(m_config.StartupBenchmarkRuns);
+
+    for (uint32_t run = 0; run < m_config.StartupBenchmarkRuns; run++)
+    {
+        StartupReport report = InitVulkan();
+        // A pipeline still compiling would be finished by the teardown and blur both numbers
+        report.Time("WaitForPipelines", [&]() { m_vulkanAPI->WaitForPipelines(); });
+        runs.push_back(std::move(report));
+
+        m_vulkanAPI.reset();
+    }
+
+    StartupReport::PrintDistribution(runs);
+    WriteStartupReport(runs);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Application::RunJobBenchmark()
+{
+    using Clock = std::chrono::steady_clock;
+
+    const uint32_t jobCount = m_config.JobBenchmarkJobs;
+    const uint32_t maxThreadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << "job benchmark: " << jobCount << " jobs" << std::endl;
+
+    double baseSeconds = 0.0;
+    for (uint32_t threadCount = 1; ; threadCount = std::min(threadCount * 2, maxThreadCount))
+    {
+        JobSystem jobSystem(threadCount);
+
+        // Empty jobs, only the cost of queueing, stealing and counting them down. The untimed first pass
+        // fills the job pools, the timed one measures the steady state instead of the heap.
+        std::atomic<uint32_t> executed(0);
+        double spawnSeconds = 0.0;
+        for (uint32_t pass = 0; pass < 2; pass++)
+        {
+            JobCounter counter;
+            const Clock::time_point spawnStart = Clock::now();
+            for (uint32_t i = 0; i < jobCount; i++)
+            {
+                jobSystem.Run([&executed]() { executed.fetch_add(1, std::memory_order_relaxed); }, &counter);
+            }
+            jobSystem.Wait(counter);
+            spawnSeconds = std::chrono::duration<double>(Clock::now() - spawnStart).count();
+        }
+        assert(executed.load() == 2 * jobCount);
+
+        // Same item count with some work behind it, shows how far the scheduler scales
+        std::vector<uint64_t> results(jobCount);
+        const Clock::time_point forStart = Clock::now();
+        jobSystem.ParallelFor(jobCount, k_jobBenchmarkGrainSize, [&results](uint32_t i_first, uint32_t i_count) {
+            for (uint32_t i = i_first; i < i_first + i_count; i++)
+            {
+                results[i] = BusyWork(i);
+            }
+        });
+        const double forSeconds = std::chrono::duration<double>(Clock::now() - forStart).count();
+
+        if (threadCount == 1)
+        {
+            baseSeconds = forSeconds;
+        }
 
+        std::cout << std::fixed << std::setprecision(1)
+            << "  " << threadCount << " threads: " << spawnSeconds * 1e9 / jobCount << " ns/job, parallel for "
+            << std::setprecision(2) << forSeconds * 1000.0 << " ms (" << baseSeconds / forSeconds << "x)" << std::endl;
+
+        if (threadCount == maxThreadCount)
+        {
+            break;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Application::RunFileBenchmark()
+{
+    using Clock = std::chrono::steady_clock;
+
+    const uint64_t maxSize = static_cast<uint64_t>(m_config.FileBenchmarkMaxMiB) * 1024 * 1024;
+
+    // The file was just written, both paths read from a warm page cache
+    std::cout << "file benchmark: warm page cache, " << k_fileBenchmarkFileName << std::endl;
+
+    for (uint64_t size = 1024; size <= maxSize; size *= 32)
+    {
+        {
+            std::vector<char> data(static_cast<size_t>(size));
+            for (size_t i = 0; i < data.size(); i++)
+            {
+                data[i] = static_cast<char>(i * 31);
+            }
+            m_fileSystem->WriteFile(k_fileBenchmarkFileName, data);
+        }
+
+        const uint32_t runs = static_cast<uint32_t>(std::clamp<uint64_t>(k_fileBenchmarkBytesPerSize / size, 1, k_fileBenchmarkMaxRuns));
+        uint64_t readSum = 0;
+        uint64_t mapSum = 0;
+
+        const Clock::time_point readStart = Clock::now();
+        for (uint32_t run = 0; run < runs; run++)
+        {
+            std::vector<char> file = m_fileSystem->ReadFile(k_fileBenchmarkFileName);
+            readSum += Checksum(file.data(), file.size());
+        }
+        const double readSeconds = std::chrono::duration<double>(Clock::now() - readStart).count() / runs;
+
+        const Clock::time_point mapStart = Clock::now();
+        for (uint32_t run = 0; run < runs; run++)
+        {
+            MappedFile file = m_fileSystem->MapFile(k_fileBenchmarkFileName);
+            mapSum += Checksum(file.GetData(), file.GetSize());
+        }
+        const double mapSeconds = std::chrono::duration<double>(Clock::now() - mapStart).count() / runs;
+
+        if (readSum != mapSum)
+        {
+            throw std::runtime_error("file benchmark read different data through ReadFile and MapFile!");
+        }
+
+        const double mebibytes = size / (1024.0 * 1024.0);
+        std::cout << std::fixed << std::setprecision(3)
+            << "  " << size / 1024 << " KiB: ReadFile " << readSeconds * 1000.0 << " ms (" << std::setprecision(0) << mebibytes / readSeconds << " MiB/s), "
+            << std::setprecision(3) << "MapFile " << mapSeconds * 1000.0 << " ms (" << std::setprecision(0) << mebibytes / mapSeconds << " MiB/s)" << std::endl;
+    }
+
+    std::remove(k_fileBenchmarkFileName);
+
+    std::vector<AsyncFileReader::Request> requests(k_fileBenchmarkBatchFileCount);
+    {
+        const std::vector<char> data(k_fileBenchmarkBatchFileSize, 'x');
+        for (uint32_t i = 0; i < k_fileBenchmarkBatchFileCount; i++)
+        {
+            requests[i].fileName = std::string(k_fileBenchmarkFileName) + "." + std::to_string(i);
+            m_fileSystem->WriteFile(requests[i].fileName, data);
+        }
+    }
+
+    auto timeBatch = [](const std::function<void()>& i_readAll) {
+        const Clock::time_point start = Clock::now();
+        i_readAll();
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    };
+
+    const double blockingSeconds = timeBatch([&]() {
+        for (const AsyncFileReader::Request& request : requests)
+        {
+            m_fileSystem->ReadFile(request.fileName);
+        }
+    });
+
+    auto readBatch = [&requests](AsyncFileReader& io_reader) {
+        std::vector<std::future<std::vector<char>>> futures = io_reader.Read(requests);
+        for (std::future<std::vector<char>>& future : futures)
+        {
+            if (future.get().size() != k_fileBenchmarkBatchFileSize)
+            {
+                throw std::runtime_error("file benchmark read a truncated file!");
+            }
+        }
+    };
+
+    AsyncFileReader defaultReader;
+    AsyncFileReader threadPoolReader(AsyncFileReader::Backend::ThreadPool);
+    const double defaultSeconds = timeBatch([&]() { readBatch(defaultReader); });
+    const double threadPoolSeconds = timeBatch([&]() { readBatch(threadPoolReader); });
+
+    std::cout << std::fixed << std::setprecision(3)
+        << "  " << k_fileBenchmarkBatchFileCount << " x " << k_fileBenchmarkBatchFileSize / 1024 << " KiB files: ReadFile "
+        << blockingSeconds * 1000.0 << " ms, async " << (defaultReader.GetBackend() == AsyncFileReader::Backend::IoUring ? "io_uring " : "thread pool ")
+        << defaultSeconds * 1000.0 << " ms, async thread pool " << threadPoolSeconds * 1000.0 << " ms" << std::endl;
+
+    for (const AsyncFileReader::Request& request : requests)
+    {
+        std::remove(request.fileName.c_str());
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
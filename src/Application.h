@@ -1,6 +1,9 @@
 #pragma once
 
+#include "ApplicationConfig.h"
+
 class FileSystem;
+class StartupReport;
 class Window;
 namespace VulkanAPI
 {
@@ -10,19 +13,31 @@ class VulkanAPI;
 class Application {
 ///////////////////////////////////////////////////////////////////////////////
 public:
-    Application();
+    Application(const ApplicationConfig& i_config);
     ~Application();
     void Run();
 
 private:
-    void InitVulkan();
+    StartupReport InitVulkan();
     void MainLoop();
     void Cleanup();
+    // Chrome trace JSON of the zones recorded since Run started
+    void WriteCpuTrace();
+    void RunJobBenchmark();
+    void RunFileBenchmark();
+    // Initializes and tears down Vulkan StartupBenchmarkRuns times and prints the distribution of every stage
+    void RunStartupBenchmark();
+    // Only when a report file was asked for
+    void WriteStartupReport(const std::vector<StartupReport>& i_runs);
 
 private:
+    ApplicationConfig m_config;
     std::unique_ptr<Window> m_window;
     std::unique_ptr<VulkanAPI::VulkanAPI> m_vulkanAPI;
     std::unique_ptr<FileSystem> m_fileSystem;
 
+    uint64_t m_frameCount;
+    double m_mainLoopSeconds;
+
 ///////////////////////////////////////////////////////////////////////////////
 };
\ No newline at end of file
@@ -0,0 +1,195 @@
+#include "stdafx.h"
+#include "ApplicationConfig.h"
+
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+    constexpr uint64_t k_defaultHeadlessFrameLimit = 1000;
+
+    uint32_t ParseUInt(const std::string& i_option, const char* i_value)
+    {
+        if (i_value == nullptr)
+        {
+            throw std::runtime_error("missing value for " + i_option + "!");
+        }
+
+        // stoul would skip whitespace, wrap a leading '-' around and stop at the first non-digit
+        const size_t length = std::strlen(i_value);
+        if (length == 0 || !std::isdigit(static_cast<unsigned char>(i_value[0])))
+        {
+            throw std::runtime_error("invalid value for " + i_option + "!");
+        }
+
+        unsigned long value = 0;
+        size_t parsedLength = 0;
+        try
+        {
+            value = std::stoul(i_value, &parsedLength);
+        }
+        catch (const std::exception&)
+        {
+            throw std::runtime_error("invalid value for " + i_option + "!");
+        }
+
+        if (parsedLength != length || value > UINT32_MAX)
+        {
+            throw std::runtime_error("invalid value for " + i_option + "!");
+        }
+        return static_cast<uint32_t>(value);
+    }
+}
+///////////////////////////////////////////////////////////////////////////////
+
+ApplicationConfig ApplicationConfig::ParseCommandLine(int i_argc, char** i_argv)
+{
+    ApplicationConfig config;
+
+    for (int i = 1; i < i_argc; i++)
+    {
+        const std::string option = i_argv[i];
+        const char* value = (i + 1 < i_argc) ? i_argv[i + 1] : nullptr;
+
+        if (option == "--frames-in-flight")
+        {
+            config.FramesInFlight = ParseUInt(option, value);
+            if (config.FramesInFlight == 0)
+            {
+                throw std::runtime_error("--frames-in-flight must be at least 1!");
+            }
+            i++;
+        }
+        else if (option == "--headless")
+        {
+            config.Headless = true;
+        }
+        else if (option == "--dynamic-rendering")
+        {
+            config.DynamicRendering = true;
+        }
+        else if (option == "--frames")
+        {
+            config.FrameLimit = ParseUInt(option, value);
+            i++;
+        }
+        else if (option == "--capture")
+        {
+            if (value == nullptr)
+            {
+                throw std::runtime_error("missing value for " + option + "!");
+            }
+            config.CaptureFileName = value;
+            i++;
+        }
+        else if (option == "--archive")
+        {
+            if (value == nullptr)
+            {
+                throw std::runtime_error("missing value for " + option + "!");
+            }
+            config.ArchiveFileName = value;
+            i++;
+        }
+        else if (option == "--shader-dir")
+        {
+            if (value == nullptr)
+            {
+                throw std::runtime_error("missing value for " + option + "!");
+            }
+            config.ShaderOverrideDirectory = value;
+            i++;
+        }
+        else if (option == "--shader-permutation")
+        {
+            config.ShaderPermutation = ParseUInt(option, value);
+            i++;
+        }
+        else if (option == "--gpu-counters")
+        {
+            config.GpuCounters = true;
+        }
+        else if (option == "--host-allocator")
+        {
+            const std::string mode = value != nullptr ? value : "";
+            if (mode == "tracked")
+            {
+                config.HostAllocation = VulkanAPI::HostAllocationMode::Tracked;
+            }
+            else if (mode == "pooled")
+            {
+                config.HostAllocation = VulkanAPI::HostAllocationMode::Pooled;
+            }
+            else
+            {
+                throw std::runtime_error("expected tracked or pooled for " + option + "!");
+            }
+            i++;
+        }
+        else if (option == "--cpu-trace")
+        {
+            if (value == nullptr)
+            {
+                throw std::runtime_error("missing value for " + option + "!");
+            }
+            config.CpuTraceFileName = value;
+            i++;
+        }
+        else if (option == "--record-benchmark")
+        {
+            config.RecordBenchmarkDraws = ParseUInt(option, value);
+            i++;
+        }
+        else if (option == "--upload-benchmark")
+        {
+            config.UploadBenchmarkUploads = ParseUInt(option, value);
+            i++;
+        }
+        else if (option == "--job-benchmark")
+        {
+            config.JobBenchmarkJobs = ParseUInt(option, value);
+            i++;
+        }
+        else if (option == "--file-benchmark")
+        {
+            config.FileBenchmarkMaxMiB = ParseUInt(option, value);
+            i++;
+        }
+        else if (option == "--startup-bench")
+        {
+            config.StartupBenchmarkRuns = ParseUInt(option, value);
+            i++;
+        }
+        else if (option == "--startup-report")
+        {
+            if (value == nullptr)
+            {
+                throw std::runtime_error("missing value for " + option + "!");
+            }
+            config.StartupReportFileName = value;
+            i++;
+        }
+        else
+        {
+            throw std::runtime_error("unknown option " + option + "!");
+        }
+    }
+
+    if (config.Headless && config.FrameLimit == 0)
+    {
+        // There is no window to close, a headless run has to end on its own
+        config.FrameLimit = k_defaultHeadlessFrameLimit;
+    }
+
+    if (!config.CaptureFileName.empty() && !config.Headless)
+    {
+        throw std::runtime_error("--capture is only supported together with --headless!");
+    }
+
+    return config;
+}
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "VulkanAPI/HostAllocationMode.h"
+
+///////////////////////////////////////////////////////////////////////////////
+struct ApplicationConfig
+{
+    // Number of frame slots the CPU may record ahead of the GPU
+    uint32_t FramesInFlight = 2;
+    // Render without a window, to VK_EXT_headless_surface when available or to offscreen images
+    bool Headless = false;
+    // Begin passes with vkCmdBeginRendering instead of render pass and framebuffer objects, when the device has Vulkan 1.3
+    bool DynamicRendering = false;
+    // Exit after this many frames, 0 renders until the window is closed
+    uint64_t FrameLimit = 0;
+    // Write the last rendered frame to this PPM file, forces offscreen images in headless mode
+    std::string CaptureFileName;
+    // Record this many draws with 1..N threads, print the timings and exit instead of running the main loop
+    uint32_t RecordBenchmarkDraws = 0;
+    // Queue this many small buffer uploads per frame through the staging ring, print the submits and allocations and exit
+    uint32_t UploadBenchmarkUploads = 0;
+    // Schedule this many jobs with 1..N threads, print the overhead and scaling and exit without touching Vulkan
+    uint32_t JobBenchmarkJobs = 0;
+    // Read files from 1 KiB up to this many MiB with ReadFile and MapFile, print the timings and exit
+    uint32_t FileBenchmarkMaxMiB = 0;
+    // Initialize and tear down Vulkan this many times, print the time of every startup stage and exit
+    uint32_t StartupBenchmarkRuns = 0;
+    // Write the startup stage timings as JSON to this file
+    std::string StartupReportFileName;
+    // Mounted at startup when it exists, assets found in it are not looked up on disk
+    std::string ArchiveFileName = "assets.lvpk";
+    // Load .spv files from this directory instead of the shaders embedded in the executable
+    std::string ShaderOverrideDirectory;
+    // Bitmask of shader feature switches, bit N turns on the boolean specialization constant with constant_id N
+    uint32_t ShaderPermutation = 0;
+    // Count vertices, primitives, shader invocations and passed samples of every profiled GPU pass
+    bool GpuCounters = false;
+    // Route driver host allocations through counting VkAllocationCallbacks, "tracked" on malloc or "pooled"
+    VulkanAPI::HostAllocationMode HostAllocation = VulkanAPI::HostAllocationMode::Default;
+    // Record CPU zones for the whole run and write them to this file as a Chrome trace
+    std::string CpuTraceFileName;
+
+    static ApplicationConfig ParseCommandLine(int i_argc, char** i_argv);
+};
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,137 @@
+#include "stdafx.h"
+#include "AssetArchive.h"
+
+#include "Compression.h"
+
+#include <algorithm>
+#include <cstring>
+
+///////////////////////////////////////////////////////////////////////////////
+
+AssetArchive::AssetArchive(const std::string& i_fileName)
+    : m_fileName(i_fileName)
+    , m_file(nullptr)
+    , m_toc(nullptr)
+    , m_entryCount(0)
+    , m_paths(nullptr)
+    , m_pathsSize(0)
+{
+    // Assets are picked all over the archive, read-ahead past an entry is mostly wasted
+    m_file = std::make_shared<MappedFile>(i_fileName, FileAccess::Random);
+    Validate();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+AssetArchive::~AssetArchive()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void AssetArchive::Validate()
+{
+    using namespace AssetArchiveFormat;
+
+    const char* data = m_file->GetData();
+    const uint64_t fileSize = m_file->GetSize();
+
+    Header header;
+    if (fileSize < sizeof(header)) {
+        throw std::runtime_error("failed to mount archive, file too small!");
+    }
+    memcpy(&header, data, sizeof(header));
+
+    if (header.magic != k_magic || header.version != k_version) {
+        throw std::runtime_error("failed to mount archive, unknown format!");
+    }
+
+    // The table is used in place, it has to be aligned and inside the file
+    const uint64_t tocSize = static_cast<uint64_t>(header.entryCount) * sizeof(TocEntry);
+    if (header.tocOffset % alignof(TocEntry) != 0 || header.tocOffset > fileSize || tocSize > fileSize - header.tocOffset
+        || header.pathsOffset > fileSize || header.pathsSize > fileSize - header.pathsOffset) {
+        throw std::runtime_error("failed to mount archive, table out of bounds!");
+    }
+
+    m_toc = reinterpret_cast<const TocEntry*>(data + header.tocOffset);
+    m_entryCount = header.entryCount;
+    m_paths = data + header.pathsOffset;
+    m_pathsSize = header.pathsSize;
+
+    for (uint32_t i = 0; i < m_entryCount; i++)
+    {
+        const TocEntry& entry = m_toc[i];
+        if (i > 0 && m_toc[i - 1].pathHash > entry.pathHash) {
+            throw std::runtime_error("failed to mount archive, table not sorted!");
+        }
+        if (entry.offset > fileSize || entry.storedSize > fileSize - entry.offset) {
+            throw std::runtime_error("failed to mount archive, entry out of bounds!");
+        }
+        // Stored entries are handed out in place, the packer aligns them so SPIR-V and other word data can be read directly
+        if (entry.offset % AssetArchiveFormat::k_entryAlignment != 0) {
+            throw std::runtime_error("failed to mount archive, entry not aligned!");
+        }
+        if (entry.pathOffset > m_pathsSize || entry.pathSize > m_pathsSize - entry.pathOffset) {
+            throw std::runtime_error("failed to mount archive, path out of bounds!");
+        }
+        if (entry.compression == EntryCompression::None ? entry.storedSize != entry.size : entry.compression != EntryCompression::Lz) {
+            throw std::runtime_error("failed to mount archive, unknown entry compression!");
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+const AssetArchive::TocEntry* AssetArchive::Find(const std::string& i_path) const
+{
+    const std::string path = AssetArchiveFormat::NormalizePath(i_path);
+    const uint64_t hash = AssetArchiveFormat::HashPath(path);
+
+    const TocEntry* end = m_toc + m_entryCount;
+    const TocEntry* entry = std::lower_bound(m_toc, end, hash, [](const TocEntry& i_entry, uint64_t i_hash) {
+        return i_entry.pathHash < i_hash;
+    });
+
+    // Different paths may share a hash, the stored path decides
+    for (; entry != end && entry->pathHash == hash; entry++)
+    {
+        if (entry->pathSize == path.size() && memcmp(m_paths + entry->pathOffset, path.data(), path.size()) == 0)
+        {
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+std::vector<char> AssetArchive::Read(const TocEntry& i_entry) const
+{
+    const char* storedData = m_file->GetData() + i_entry.offset;
+
+    std::vector<char> data(static_cast<size_t>(i_entry.size));
+    if (i_entry.compression == AssetArchiveFormat::EntryCompression::None)
+    {
+        std::copy(storedData, storedData + data.size(), data.begin());
+    }
+    else
+    {
+        Compression::Decompress(storedData, static_cast<size_t>(i_entry.storedSize), data.data(), data.size());
+    }
+    return data;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+MappedFile AssetArchive::Map(const TocEntry& i_entry) const
+{
+    if (i_entry.compression == AssetArchiveFormat::EntryCompression::None)
+    {
+        return MappedFile(m_file, m_file->GetData() + i_entry.offset, static_cast<size_t>(i_entry.size));
+    }
+
+    std::shared_ptr<std::vector<char>> data = std::make_shared<std::vector<char>>(Read(i_entry));
+    return MappedFile(data, data->data(), data->size());
+}
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "AssetArchiveFormat.h"
+#include "MappedFile.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// A mounted .lvpk archive: one open and one mapping for the whole file, lookups are a binary search
+// of the table of contents by path hash. Written offline by the AssetPacker tool.
+class AssetArchive {
+///////////////////////////////////////////////////////////////////////////////
+public:
+    using TocEntry = AssetArchiveFormat::TocEntry;
+
+    // Throws when the file is not a valid archive
+    AssetArchive(const std::string& i_fileName);
+    ~AssetArchive();
+
+    // nullptr when the archive has no such path
+    const TocEntry* Find(const std::string& i_path) const;
+
+    std::vector<char> Read(const TocEntry& i_entry) const;
+    // In place for stored entries, compressed ones are unpacked into memory owned by the view.
+    // The view keeps the archive mapping alive on its own.
+    MappedFile Map(const TocEntry& i_entry) const;
+
+    const std::string& GetFileName() const
+    {
+        return m_fileName;
+    }
+
+    uint32_t GetEntryCount() const
+    {
+        return m_entryCount;
+    }
+
+private:
+    void Validate();
+
+private:
+    std::string m_fileName;
+    // Shared with the views handed out by Map
+    std::shared_ptr<MappedFile> m_file;
+    const TocEntry* m_toc;
+    uint32_t m_entryCount;
+    const char* m_paths;
+    uint32_t m_pathsSize;
+};
+///////////////////////////////////////////////////////////////////////////////
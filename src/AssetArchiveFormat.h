@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+
+///////////////////////////////////////////////////////////////////////////////
+// On-disk layout of a .lvpk asset archive, shared by AssetArchive and the AssetPacker tool.
+// [Header][TocEntry x entryCount, sorted by pathHash][path strings][entry data, each k_entryAlignment aligned]
+// Entries are page aligned so stored ones can be used in place from a mapping of the whole archive.
+namespace AssetArchiveFormat
+{
+    constexpr uint32_t k_magic = 0x4B50564C; // "LVPK"
+    constexpr uint32_t k_version = 1;
+    constexpr uint64_t k_entryAlignment = 4096;
+
+    enum class EntryCompression : uint32_t
+    {
+        None = 0,
+        Lz = 1,
+    };
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t pathsSize;
+        uint64_t tocOffset;
+        uint64_t pathsOffset;
+    };
+
+    struct TocEntry
+    {
+        uint64_t pathHash;
+        uint64_t offset;
+        // Bytes in the archive, equal to size for stored entries
+        uint64_t storedSize;
+        uint64_t size;
+        uint32_t pathOffset;
+        uint32_t pathSize;
+        EntryCompression compression;
+        uint32_t reserved;
+    };
+
+    static_assert(sizeof(Header) == 32, "archive header layout changed");
+    static_assert(sizeof(TocEntry) == 48, "archive toc entry layout changed");
+
+    // Forward slashes, no leading "./", so "shaders\\vert.spv" and "./shaders/vert.spv" find the same entry
+    inline std::string NormalizePath(const std::string& i_path)
+    {
+        std::string path = i_path;
+        for (char& c : path)
+        {
+            if (c == '\\')
+            {
+                c = '/';
+            }
+        }
+        while (path.compare(0, 2, "./") == 0)
+        {
+            path.erase(0, 2);
+        }
+        return path;
+    }
+
+    // FNV-1a over the normalized path
+    inline uint64_t HashPath(const std::string& i_normalizedPath)
+    {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (char c : i_normalizedPath)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 0x100000001B3ull;
+        }
+        return hash;
+    }
+}
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,541 @@
+#include "stdafx.h"
+#include "AsyncFileReader.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <cerrno>
+#endif
+
+#include <algorithm>
+#include <cstring>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+    // Reads in flight at once with io_uring, the queue holds the rest
+    constexpr uint32_t k_ioUringQueueDepth = 256;
+    // Blocking reads only overlap across threads, a few more than cores keeps the disk busy
+    constexpr uint32_t k_threadPoolThreadCount = 8;
+
+#if !defined(_WIN32)
+    // Opens the file and resolves a size of 0 to the end of the file
+    int OpenRange(const AsyncFileReader::Request& i_request, uint64_t& o_size)
+    {
+        int file = open(i_request.fileName.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file < 0) {
+            throw std::runtime_error("failed to open file!");
+        }
+
+        struct stat fileStat;
+        if (fstat(file, &fileStat) != 0) {
+            close(file);
+            throw std::runtime_error("failed to get file size!");
+        }
+
+        const uint64_t fileSize = static_cast<uint64_t>(fileStat.st_size);
+        if (i_request.offset > fileSize || i_request.size > fileSize - i_request.offset) {
+            close(file);
+            throw std::runtime_error("failed to read past the end of file!");
+        }
+
+        o_size = i_request.size != 0 ? i_request.size : fileSize - i_request.offset;
+        return file;
+    }
+#endif
+
+    std::vector<char> ReadRange(const AsyncFileReader::Request& i_request)
+    {
+#if defined(_WIN32)
+        HANDLE file = CreateFileA(i_request.fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("failed to open file!");
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize)) {
+            CloseHandle(file);
+            throw std::runtime_error("failed to get file size!");
+        }
+
+        const uint64_t totalSize = static_cast<uint64_t>(fileSize.QuadPart);
+        if (i_request.offset > totalSize || i_request.size > totalSize - i_request.offset) {
+            CloseHandle(file);
+            throw std::runtime_error("failed to read past the end of file!");
+        }
+
+        std::vector<char> data(static_cast<size_t>(i_request.size != 0 ? i_request.size : totalSize - i_request.offset));
+        uint64_t completed = 0;
+        while (completed < data.size())
+        {
+            // An OVERLAPPED offset on a synchronous handle is a positional read, the handle keeps no shared cursor
+            const uint64_t offset = i_request.offset + completed;
+            OVERLAPPED overlapped{};
+            overlapped.Offset = static_cast<DWORD>(offset);
+            overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+            const DWORD chunkSize = static_cast<DWORD>(std::min<uint64_t>(data.size() - completed, 1u << 30));
+            DWORD readSize = 0;
+            if (!::ReadFile(file, data.data() + completed, chunkSize, &readSize, &overlapped) || readSize == 0) {
+                CloseHandle(file);
+                throw std::runtime_error("failed to read file!");
+            }
+            completed += readSize;
+        }
+
+        CloseHandle(file);
+        return data;
+#else
+        uint64_t size = 0;
+        int file = OpenRange(i_request, size);
+
+        std::vector<char> data(static_cast<size_t>(size));
+        uint64_t completed = 0;
+        while (completed < size)
+        {
+            const ssize_t readSize = pread(file, data.data() + completed, size - completed, i_request.offset + completed);
+            if (readSize < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (readSize <= 0) {
+                close(file);
+                throw std::runtime_error("failed to read file!");
+            }
+            completed += static_cast<uint64_t>(readSize);
+        }
+
+        close(file);
+        return data;
+#endif
+    }
+}
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(__linux__)
+
+// Minimal io_uring on raw syscalls: one submission ring, one completion ring, nothing else
+class AsyncFileReader::IoUring {
+public:
+    // nullptr when the kernel has no io_uring or it is blocked, the caller falls back to threads
+    static std::unique_ptr<IoUring> Create(uint32_t i_entryCount)
+    {
+        std::unique_ptr<IoUring> ring(new IoUring());
+
+        io_uring_params params{};
+        ring->m_ring = static_cast<int>(syscall(__NR_io_uring_setup, i_entryCount, &params));
+        if (ring->m_ring < 0)
+        {
+            return nullptr;
+        }
+
+        ring->m_submissionRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        ring->m_completionRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMapping)
+        {
+            ring->m_submissionRingSize = std::max(ring->m_submissionRingSize, ring->m_completionRingSize);
+            ring->m_completionRingSize = 0;
+        }
+
+        void* submissionRing = mmap(nullptr, ring->m_submissionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->m_ring, IORING_OFF_SQ_RING);
+        if (submissionRing == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        ring->m_submissionRing = static_cast<char*>(submissionRing);
+
+        ring->m_completionRing = ring->m_submissionRing;
+        if (!singleMapping)
+        {
+            void* completionRing = mmap(nullptr, ring->m_completionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->m_ring, IORING_OFF_CQ_RING);
+            if (completionRing == MAP_FAILED)
+            {
+                return nullptr;
+            }
+            ring->m_completionRing = static_cast<char*>(completionRing);
+        }
+
+        ring->m_entriesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* entries = mmap(nullptr, ring->m_entriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->m_ring, IORING_OFF_SQES);
+        if (entries == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        ring->m_entries = static_cast<io_uring_sqe*>(entries);
+
+        ring->m_submissionTail = reinterpret_cast<uint32_t*>(ring->m_submissionRing + params.sq_off.tail);
+        ring->m_submissionMask = *reinterpret_cast<uint32_t*>(ring->m_submissionRing + params.sq_off.ring_mask);
+        ring->m_submissionArray = reinterpret_cast<uint32_t*>(ring->m_submissionRing + params.sq_off.array);
+        ring->m_completionHead = reinterpret_cast<uint32_t*>(ring->m_completionRing + params.cq_off.head);
+        ring->m_completionTail = reinterpret_cast<uint32_t*>(ring->m_completionRing + params.cq_off.tail);
+        ring->m_completionMask = *reinterpret_cast<uint32_t*>(ring->m_completionRing + params.cq_off.ring_mask);
+        ring->m_completions = reinterpret_cast<io_uring_cqe*>(ring->m_completionRing + params.cq_off.cqes);
+        return ring;
+    }
+
+    ~IoUring()
+    {
+        if (m_entries != nullptr)
+        {
+            munmap(m_entries, m_entriesSize);
+        }
+        if (m_completionRing != nullptr && m_completionRing != m_submissionRing)
+        {
+            munmap(m_completionRing, m_completionRingSize);
+        }
+        if (m_submissionRing != nullptr)
+        {
+            munmap(m_submissionRing, m_submissionRingSize);
+        }
+        if (m_ring >= 0)
+        {
+            close(m_ring);
+        }
+    }
+
+    // io_vector is read by the kernel and has to stay alive until the completion
+    void PrepareRead(int i_file, iovec& io_vector, uint64_t i_offset, void* i_userData)
+    {
+        // Only this thread writes the tail, the kernel reads it
+        const uint32_t tail = *m_submissionTail;
+        const uint32_t index = tail & m_submissionMask;
+
+        io_uring_sqe& entry = m_entries[index];
+        memset(&entry, 0, sizeof(entry));
+        entry.opcode = IORING_OP_READV;
+        entry.fd = i_file;
+        entry.addr = reinterpret_cast<uint64_t>(&io_vector);
+        entry.len = 1;
+        entry.off = i_offset;
+        entry.user_data = reinterpret_cast<uint64_t>(i_userData);
+
+        m_submissionArray[index] = index;
+        __atomic_store_n(m_submissionTail, tail + 1, __ATOMIC_RELEASE);
+        m_unsubmittedCount++;
+    }
+
+    // Hands every prepared read to the kernel in one call and sleeps until at least one completed
+    void SubmitAndWait()
+    {
+        while (true)
+        {
+            const int result = static_cast<int>(syscall(__NR_io_uring_enter, m_ring, m_unsubmittedCount, 1, IORING_ENTER_GETEVENTS, nullptr, 0));
+            if (result >= 0)
+            {
+                m_unsubmittedCount -= static_cast<uint32_t>(result);
+                return;
+            }
+            if (errno != EINTR) {
+                throw std::runtime_error("failed to submit reads to io_uring!");
+            }
+        }
+    }
+
+    // i_function(userData, result) for every completion, result is the byte count or -errno
+    template<typename Function>
+    void ForEachCompletion(const Function& i_function)
+    {
+        uint32_t head = *m_completionHead;
+        const uint32_t tail = __atomic_load_n(m_completionTail, __ATOMIC_ACQUIRE);
+        while (head != tail)
+        {
+            const io_uring_cqe& completion = m_completions[head & m_completionMask];
+            void* userData = reinterpret_cast<void*>(completion.user_data);
+            const int32_t result = completion.res;
+
+            // Released before the callback, it may prepare a new read
+            head++;
+            __atomic_store_n(m_completionHead, head, __ATOMIC_RELEASE);
+            i_function(userData, result);
+        }
+    }
+
+private:
+    IoUring() = default;
+
+private:
+    int m_ring = -1;
+    uint32_t m_unsubmittedCount = 0;
+
+    char* m_submissionRing = nullptr;
+    size_t m_submissionRingSize = 0;
+    uint32_t* m_submissionTail = nullptr;
+    uint32_t m_submissionMask = 0;
+    uint32_t* m_submissionArray = nullptr;
+    io_uring_sqe* m_entries = nullptr;
+    size_t m_entriesSize = 0;
+
+    char* m_completionRing = nullptr;
+    size_t m_completionRingSize = 0;
+    uint32_t* m_completionHead = nullptr;
+    uint32_t* m_completionTail = nullptr;
+    uint32_t m_completionMask = 0;
+    io_uring_cqe* m_completions = nullptr;
+};
+
+#else
+
+class AsyncFileReader::IoUring {
+};
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+AsyncFileReader::AsyncFileReader(Backend i_preferredBackend)
+    : m_backend(Backend::ThreadPool)
+    , m_exiting(false)
+{
+#if defined(__linux__)
+    if (i_preferredBackend == Backend::IoUring)
+    {
+        m_ioUring = IoUring::Create(k_ioUringQueueDepth);
+    }
+#endif
+
+    if (m_ioUring != nullptr)
+    {
+        // One thread is enough, it only submits and reaps
+        m_backend = Backend::IoUring;
+        m_threads.emplace_back(&AsyncFileReader::IoUringMain, this);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < k_threadPoolThreadCount; i++)
+        {
+            m_threads.emplace_back(&AsyncFileReader::ThreadPoolMain, this);
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+AsyncFileReader::~AsyncFileReader()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_exiting = true;
+    }
+    m_readsQueued.notify_all();
+
+    for (std::thread& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void AsyncFileReader::Read(const Request& i_request, ReadCallback i_callback)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back({ i_request, std::move(i_callback) });
+    }
+    m_readsQueued.notify_one();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+std::future<std::vector<char>> AsyncFileReader::Read(const Request& i_request)
+{
+    std::vector<std::future<std::vector<char>>> futures = Read(std::vector<Request>{ i_request });
+    return std::move(futures[0]);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+std::vector<std::future<std::vector<char>>> AsyncFileReader::Read(const std::vector<Request>& i_requests)
+{
+    std::vector<std::future<std::vector<char>>> futures;
+    futures.reserve(i_requests.size());
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const Request& request : i_requests)
+        {
+            // std::function needs a copyable callable, the promise is shared with it
+            std::shared_ptr<std::promise<std::vector<char>>> promise = std::make_shared<std::promise<std::vector<char>>>();
+            futures.push_back(promise->get_future());
+
+            m_queue.push_back({ request, [promise](Result& io_result) {
+                if (io_result.error)
+                {
+                    promise->set_exception(io_result.error);
+                }
+                else
+                {
+                    promise->set_value(std::move(io_result.data));
+                }
+            } });
+        }
+    }
+    m_readsQueued.notify_all();
+
+    return futures;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool AsyncFileReader::WaitForReads(std::deque<PendingRead>& o_reads, size_t i_maxCount, bool i_block)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (i_block)
+    {
+        m_readsQueued.wait(lock, [this]() { return !m_queue.empty() || m_exiting; });
+    }
+
+    while (!m_queue.empty() && o_reads.size() < i_maxCount)
+    {
+        o_reads.push_back(std::move(m_queue.front()));
+        m_queue.pop_front();
+    }
+
+    return !o_reads.empty() || !m_exiting;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void AsyncFileReader::ThreadPoolMain()
+{
+    std::deque<PendingRead> reads;
+    while (WaitForReads(reads, 1, true))
+    {
+        PendingRead& read = reads.front();
+
+        Result result;
+        try
+        {
+            result.data = ReadRange(read.request);
+        }
+        catch (...)
+        {
+            result.error = std::current_exception();
+        }
+
+        read.callback(result);
+        reads.clear();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void AsyncFileReader::IoUringMain()
+{
+#if defined(__linux__)
+    struct InFlightRead
+    {
+        PendingRead pending;
+        Result result;
+        int file = -1;
+        uint64_t completed = 0;
+        iovec vector{};
+    };
+
+    // The file is opened here, only the data transfer goes through the ring
+    auto prepare = [this](InFlightRead& io_read) {
+        io_read.vector.iov_base = io_read.result.data.data() + io_read.completed;
+        io_read.vector.iov_len = io_read.result.data.size() - io_read.completed;
+        m_ioUring->PrepareRead(io_read.file, io_read.vector, io_read.pending.request.offset + io_read.completed, &io_read);
+    };
+
+    auto complete = [](InFlightRead& io_read) {
+        if (io_read.file >= 0)
+        {
+            close(io_read.file);
+        }
+        io_read.pending.callback(io_read.result);
+    };
+
+    std::deque<PendingRead> reads;
+    uint32_t inFlightCount = 0;
+    while (true)
+    {
+        // Only sleeps when nothing is in flight, otherwise the wait happens in io_uring_enter
+        const bool hasReads = WaitForReads(reads, k_ioUringQueueDepth - inFlightCount, inFlightCount == 0);
+        if (!hasReads && inFlightCount == 0)
+        {
+            break;
+        }
+
+        for (PendingRead& pending : reads)
+        {
+            std::unique_ptr<InFlightRead> read = std::make_unique<InFlightRead>();
+            read->pending = std::move(pending);
+
+            try
+            {
+                uint64_t size = 0;
+                read->file = OpenRange(read->pending.request, size);
+                read->result.data.resize(static_cast<size_t>(size));
+            }
+            catch (...)
+            {
+                read->result.error = std::current_exception();
+            }
+
+            if (read->result.error || read->result.data.empty())
+            {
+                complete(*read);
+                continue;
+            }
+
+            prepare(*read);
+            read.release();
+            inFlightCount++;
+        }
+        reads.clear();
+
+        if (inFlightCount == 0)
+        {
+            continue;
+        }
+
+        m_ioUring->SubmitAndWait();
+        m_ioUring->ForEachCompletion([&](void* i_userData, int32_t i_result) {
+            std::unique_ptr<InFlightRead> read(static_cast<InFlightRead*>(i_userData));
+
+            if (i_result > 0)
+            {
+                // Short reads happen for very large ranges, the rest goes back into the ring
+                read->completed += static_cast<uint64_t>(i_result);
+                if (read->completed < read->result.data.size())
+                {
+                    prepare(*read);
+                    read.release();
+                    return;
+                }
+            }
+            else if (i_result == -EINTR || i_result == -EAGAIN)
+            {
+                prepare(*read);
+                read.release();
+                return;
+            }
+            else
+            {
+                read->result.data.clear();
+                read->result.error = std::make_exception_ptr(std::runtime_error("failed to read file!"));
+            }
+
+            complete(*read);
+            inFlightCount--;
+        });
+    }
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
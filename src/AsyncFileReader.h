@@ -0,0 +1,80 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+
+///////////////////////////////////////////////////////////////////////////////
+// Reads file ranges in the background. On Linux every queued read is batched into one io_uring
+// submission, elsewhere or when io_uring is not available a few threads issue blocking positional reads.
+// Callbacks run on the reader's own threads, they must be short and must not throw.
+class AsyncFileReader {
+///////////////////////////////////////////////////////////////////////////////
+public:
+    enum class Backend
+    {
+        IoUring,
+        ThreadPool,
+    };
+
+    struct Request
+    {
+        std::string fileName;
+        uint64_t offset = 0;
+        // 0 reads up to the end of the file
+        uint64_t size = 0;
+    };
+
+    struct Result
+    {
+        std::vector<char> data;
+        // Set instead of data when the read failed
+        std::exception_ptr error;
+    };
+
+    using ReadCallback = std::function<void(Result& io_result)>;
+
+    // i_preferredBackend falls back to the thread pool when io_uring can't be set up
+    AsyncFileReader(Backend i_preferredBackend = Backend::IoUring);
+    // Finishes every queued read before returning
+    ~AsyncFileReader();
+
+    void Read(const Request& i_request, ReadCallback i_callback);
+    std::future<std::vector<char>> Read(const Request& i_request);
+    // Queues the whole batch at once so it goes out in a single submission
+    std::vector<std::future<std::vector<char>>> Read(const std::vector<Request>& i_requests);
+
+    Backend GetBackend()
+    {
+        return m_backend;
+    }
+
+private:
+    struct PendingRead
+    {
+        Request request;
+        ReadCallback callback;
+    };
+
+    class IoUring;
+
+    void IoUringMain();
+    void ThreadPoolMain();
+    // Blocks until reads are queued, false once the reader is exiting and the queue is drained
+    bool WaitForReads(std::deque<PendingRead>& o_reads, size_t i_maxCount, bool i_block);
+
+private:
+    Backend m_backend;
+    std::unique_ptr<IoUring> m_ioUring;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_readsQueued;
+    std::deque<PendingRead> m_queue;
+    bool m_exiting;
+};
+///////////////////////////////////////////////////////////////////////////////
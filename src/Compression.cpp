@@ -0,0 +1,196 @@
+#include "stdafx.h"
+#include "Compression.h"
+
+#include <algorithm>
+#include <cstring>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+    // Every sequence is [token][literal length ext][literals][offset][match length ext],
+    // the token holds 4 bits of literal length and 4 bits of match length - k_minMatch
+    constexpr size_t k_minMatch = 4;
+    constexpr size_t k_maxOffset = 0xFFFF;
+    constexpr uint32_t k_hashBits = 16;
+
+    uint32_t Read32(const unsigned char* i_data)
+    {
+        uint32_t value;
+        memcpy(&value, i_data, sizeof(value));
+        return value;
+    }
+
+    uint32_t Hash(uint32_t i_sequence)
+    {
+        return (i_sequence * 2654435761u) >> (32 - k_hashBits);
+    }
+
+    // Lengths of 15 and more spill into 255-valued bytes
+    void WriteLength(std::vector<char>& io_output, size_t i_length)
+    {
+        while (i_length >= 255)
+        {
+            io_output.push_back(static_cast<char>(255));
+            i_length -= 255;
+        }
+        io_output.push_back(static_cast<char>(i_length));
+    }
+
+    void WriteSequence(std::vector<char>& io_output, const unsigned char* i_literals, size_t i_literalLength, size_t i_offset, size_t i_matchLength)
+    {
+        const size_t matchCode = i_matchLength != 0 ? i_matchLength - k_minMatch : 0;
+        const unsigned char token = static_cast<unsigned char>((std::min<size_t>(i_literalLength, 15) << 4) | std::min<size_t>(matchCode, 15));
+        io_output.push_back(static_cast<char>(token));
+
+        if (i_literalLength >= 15)
+        {
+            WriteLength(io_output, i_literalLength - 15);
+        }
+        io_output.insert(io_output.end(), reinterpret_cast<const char*>(i_literals), reinterpret_cast<const char*>(i_literals) + i_literalLength);
+
+        // The last sequence ends the block with literals only
+        if (i_matchLength == 0)
+        {
+            return;
+        }
+
+        io_output.push_back(static_cast<char>(i_offset & 0xFF));
+        io_output.push_back(static_cast<char>(i_offset >> 8));
+        if (matchCode >= 15)
+        {
+            WriteLength(io_output, matchCode - 15);
+        }
+    }
+
+    size_t ReadLength(const unsigned char*& io_input, const unsigned char* i_end, size_t i_length)
+    {
+        if (i_length != 15)
+        {
+            return i_length;
+        }
+
+        unsigned char byte;
+        do
+        {
+            if (io_input >= i_end) {
+                throw std::runtime_error("failed to decompress, truncated length!");
+            }
+            byte = *io_input++;
+            i_length += byte;
+        } while (byte == 255);
+        return i_length;
+    }
+}
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Compression
+{
+///////////////////////////////////////////////////////////////////////////////
+
+size_t GetMaxCompressedSize(size_t i_size)
+{
+    // All literals: one token plus one length byte per 255 bytes
+    return i_size + i_size / 255 + 16;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+std::vector<char> Compress(const char* i_data, size_t i_size)
+{
+    std::vector<char> output;
+    output.reserve(GetMaxCompressedSize(i_size));
+
+    const unsigned char* input = reinterpret_cast<const unsigned char*>(i_data);
+    // Positions + 1 of the last occurrence of each hashed 4 byte sequence, 0 is empty
+    std::vector<uint32_t> table(size_t(1) << k_hashBits, 0);
+
+    size_t literalStart = 0;
+    size_t position = 0;
+    while (i_size >= k_minMatch && position <= i_size - k_minMatch)
+    {
+        const uint32_t sequence = Read32(input + position);
+        uint32_t& slot = table[Hash(sequence)];
+        const size_t candidate = slot;
+        slot = static_cast<uint32_t>(position + 1);
+
+        if (candidate == 0 || position - (candidate - 1) > k_maxOffset || Read32(input + candidate - 1) != sequence)
+        {
+            position++;
+            continue;
+        }
+
+        const size_t matchStart = candidate - 1;
+        size_t matchLength = k_minMatch;
+        while (position + matchLength < i_size && input[matchStart + matchLength] == input[position + matchLength])
+        {
+            matchLength++;
+        }
+
+        WriteSequence(output, input + literalStart, position - literalStart, position - matchStart, matchLength);
+        position += matchLength;
+        literalStart = position;
+    }
+
+    WriteSequence(output, input + literalStart, i_size - literalStart, 0, 0);
+    return output;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Decompress(const char* i_data, size_t i_size, char* o_data, size_t i_uncompressedSize)
+{
+    // An empty entry has no destination to write to, not even the zero literals of its single token
+    if (i_uncompressedSize == 0)
+    {
+        return;
+    }
+
+    const unsigned char* input = reinterpret_cast<const unsigned char*>(i_data);
+    const unsigned char* inputEnd = input + i_size;
+    unsigned char* output = reinterpret_cast<unsigned char*>(o_data);
+    unsigned char* outputEnd = output + i_uncompressedSize;
+
+    while (input < inputEnd)
+    {
+        const unsigned char token = *input++;
+
+        const size_t literalLength = ReadLength(input, inputEnd, token >> 4);
+        if (literalLength > static_cast<size_t>(inputEnd - input) || literalLength > static_cast<size_t>(outputEnd - output)) {
+            throw std::runtime_error("failed to decompress, literals out of bounds!");
+        }
+        memcpy(output, input, literalLength);
+        input += literalLength;
+        output += literalLength;
+
+        if (input == inputEnd)
+        {
+            break;
+        }
+
+        if (inputEnd - input < 2) {
+            throw std::runtime_error("failed to decompress, truncated offset!");
+        }
+        const size_t offset = input[0] | (static_cast<size_t>(input[1]) << 8);
+        input += 2;
+
+        const size_t matchLength = ReadLength(input, inputEnd, token & 0x0F) + k_minMatch;
+        if (offset == 0 || offset > static_cast<size_t>(output - reinterpret_cast<unsigned char*>(o_data)) || matchLength > static_cast<size_t>(outputEnd - output)) {
+            throw std::runtime_error("failed to decompress, match out of bounds!");
+        }
+
+        // Byte by byte, a match may overlap the bytes it produces
+        const unsigned char* match = output - offset;
+        for (size_t i = 0; i < matchLength; i++)
+        {
+            output[i] = match[i];
+        }
+        output += matchLength;
+    }
+
+    if (output != outputEnd) {
+        throw std::runtime_error("failed to decompress, size mismatch!");
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} //namespace Compression
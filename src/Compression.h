@@ -0,0 +1,16 @@
+#pragma once
+
+///////////////////////////////////////////////////////////////////////////////
+// Byte-oriented LZ77 in the LZ4 block layout: fast to decode, no entropy coding.
+// Meant for assets packed offline and unpacked at load time.
+namespace Compression
+{
+    // Worst case output for i_size input bytes
+    size_t GetMaxCompressedSize(size_t i_size);
+
+    std::vector<char> Compress(const char* i_data, size_t i_size);
+
+    // o_data must be exactly the uncompressed size, throws on corrupt input
+    void Decompress(const char* i_data, size_t i_size, char* o_data, size_t i_uncompressedSize);
+}
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,224 @@
+#include "stdafx.h"
+#include "CpuTrace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <sstream>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Event {
+        const char* name;
+        Clock::time_point start;
+        Clock::time_point end;
+    };
+
+    // Written by its thread only, readers see the events below the published count
+    struct Block {
+        uint32_t threadId = 0;
+        std::unique_ptr<Event[]> events;
+        std::atomic<uint32_t> count{ 0 };
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        // Blocks running threads are writing to
+        std::vector<Block*> activeBlocks;
+        // Full blocks and the last block of every thread that ended, kept for the export
+        std::vector<std::unique_ptr<Block>> completedBlocks;
+        uint32_t blockCount = 0;
+        uint32_t threadCount = 0;
+    };
+
+    Registry& GetRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // The block of the calling thread, handed to the registry when the thread ends
+    struct ThreadState {
+        uint32_t threadId = 0;
+        bool registered = false;
+        // Null once k_maxBlocks is reached
+        std::unique_ptr<Block> block;
+
+        ~ThreadState()
+        {
+            if (block == nullptr)
+            {
+                return;
+            }
+
+            Registry& registry = GetRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.activeBlocks.erase(std::find(registry.activeBlocks.begin(), registry.activeBlocks.end(), block.get()));
+            registry.blockCount--;
+
+            // Only the recorded part is kept, the rest of the block goes back to the heap
+            const uint32_t count = block->count.load(std::memory_order_relaxed);
+            if (count != 0)
+            {
+                std::unique_ptr<Event[]> events = std::make_unique<Event[]>(count);
+                std::copy(block->events.get(), block->events.get() + count, events.get());
+                block->events = std::move(events);
+                registry.completedBlocks.push_back(std::move(block));
+            }
+        }
+    };
+
+    std::atomic<bool> g_recording{ false };
+    std::atomic<int64_t> g_startTicks{ 0 };
+    std::atomic<uint64_t> g_droppedCount{ 0 };
+    thread_local ThreadState t_state;
+
+    // Retires the full block of io_state, if any, and starts a new one while the limit allows
+    Block* AcquireBlock(ThreadState& io_state)
+    {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        if (!io_state.registered)
+        {
+            io_state.threadId = registry.threadCount++;
+            io_state.registered = true;
+        }
+
+        if (io_state.block != nullptr)
+        {
+            registry.activeBlocks.erase(std::find(registry.activeBlocks.begin(), registry.activeBlocks.end(), io_state.block.get()));
+            registry.completedBlocks.push_back(std::move(io_state.block));
+            registry.blockCount--;
+        }
+
+        // Completed blocks stay until exit, the limit counts them too
+        if (registry.blockCount + registry.completedBlocks.size() >= CpuTrace::k_maxBlocks)
+        {
+            return nullptr;
+        }
+
+        io_state.block = std::make_unique<Block>();
+        io_state.block->threadId = io_state.threadId;
+        io_state.block->events = std::make_unique<Event[]>(CpuTrace::k_eventsPerBlock);
+        registry.activeBlocks.push_back(io_state.block.get());
+        registry.blockCount++;
+        return io_state.block.get();
+    }
+
+    // Chrome traces count in microseconds
+    double ToMicroseconds(Clock::time_point i_time)
+    {
+        const Clock::time_point start(Clock::duration(g_startTicks.load(std::memory_order_relaxed)));
+        return std::chrono::duration<double, std::micro>(i_time - start).count();
+    }
+
+    void WriteEscaped(std::ostringstream& io_stream, const char* i_text)
+    {
+        for (const char* c = i_text; *c != '\0'; c++)
+        {
+            if (*c == '"' || *c == '\\')
+            {
+                io_stream << '\\';
+            }
+            io_stream << *c;
+        }
+    }
+}
+///////////////////////////////////////////////////////////////////////////////
+
+namespace CpuTrace
+{
+///////////////////////////////////////////////////////////////////////////////
+
+void Start()
+{
+    g_startTicks.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    g_recording.store(true, std::memory_order_release);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Stop()
+{
+    g_recording.store(false, std::memory_order_release);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool IsRecording()
+{
+    return g_recording.load(std::memory_order_relaxed);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Record(const char* i_name, Clock::time_point i_start, Clock::time_point i_end)
+{
+    Block* block = t_state.block.get();
+    if (!t_state.registered || (block != nullptr && block->count.load(std::memory_order_relaxed) == k_eventsPerBlock))
+    {
+        block = AcquireBlock(t_state);
+    }
+    if (block == nullptr)
+    {
+        g_droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    const uint32_t index = block->count.load(std::memory_order_relaxed);
+    block->events[index] = { i_name, i_start, i_end };
+    block->count.store(index + 1, std::memory_order_release);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+std::string ExportChromeTrace()
+{
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    std::ostringstream stream;
+    stream.setf(std::ios::fixed);
+    stream.precision(3);
+    stream << "{\"traceEvents\":[\n";
+
+    for (uint32_t threadId = 0; threadId < registry.threadCount; threadId++)
+    {
+        stream << (threadId == 0 ? "" : ",\n")
+            << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadId
+            << ",\"args\":{\"name\":\"thread " << threadId << "\"}}";
+    }
+
+    auto writeBlock = [&stream](const Block& i_block) {
+        const uint32_t count = i_block.count.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const Event& event = i_block.events[i];
+            stream << ",\n{\"name\":\"";
+            WriteEscaped(stream, event.name);
+            stream << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << i_block.threadId
+                << ",\"ts\":" << ToMicroseconds(event.start)
+                << ",\"dur\":" << std::chrono::duration<double, std::micro>(event.end - event.start).count() << "}";
+        }
+    };
+    for (const std::unique_ptr<Block>& block : registry.completedBlocks)
+    {
+        writeBlock(*block);
+    }
+    for (const Block* block : registry.activeBlocks)
+    {
+        writeBlock(*block);
+    }
+    const uint64_t droppedCount = g_droppedCount.load(std::memory_order_relaxed);
+
+    stream << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedZones\":" << droppedCount << "}}\n";
+    return stream.str();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} //namespace CpuTrace
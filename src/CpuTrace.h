@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Build with CPU_TRACE_ENABLED=0 (premake5 --no-cpu-trace) and every CPU_TRACE_ZONE expands to nothing
+#if !defined(CPU_TRACE_ENABLED)
+#define CPU_TRACE_ENABLED 1
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Scoped CPU zones written to blocks owned by the recording thread, exported in the Chrome trace event
+// format (Perfetto, chrome://tracing). Only the owning thread writes a block and publishes its count
+// with a release store, so recording takes no lock. A full block is handed to a shared list under a lock
+// and the thread continues in a new one, the last block is handed over when the thread ends.
+// Until Start is called a zone costs one relaxed load.
+namespace CpuTrace
+{
+    // Zones per block
+    constexpr uint32_t k_eventsPerBlock = 16 * 1024;
+    // Blocks alive at once, 8M zones or 192 MiB, later zones are dropped and counted
+    constexpr uint32_t k_maxBlocks = 512;
+
+    // Zones from now on are recorded, timestamps are relative to this call
+    void Start();
+    void Stop();
+    bool IsRecording();
+
+    // Every zone recorded so far as a JSON document, zones still open are left out
+    std::string ExportChromeTrace();
+
+    // i_name must outlive the export, pass a string literal
+    void Record(const char* i_name, std::chrono::steady_clock::time_point i_start, std::chrono::steady_clock::time_point i_end);
+
+    ///////////////////////////////////////////////////////////////////////////
+    class Zone {
+    public:
+        explicit Zone(const char* i_name)
+            : m_name(IsRecording() ? i_name : nullptr)
+        {
+            if (m_name != nullptr)
+            {
+                m_start = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~Zone()
+        {
+            if (m_name != nullptr)
+            {
+                Record(m_name, m_start, std::chrono::steady_clock::now());
+            }
+        }
+
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+
+    private:
+        const char* m_name;
+        std::chrono::steady_clock::time_point m_start;
+    };
+} //namespace CpuTrace
+///////////////////////////////////////////////////////////////////////////////
+
+#if CPU_TRACE_ENABLED
+#define CPU_TRACE_CONCAT_INNER(a, b) a##b
+#define CPU_TRACE_CONCAT(a, b) CPU_TRACE_CONCAT_INNER(a, b)
+// Times the rest of the enclosing block, i_name must be a string literal
+#define CPU_TRACE_ZONE(i_name) CpuTrace::Zone CPU_TRACE_CONCAT(cpuTraceZone, __LINE__)(i_name)
+#else
+#define CPU_TRACE_ZONE(i_name)
+#endif
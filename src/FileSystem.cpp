@@ -1,6 +1,8 @@
 #include "stdafx.h"
 #include "FileSystem.h"
 
+#include "CpuTrace.h"
+
 #include <fstream>
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -17,8 +19,52 @@ FileSystem::~FileSystem()
 
 ///////////////////////////////////////////////////////////////////////////////
 
+void FileSystem::Mount(const std::string& i_archiveFileName)
+{
+    m_archives.push_back(std::make_unique<AssetArchive>(i_archiveFileName));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+const AssetArchive::TocEntry* FileSystem::FindArchived(const std::string& i_fileName, const AssetArchive*& o_archive)
+{
+    for (auto it = m_archives.rbegin(); it != m_archives.rend(); ++it)
+    {
+        if (const AssetArchive::TocEntry* entry = (*it)->Find(i_fileName))
+        {
+            o_archive = it->get();
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool FileSystem::FileExists(const std::string& i_fileName)
+{
+    const AssetArchive* archive = nullptr;
+    if (FindArchived(i_fileName, archive) != nullptr)
+    {
+        return true;
+    }
+
+    std::ifstream file(i_fileName, std::ios::binary);
+    return file.is_open();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 std::vector<char> FileSystem::ReadFile(const std::string& i_fileName)
 {
+    CPU_TRACE_ZONE("FileSystem::ReadFile");
+
+    const AssetArchive* archive = nullptr;
+    if (const AssetArchive::TocEntry* entry = FindArchived(i_fileName, archive))
+    {
+        return archive->Read(*entry);
+    }
+
     std::ifstream file(i_fileName, std::ios::ate | std::ios::binary);
 
     if (!file.is_open()) {
@@ -36,4 +82,154 @@ std::vector<char> FileSystem::ReadFile(const std::string& i_fileName)
     return buffer;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+
+MappedFile FileSystem::MapFile(const std::string& i_fileName, FileAccess i_access)
+{
+    const AssetArchive* archive = nullptr;
+    if (const AssetArchive::TocEntry* entry = FindArchived(i_fileName, archive))
+    {
+        return archive->Map(*entry);
+    }
+
+    return MappedFile(i_fileName, i_access);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void FileSystem::WriteFile(const std::string& i_fileName, const std::vector<char>& i_data)
+{
+    std::ofstream file(i_fileName, std::ios::binary | std::ios::trunc);
+
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open file for writing!");
+    }
+
+    file.write(i_data.data(), i_data.size());
+
+    if (!file.good()) {
+        throw std::runtime_error("failed to write file!");
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+std::future<std::vector<char>> FileSystem::ReadFileAsync(const std::string& i_fileName, uint64_t i_offset, uint64_t i_size)
+{
+    AsyncFileReader::Request request;
+    request.fileName = i_fileName;
+    request.offset = i_offset;
+    request.size = i_size;
+
+    std::vector<std::future<std::vector<char>>> futures = ReadFilesAsync({ request });
+    return std::move(futures[0]);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+std::vector<std::future<std::vector<char>>> FileSystem::ReadFilesAsync(const std::vector<AsyncFileReader::Request>& i_requests)
+{
+    if (m_archives.empty())
+    {
+        return GetAsyncReader().Read(i_requests);
+    }
+
+    std::vector<std::future<std::vector<char>>> futures(i_requests.size());
+    std::vector<AsyncFileReader::Request> diskRequests;
+    std::vector<size_t> diskIndices;
+
+    for (size_t i = 0; i < i_requests.size(); i++)
+    {
+        AsyncFileReader::Request request = i_requests[i];
+        std::promise<std::vector<char>> promise;
+        try
+        {
+            std::vector<char> data;
+            if (ResolveArchivedRead(request, data))
+            {
+                diskRequests.push_back(std::move(request));
+                diskIndices.push_back(i);
+                continue;
+            }
+            promise.set_value(std::move(data));
+        }
+        catch (...)
+        {
+            promise.set_exception(std::current_exception());
+        }
+        futures[i] = promise.get_future();
+    }
+
+    std::vector<std::future<std::vector<char>>> diskFutures = GetAsyncReader().Read(diskRequests);
+    for (size_t i = 0; i < diskFutures.size(); i++)
+    {
+        futures[diskIndices[i]] = std::move(diskFutures[i]);
+    }
+    return futures;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void FileSystem::ReadFileAsync(const AsyncFileReader::Request& i_request, AsyncFileReader::ReadCallback i_callback)
+{
+    AsyncFileReader::Request request = i_request;
+    AsyncFileReader::Result result;
+    try
+    {
+        if (ResolveArchivedRead(request, result.data))
+        {
+            GetAsyncReader().Read(request, std::move(i_callback));
+            return;
+        }
+    }
+    catch (...)
+    {
+        result.error = std::current_exception();
+    }
+    i_callback(result);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool FileSystem::ResolveArchivedRead(AsyncFileReader::Request& io_request, std::vector<char>& o_data)
+{
+    const AssetArchive* archive = nullptr;
+    const AssetArchive::TocEntry* entry = FindArchived(io_request.fileName, archive);
+    if (entry == nullptr)
+    {
+        return true;
+    }
+
+    if (io_request.offset > entry->size || io_request.size > entry->size - io_request.offset) {
+        throw std::runtime_error("failed to read past the end of file!");
+    }
+    const uint64_t size = io_request.size != 0 ? io_request.size : entry->size - io_request.offset;
+
+    if (entry->compression == AssetArchiveFormat::EntryCompression::None)
+    {
+        io_request.fileName = archive->GetFileName();
+        io_request.offset += entry->offset;
+        io_request.size = size;
+        // A size of 0 would read to the end of the archive
+        if (size != 0)
+        {
+            return true;
+        }
+        o_data.clear();
+        return false;
+    }
+
+    std::vector<char> data = archive->Read(*entry);
+    o_data.assign(data.begin() + static_cast<ptrdiff_t>(io_request.offset), data.begin() + static_cast<ptrdiff_t>(io_request.offset + size));
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+AsyncFileReader& FileSystem::GetAsyncReader()
+{
+    std::call_once(m_asyncReaderCreated, [this]() { m_asyncReader = std::make_unique<AsyncFileReader>(); });
+    return *m_asyncReader;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
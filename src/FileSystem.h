@@ -1,12 +1,44 @@
 #pragma once
 
+#include "AssetArchive.h"
+#include "AsyncFileReader.h"
+#include "MappedFile.h"
+
 class FileSystem {
 ///////////////////////////////////////////////////////////////////////////////
 public:
     FileSystem();
     ~FileSystem();
 
+    // Paths found in a mounted archive are served from it, later mounts win, anything else comes from disk.
+    // Writes always go to disk.
+    void Mount(const std::string& i_archiveFileName);
+
+    bool FileExists(const std::string& i_fileName);
     std::vector<char> ReadFile(const std::string& i_fileName);
+    // Zero-copy alternative to ReadFile, the data is only valid while the returned MappedFile lives
+    MappedFile MapFile(const std::string& i_fileName, FileAccess i_access = FileAccess::Sequential);
+    void WriteFile(const std::string& i_fileName, const std::vector<char>& i_data);
+
+    // Non-blocking reads, a batch is queued at once so the backend can overlap all of it
+    std::future<std::vector<char>> ReadFileAsync(const std::string& i_fileName, uint64_t i_offset = 0, uint64_t i_size = 0);
+    std::vector<std::future<std::vector<char>>> ReadFilesAsync(const std::vector<AsyncFileReader::Request>& i_requests);
+    // Archived entries that are compressed complete on the calling thread, before this returns
+    void ReadFileAsync(const AsyncFileReader::Request& i_request, AsyncFileReader::ReadCallback i_callback);
+
+private:
+    const AssetArchive::TocEntry* FindArchived(const std::string& i_fileName, const AssetArchive*& o_archive);
+    // Turns a read of a stored archive entry into a read of the archive file and returns true.
+    // Compressed entries can't be read in place, they are unpacked into o_data and it returns false.
+    bool ResolveArchivedRead(AsyncFileReader::Request& io_request, std::vector<char>& o_data);
+
+    // Started on the first async read
+    AsyncFileReader& GetAsyncReader();
+
+private:
+    std::once_flag m_asyncReaderCreated;
+    std::unique_ptr<AsyncFileReader> m_asyncReader;
+    std::vector<std::unique_ptr<AssetArchive>> m_archives;
 
 ///////////////////////////////////////////////////////////////////////////////
 };
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "stdafx.h"
+#include "FileWatcher.h"
+
+#include <algorithm>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(__linux__)
+
+FileWatcher::FileWatcher(const std::string& i_directory)
+    : m_directory(i_directory)
+    , m_inotify(-1)
+{
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotify < 0) {
+        throw std::runtime_error("failed to create file watcher!");
+    }
+
+    // Close after write means the writer is done, a rename into the directory is how most tools save atomically
+    if (inotify_add_watch(m_inotify, m_directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(m_inotify);
+        throw std::runtime_error("failed to watch directory!");
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+FileWatcher::~FileWatcher()
+{
+    // Closing the descriptor removes the watch
+    close(m_inotify);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+std::vector<std::string> FileWatcher::PollChanges()
+{
+    std::vector<std::string> changes;
+
+    alignas(inotify_event) char buffer[4096];
+    while (true)
+    {
+        const ssize_t size = read(m_inotify, buffer, sizeof(buffer));
+        if (size <= 0)
+        {
+            // EAGAIN, nothing more queued
+            break;
+        }
+
+        for (ssize_t offset = 0; offset < size; )
+        {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if (event->len > 0)
+            {
+                changes.push_back(event->name);
+            }
+            offset += sizeof(inotify_event) + event->len;
+        }
+    }
+
+    // Saving a file can produce several events
+    std::sort(changes.begin(), changes.end());
+    changes.erase(std::unique(changes.begin(), changes.end()), changes.end());
+    return changes;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+#else
+
+FileWatcher::FileWatcher(const std::string& i_directory)
+    : m_directory(i_directory)
+    , m_lastPoll(std::chrono::steady_clock::now())
+{
+    if (!std::filesystem::is_directory(m_directory)) {
+        throw std::runtime_error("failed to watch directory!");
+    }
+
+    // Starting point, only later writes are reported
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(m_directory))
+    {
+        if (entry.is_regular_file())
+        {
+            m_writeTimes[entry.path().filename().string()] = entry.last_write_time();
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+FileWatcher::~FileWatcher()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+std::vector<std::string> FileWatcher::PollChanges()
+{
+    std::vector<std::string> changes;
+
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (now - m_lastPoll < k_pollInterval)
+    {
+        return changes;
+    }
+    m_lastPoll = now;
+
+    std::error_code error;
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(m_directory, error))
+    {
+        if (!entry.is_regular_file(error))
+        {
+            continue;
+        }
+
+        const std::string name = entry.path().filename().string();
+        const std::filesystem::file_time_type writeTime = entry.last_write_time(error);
+        auto it = m_writeTimes.find(name);
+        if (it == m_writeTimes.end() || it->second != writeTime)
+        {
+            m_writeTimes[name] = writeTime;
+            changes.push_back(name);
+        }
+    }
+    return changes;
+}
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
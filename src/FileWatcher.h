@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+
+///////////////////////////////////////////////////////////////////////////////
+// Reports files of one directory that were written to. Uses inotify on Linux, elsewhere the directory
+// is rescanned for new modification times at most every k_pollInterval. Polling never blocks.
+class FileWatcher {
+///////////////////////////////////////////////////////////////////////////////
+public:
+    // Throws when the directory can't be watched
+    FileWatcher(const std::string& i_directory);
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // File names, without the directory, finished writing since the last call
+    std::vector<std::string> PollChanges();
+
+    const std::string& GetDirectory() const
+    {
+        return m_directory;
+    }
+
+private:
+    std::string m_directory;
+#if defined(__linux__)
+    int m_inotify;
+#else
+    static constexpr std::chrono::milliseconds k_pollInterval{ 250 };
+
+    std::map<std::string, std::filesystem::file_time_type> m_writeTimes;
+    std::chrono::steady_clock::time_point m_lastPoll;
+#endif
+};
+///////////////////////////////////////////////////////////////////////////////
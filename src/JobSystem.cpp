@@ -0,0 +1,486 @@
+#include "stdafx.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+struct JobCounter::Job
+{
+    JobSystem::JobFunction function;
+    JobCounter* counter = nullptr;
+    JobSystem* system = nullptr;
+    // Pool of the thread that allocated the job, it goes back there once it ran
+    JobSystem::JobPool* pool = nullptr;
+    Job* next = nullptr;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+    using Job = JobCounter::Job;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Chase-Lev deque: the owner pushes and pops at the bottom, thieves take from the top
+    class WorkStealingDeque {
+    public:
+        static constexpr int64_t k_capacity = 4096;
+
+        WorkStealingDeque()
+            : m_top(0)
+            , m_bottom(0)
+        {
+            for (std::atomic<Job*>& slot : m_buffer)
+            {
+                slot.store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        // Owner only, false when full
+        bool Push(Job* i_job)
+        {
+            const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+            const int64_t top = m_top.load(std::memory_order_acquire);
+            if (bottom - top >= k_capacity)
+            {
+                return false;
+            }
+
+            m_buffer[bottom & (k_capacity - 1)].store(i_job, std::memory_order_release);
+            m_bottom.store(bottom + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Owner only
+        Job* Pop()
+        {
+            const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+            m_bottom.store(bottom, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t top = m_top.load(std::memory_order_relaxed);
+
+            if (top > bottom)
+            {
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            Job* job = m_buffer[bottom & (k_capacity - 1)].load(std::memory_order_relaxed);
+            if (top == bottom)
+            {
+                // Last element, race the thieves for it
+                if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                {
+                    job = nullptr;
+                }
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            }
+            return job;
+        }
+
+        // Any thread
+        Job* Steal()
+        {
+            int64_t top = m_top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+            if (top >= bottom)
+            {
+                return nullptr;
+            }
+
+            Job* job = m_buffer[top & (k_capacity - 1)].load(std::memory_order_acquire);
+            if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                return nullptr;
+            }
+            return job;
+        }
+
+    private:
+        // Own cache lines, the owner hammers bottom while thieves hammer top
+        alignas(64) std::atomic<int64_t> m_top;
+        alignas(64) std::atomic<int64_t> m_bottom;
+        std::atomic<Job*> m_buffer[k_capacity];
+    };
+
+    thread_local JobSystem* t_jobSystem = nullptr;
+    thread_local uint32_t t_threadIndex = 0;
+}
+///////////////////////////////////////////////////////////////////////////////
+
+// Finished jobs return to the pool of the thread that allocated them, wherever they ran. A thread
+// that only submits gets its jobs back and stops allocating once warm, and a pool never holds more
+// jobs than its thread had in flight at once.
+struct JobSystem::JobPool
+{
+    // Only touched by the owning thread
+    Job* free = nullptr;
+    // Pushed by any thread, the owner takes the whole list at once so popping has no ABA problem
+    alignas(64) std::atomic<Job*> returned{ nullptr };
+
+    ~JobPool()
+    {
+        DeleteList(free);
+        DeleteList(returned.load(std::memory_order_acquire));
+    }
+
+    // Owner only, null when the pool is empty
+    Job* Take()
+    {
+        if (free == nullptr)
+        {
+            free = returned.exchange(nullptr, std::memory_order_acquire);
+            if (free == nullptr)
+            {
+                return nullptr;
+            }
+        }
+
+        Job* job = free;
+        free = job->next;
+        job->next = nullptr;
+        return job;
+    }
+
+    // Any thread
+    void Return(Job* i_job)
+    {
+        i_job->next = returned.load(std::memory_order_relaxed);
+        while (!returned.compare_exchange_weak(i_job->next, i_job, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    static void DeleteList(Job* i_job)
+    {
+        while (i_job != nullptr)
+        {
+            Job* next = i_job->next;
+            delete i_job;
+            i_job = next;
+        }
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct JobSystem::Worker
+{
+    WorkStealingDeque deque;
+    JobPool jobPool;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+JobCounter::JobCounter()
+    : m_pending(0)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+JobCounter::~JobCounter()
+{
+    // The last decrement happens under the lock, wait until that thread is done touching us
+    std::lock_guard<std::mutex> lock(m_mutex);
+    assert(m_pending.load() == 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+JobSystem::JobSystem(uint32_t i_threadCount)
+    : m_threadCount(i_threadCount)
+    , m_queuedJobs(0)
+    , m_sleepingWorkers(0)
+    , m_exiting(false)
+    , m_previousSystem(nullptr)
+    , m_previousThreadIndex(0)
+{
+    if (m_threadCount == 0)
+    {
+        m_threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    m_workers = std::make_unique<Worker[]>(m_threadCount);
+    m_externalJobPool = std::make_unique<JobPool>();
+
+    // The constructing thread is worker 0, for as long as this system lives
+    m_previousSystem = t_jobSystem;
+    m_previousThreadIndex = t_threadIndex;
+    t_jobSystem = this;
+    t_threadIndex = 0;
+
+    m_threads.reserve(m_threadCount - 1);
+    for (uint32_t i = 1; i < m_threadCount; i++)
+    {
+        m_threads.emplace_back(&JobSystem::WorkerMain, this, i);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_exiting.store(true);
+    }
+    m_wakeUp.notify_all();
+
+    for (std::thread& thread : m_threads)
+    {
+        thread.join();
+    }
+
+    // Whatever was left in worker 0's deque
+    while (Job* job = FindJob())
+    {
+        Execute(job);
+    }
+
+    assert(t_jobSystem == this);
+    t_jobSystem = m_previousSystem;
+    t_threadIndex = m_previousThreadIndex;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::Run(JobFunction i_function, JobCounter* io_counter)
+{
+    Submit(AllocateJob(std::move(i_function), io_counter));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::RunAfter(JobCounter& i_dependency, JobFunction i_function, JobCounter* io_counter)
+{
+    Job* job = AllocateJob(std::move(i_function), io_counter);
+
+    {
+        std::lock_guard<std::mutex> lock(i_dependency.m_mutex);
+        if (i_dependency.m_pending.load(std::memory_order_acquire) != 0)
+        {
+            i_dependency.m_continuations.push_back(job);
+            return;
+        }
+    }
+
+    Submit(job);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::Wait(JobCounter& i_counter)
+{
+    while (!i_counter.IsDone())
+    {
+        if (Job* job = FindJob())
+        {
+            Execute(job);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::ParallelFor(uint32_t i_count, uint32_t i_grainSize, const RangeFunction& i_function)
+{
+    const uint32_t grainSize = std::max(1u, i_grainSize);
+
+    JobCounter counter;
+    for (uint32_t first = 0; first < i_count; first += grainSize)
+    {
+        const uint32_t count = std::min(grainSize, i_count - first);
+        Run([&i_function, first, count]() { i_function(first, count); }, &counter);
+    }
+    Wait(counter);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+uint32_t JobSystem::GetCurrentThreadIndex()
+{
+    assert(t_jobSystem == this);
+    return t_threadIndex;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+JobSystem::Job* JobSystem::AllocateJob(JobFunction i_function, JobCounter* i_counter)
+{
+    // Threads outside the system share one pool
+    const bool isMember = t_jobSystem == this;
+    JobPool& pool = isMember ? m_workers[t_threadIndex].jobPool : *m_externalJobPool;
+    std::unique_lock<std::mutex> externalLock;
+    if (!isMember)
+    {
+        externalLock = std::unique_lock<std::mutex>(m_externalJobPoolMutex);
+    }
+
+    Job* job = pool.Take();
+    if (job == nullptr)
+    {
+        job = new Job();
+    }
+    job->pool = &pool;
+
+    job->function = std::move(i_function);
+    job->counter = i_counter;
+    job->system = this;
+
+    if (i_counter != nullptr)
+    {
+        i_counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::Submit(Job* i_job)
+{
+    // Counted before it becomes visible so the count never drops below zero
+    m_queuedJobs.fetch_add(1, std::memory_order_seq_cst);
+
+    if (t_jobSystem == this)
+    {
+        if (!m_workers[t_threadIndex].deque.Push(i_job))
+        {
+            // Deque full, the submitting thread does the work itself
+            m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+            Execute(i_job);
+            return;
+        }
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(m_injectedMutex);
+        m_injectedJobs.push_back(i_job);
+    }
+
+    if (m_sleepingWorkers.load(std::memory_order_seq_cst) > 0)
+    {
+        // Taking the lock orders the notify after a worker that is about to wait
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+        }
+        m_wakeUp.notify_one();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+JobSystem::Job* JobSystem::FindJob()
+{
+    const bool isMember = t_jobSystem == this;
+    const uint32_t self = isMember ? t_threadIndex : 0;
+
+    Job* job = nullptr;
+    if (isMember)
+    {
+        job = m_workers[self].deque.Pop();
+    }
+
+    // Steal starting after ourselves so thieves spread over the victims
+    for (uint32_t i = 1; job == nullptr && i <= m_threadCount; i++)
+    {
+        const uint32_t victim = (self + i) % m_threadCount;
+        if (isMember && victim == self)
+        {
+            continue;
+        }
+        job = m_workers[victim].deque.Steal();
+    }
+
+    if (job == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(m_injectedMutex);
+        if (!m_injectedJobs.empty())
+        {
+            job = m_injectedJobs.front();
+            m_injectedJobs.pop_front();
+        }
+    }
+
+    if (job != nullptr)
+    {
+        m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::Execute(Job* i_job)
+{
+    // Jobs must not throw, an exception escaping a worker thread terminates
+    i_job->function();
+
+    JobCounter* counter = i_job->counter;
+    i_job->function = nullptr;
+    i_job->counter = nullptr;
+    // May be reused by its allocating thread right away, not touched after this
+    i_job->pool->Return(i_job);
+
+    if (counter == nullptr)
+    {
+        return;
+    }
+
+    // Only the decrement that may reach zero takes the lock, it has to hand over the continuations
+    uint32_t pending = counter->m_pending.load(std::memory_order_relaxed);
+    while (pending > 1)
+    {
+        if (counter->m_pending.compare_exchange_weak(pending, pending - 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+        {
+            return;
+        }
+    }
+
+    std::vector<Job*> continuations;
+    {
+        std::lock_guard<std::mutex> lock(counter->m_mutex);
+        if (counter->m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            continuations.swap(counter->m_continuations);
+        }
+    }
+
+    for (Job* continuation : continuations)
+    {
+        continuation->system->Submit(continuation);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::WorkerMain(uint32_t i_index)
+{
+    t_jobSystem = this;
+    t_threadIndex = i_index;
+
+    while (true)
+    {
+        if (Job* job = FindJob())
+        {
+            Execute(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        if (m_exiting.load())
+        {
+            break;
+        }
+
+        m_sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+        m_wakeUp.wait(lock, [this]() { return m_queuedJobs.load(std::memory_order_seq_cst) > 0 || m_exiting.load(); });
+        m_sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
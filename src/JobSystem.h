@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+class JobSystem;
+
+///////////////////////////////////////////////////////////////////////////////
+// Counts the unfinished jobs of a batch, Wait on it or use it as the dependency of later jobs
+class JobCounter {
+///////////////////////////////////////////////////////////////////////////////
+public:
+    JobCounter();
+    ~JobCounter();
+
+    bool IsDone() const
+    {
+        return m_pending.load(std::memory_order_acquire) == 0;
+    }
+
+    // Opaque, only JobSystem knows its layout
+    struct Job;
+
+private:
+    friend class JobSystem;
+
+    std::atomic<uint32_t> m_pending;
+    // Jobs started by RunAfter once m_pending drops to zero
+    std::mutex m_mutex;
+    std::vector<Job*> m_continuations;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Work-stealing scheduler: every worker pushes and pops its own lock-free deque at the bottom,
+// idle workers steal from the top of the others. The thread constructing the JobSystem is worker 0,
+// it only executes jobs while it waits. Jobs submitted from other threads go through a locked queue.
+class JobSystem {
+///////////////////////////////////////////////////////////////////////////////
+public:
+    using JobFunction = std::function<void()>;
+    // Processes [i_first, i_first + i_count)
+    using RangeFunction = std::function<void(uint32_t i_first, uint32_t i_count)>;
+
+    // i_threadCount counts the constructing thread, 0 uses one thread per core
+    JobSystem(uint32_t i_threadCount = 0);
+    ~JobSystem();
+
+    // io_counter, when given, is incremented now and decremented once the job has run
+    void Run(JobFunction i_function, JobCounter* io_counter = nullptr);
+    // Starts the job once i_dependency is done
+    void RunAfter(JobCounter& i_dependency, JobFunction i_function, JobCounter* io_counter = nullptr);
+    // Executes other jobs until i_counter is done
+    void Wait(JobCounter& i_counter);
+
+    // Splits [0, i_count) into ranges of i_grainSize, blocks until all ran
+    void ParallelFor(uint32_t i_count, uint32_t i_grainSize, const RangeFunction& i_function);
+
+    uint32_t GetThreadCount()
+    {
+        return m_threadCount;
+    }
+
+    // Index in [0, GetThreadCount()) of the calling thread, only valid on threads of this JobSystem
+    uint32_t GetCurrentThreadIndex();
+
+    // Recycles finished jobs, opaque outside JobSystem.cpp
+    struct JobPool;
+
+private:
+    struct Worker;
+    using Job = JobCounter::Job;
+
+    Job* AllocateJob(JobFunction i_function, JobCounter* i_counter);
+    void Submit(Job* i_job);
+    Job* FindJob();
+    void Execute(Job* i_job);
+    void WorkerMain(uint32_t i_index);
+
+private:
+    uint32_t m_threadCount;
+    std::unique_ptr<Worker[]> m_workers;
+    std::vector<std::thread> m_threads;
+
+    // Jobs allocated by threads that do not belong to this system
+    std::mutex m_externalJobPoolMutex;
+    std::unique_ptr<JobPool> m_externalJobPool;
+
+    // Jobs submitted from threads that do not belong to this system
+    std::mutex m_injectedMutex;
+    std::deque<Job*> m_injectedJobs;
+
+    // Jobs sitting in any queue, lets idle workers sleep instead of spinning
+    std::atomic<uint32_t> m_queuedJobs;
+    std::atomic<uint32_t> m_sleepingWorkers;
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wakeUp;
+    std::atomic<bool> m_exiting;
+
+    // Restored on destruction, systems may be nested on the constructing thread
+    JobSystem* m_previousSystem;
+    uint32_t m_previousThreadIndex;
+};
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,213 @@
+#include "stdafx.h"
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+#if !defined(_WIN32)
+    int ToAdvice(FileAccess i_access)
+    {
+        return i_access == FileAccess::Sequential ? MADV_SEQUENTIAL : MADV_RANDOM;
+    }
+#endif
+}
+///////////////////////////////////////////////////////////////////////////////
+
+MappedFile::MappedFile()
+    : m_data(nullptr)
+    , m_size(0)
+#if defined(_WIN32)
+    , m_mappingHandle(nullptr)
+#endif
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+MappedFile::MappedFile(std::shared_ptr<const void> i_owner, const char* i_data, size_t i_size)
+    : MappedFile()
+{
+    m_owner = std::move(i_owner);
+    m_data = i_size != 0 ? i_data : nullptr;
+    m_size = i_size;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(const std::string& i_fileName, FileAccess i_access)
+    : MappedFile()
+{
+    // Windows takes the access hint when the file is opened, not on the mapping
+    const DWORD flags = i_access == FileAccess::Sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS;
+    HANDLE file = CreateFileA(i_fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | flags, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("failed to open file!");
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        throw std::runtime_error("failed to get file size!");
+    }
+
+    // An empty file can't be mapped, it is an empty view
+    if (fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return;
+    }
+
+    // The mapping keeps the file open, the file handle is not needed past this point
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) {
+        throw std::runtime_error("failed to map file!");
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr) {
+        CloseHandle(mapping);
+        throw std::runtime_error("failed to map file!");
+    }
+
+    m_data = static_cast<const char*>(data);
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+    m_mappingHandle = mapping;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& i_fileName, FileAccess i_access)
+    : MappedFile()
+{
+    int file = open(i_fileName.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) {
+        throw std::runtime_error("failed to open file!");
+    }
+
+    struct stat fileStat;
+    if (fstat(file, &fileStat) != 0) {
+        close(file);
+        throw std::runtime_error("failed to get file size!");
+    }
+
+    // An empty file can't be mapped, it is an empty view
+    if (fileStat.st_size == 0)
+    {
+        close(file);
+        return;
+    }
+
+    // The mapping keeps its own reference to the file
+    const size_t size = static_cast<size_t>(fileStat.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("failed to map file!");
+    }
+
+    m_data = static_cast<const char*>(data);
+    m_size = size;
+    Advise(i_access);
+}
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+MappedFile::~MappedFile()
+{
+    Unmap();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+MappedFile::MappedFile(MappedFile&& io_other) noexcept
+    : MappedFile()
+{
+    *this = std::move(io_other);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+MappedFile& MappedFile::operator=(MappedFile&& io_other) noexcept
+{
+    if (this != &io_other)
+    {
+        Unmap();
+        std::swap(m_data, io_other.m_data);
+        std::swap(m_size, io_other.m_size);
+        std::swap(m_owner, io_other.m_owner);
+#if defined(_WIN32)
+        std::swap(m_mappingHandle, io_other.m_mappingHandle);
+#endif
+    }
+    return *this;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void MappedFile::Advise(FileAccess i_access)
+{
+    if (m_data == nullptr || m_owner != nullptr)
+    {
+        return;
+    }
+
+#if defined(_WIN32)
+    // No per-mapping hint, sequential readers can at least get the pages queued up front
+    if (i_access == FileAccess::Sequential)
+    {
+        WIN32_MEMORY_RANGE_ENTRY range;
+        range.VirtualAddress = const_cast<char*>(m_data);
+        range.NumberOfBytes = m_size;
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+#else
+    // Only a hint, a kernel refusing it changes nothing about the data
+    madvise(const_cast<char*>(m_data), m_size, ToAdvice(i_access));
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void MappedFile::Unmap()
+{
+    if (m_owner != nullptr)
+    {
+        m_owner.reset();
+        m_data = nullptr;
+        m_size = 0;
+        return;
+    }
+
+    if (m_data == nullptr)
+    {
+        return;
+    }
+
+#if defined(_WIN32)
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mappingHandle);
+    m_mappingHandle = nullptr;
+#else
+    munmap(const_cast<char*>(m_data), m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,59 @@
+#pragma once
+
+///////////////////////////////////////////////////////////////////////////////
+// How a mapping will be read, passed to the kernel so read-ahead matches the access
+enum class FileAccess
+{
+    Sequential,
+    Random,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Read-only view of a whole file mapped into memory, the pages come straight from the page cache.
+// The view stays valid for as long as the MappedFile lives, it is movable but not copyable.
+// A view can also borrow memory kept alive by an owner, such as one entry of a mapped archive.
+class MappedFile {
+///////////////////////////////////////////////////////////////////////////////
+public:
+    MappedFile();
+    MappedFile(const std::string& i_fileName, FileAccess i_access);
+    // i_data stays valid as long as i_owner is alive
+    MappedFile(std::shared_ptr<const void> i_owner, const char* i_data, size_t i_size);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& io_other) noexcept;
+    MappedFile& operator=(MappedFile&& io_other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Page aligned, nullptr for an empty file
+    const char* GetData() const
+    {
+        return m_data;
+    }
+
+    size_t GetSize() const
+    {
+        return m_size;
+    }
+
+    bool IsEmpty() const
+    {
+        return m_size == 0;
+    }
+
+    // Changes the read-ahead hint of an existing mapping, borrowed views keep the hint of their owner
+    void Advise(FileAccess i_access);
+
+private:
+    void Unmap();
+
+private:
+    const char* m_data;
+    size_t m_size;
+    std::shared_ptr<const void> m_owner;
+#if defined(_WIN32)
+    void* m_mappingHandle;
+#endif
+};
+///////////////////////////////////////////////////////////////////////////////
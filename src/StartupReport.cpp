@@ -0,0 +1,117 @@
+#include "stdafx.h"
+#include "StartupReport.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+    constexpr int k_nameColumnWidth = 24;
+
+    // Nearest rank on sorted values
+    double Percentile(const std::vector<double>& i_sorted, double i_fraction)
+    {
+        const size_t rank = static_cast<size_t>(std::ceil(i_fraction * i_sorted.size()));
+        return i_sorted[std::max<size_t>(rank, 1) - 1];
+    }
+
+    void PrintDistributionRow(const std::string& i_name, std::vector<double>& io_values)
+    {
+        std::sort(io_values.begin(), io_values.end());
+        std::cout << "  " << std::left << std::setw(k_nameColumnWidth) << i_name << std::right
+            << std::setw(10) << io_values.front()
+            << std::setw(10) << Percentile(io_values, 0.5)
+            << std::setw(10) << Percentile(io_values, 0.9)
+            << std::setw(10) << io_values.back() << std::endl;
+    }
+}
+///////////////////////////////////////////////////////////////////////////////
+
+double StartupReport::GetTotalMilliseconds() const
+{
+    double total = 0.0;
+    for (const Stage& stage : m_stages)
+    {
+        total += stage.milliseconds;
+    }
+    return total;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void StartupReport::Print() const
+{
+    const double total = GetTotalMilliseconds();
+
+    std::cout << std::fixed << std::setprecision(2) << "startup: " << total << " ms" << std::endl;
+    for (const Stage& stage : m_stages)
+    {
+        std::cout << "  " << std::left << std::setw(k_nameColumnWidth) << stage.name << std::right
+            << std::setw(10) << stage.milliseconds << " ms"
+            << std::setw(8) << std::setprecision(1) << (total > 0.0 ? 100.0 * stage.milliseconds / total : 0.0) << " %"
+            << std::setprecision(2) << std::endl;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void StartupReport::PrintDistribution(const std::vector<StartupReport>& i_runs)
+{
+    if (i_runs.empty())
+    {
+        return;
+    }
+
+    std::cout << std::fixed << std::setprecision(2)
+        << "startup over " << i_runs.size() << " runs, ms:" << std::endl
+        << "  " << std::left << std::setw(k_nameColumnWidth) << "stage" << std::right
+        << std::setw(10) << "min" << std::setw(10) << "median" << std::setw(10) << "p90" << std::setw(10) << "max" << std::endl;
+
+    const std::vector<Stage>& stages = i_runs.front().GetStages();
+    std::vector<double> values(i_runs.size());
+    for (size_t stage = 0; stage < stages.size(); stage++)
+    {
+        for (size_t run = 0; run < i_runs.size(); run++)
+        {
+            assert(i_runs[run].GetStages().size() == stages.size());
+            values[run] = i_runs[run].GetStages()[stage].milliseconds;
+        }
+        PrintDistributionRow(stages[stage].name, values);
+    }
+
+    for (size_t run = 0; run < i_runs.size(); run++)
+    {
+        values[run] = i_runs[run].GetTotalMilliseconds();
+    }
+    PrintDistributionRow("total", values);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+std::string StartupReport::ToJson(const std::vector<StartupReport>& i_runs)
+{
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision(3) << "{\"runs\":[";
+
+    for (size_t run = 0; run < i_runs.size(); run++)
+    {
+        const StartupReport& report = i_runs[run];
+        stream << (run == 0 ? "\n" : ",\n") << "{\"totalMilliseconds\":" << report.GetTotalMilliseconds() << ",\"stages\":[";
+
+        // Stage names are identifiers, nothing to escape
+        for (size_t stage = 0; stage < report.m_stages.size(); stage++)
+        {
+            stream << (stage == 0 ? "" : ",") << "{\"name\":\"" << report.m_stages[stage].name
+                << "\",\"milliseconds\":" << report.m_stages[stage].milliseconds << "}";
+        }
+        stream << "]}";
+    }
+
+    stream << "\n]}\n";
+    return stream.str();
+}
+
+///////////////////////////////////////////////////////////////////////////////
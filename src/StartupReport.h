@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+///////////////////////////////////////////////////////////////////////////////
+// Wall time of every step of one startup, in the order they ran
+class StartupReport {
+///////////////////////////////////////////////////////////////////////////////
+public:
+    struct Stage {
+        std::string name;
+        double milliseconds;
+    };
+
+    // Runs i_step and records how long it took
+    template<typename Function>
+    void Time(const char* i_name, Function&& i_step)
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        i_step();
+        m_stages.push_back({ i_name, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() });
+    }
+
+    const std::vector<Stage>& GetStages() const
+    {
+        return m_stages;
+    }
+
+    double GetTotalMilliseconds() const;
+
+    // One line per stage with its share of the total
+    void Print() const;
+    // Min, median, p90 and max of every stage, i_runs must all have the same stages
+    static void PrintDistribution(const std::vector<StartupReport>& i_runs);
+    // {"runs": [{"totalMilliseconds": ..., "stages": [{"name": ..., "milliseconds": ...}]}]}
+    static std::string ToJson(const std::vector<StartupReport>& i_runs);
+
+private:
+    std::vector<Stage> m_stages;
+};
+///////////////////////////////////////////////////////////////////////////////
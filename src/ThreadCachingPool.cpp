@@ -0,0 +1,177 @@
+#include "stdafx.h"
+#include "ThreadCachingPool.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+///////////////////////////////////////////////////////////////////////////////
+// Free lists of the calling thread, handed back to the shared lists when the thread ends
+struct ThreadCache
+{
+    ThreadCachingPool::FreeBlock* freeBlocks[ThreadCachingPool::k_classCount] = {};
+    uint32_t counts[ThreadCachingPool::k_classCount] = {};
+
+    ~ThreadCache()
+    {
+        for (uint32_t sizeClass = 0; sizeClass < ThreadCachingPool::k_classCount; sizeClass++)
+        {
+            ThreadCachingPool::FreeBlock* first = freeBlocks[sizeClass];
+            if (first == nullptr)
+            {
+                continue;
+            }
+
+            ThreadCachingPool::FreeBlock* last = first;
+            while (last->next != nullptr)
+            {
+                last = last->next;
+            }
+            ThreadCachingPool::Get().ReturnBlocks(sizeClass, first, last);
+        }
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+    // Each chunk holds at least this many bytes of blocks
+    constexpr size_t k_chunkSize = 64 * 1024;
+
+    thread_local ThreadCache t_cache;
+}
+///////////////////////////////////////////////////////////////////////////////
+
+ThreadCachingPool& ThreadCachingPool::Get()
+{
+    // Never destroyed, thread caches may hand blocks back during static destruction
+    static ThreadCachingPool* pool = new ThreadCachingPool();
+    return *pool;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+uint32_t ThreadCachingPool::GetClass(size_t i_size)
+{
+    uint32_t sizeClass = 0;
+    size_t blockSize = k_minBlockSize;
+    while (blockSize < i_size)
+    {
+        blockSize *= 2;
+        sizeClass++;
+    }
+    return sizeClass;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void* ThreadCachingPool::Allocate(size_t i_size)
+{
+    if (i_size > k_maxBlockSize)
+    {
+        return std::malloc(i_size);
+    }
+
+    const uint32_t sizeClass = GetClass(i_size);
+    FreeBlock*& freeBlocks = t_cache.freeBlocks[sizeClass];
+    if (freeBlocks == nullptr)
+    {
+        freeBlocks = TakeBatch(sizeClass, t_cache.counts[sizeClass]);
+        if (freeBlocks == nullptr)
+        {
+            return nullptr;
+        }
+    }
+
+    FreeBlock* block = freeBlocks;
+    freeBlocks = block->next;
+    t_cache.counts[sizeClass]--;
+    return block;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ThreadCachingPool::Free(void* i_block, size_t i_size)
+{
+    if (i_block == nullptr)
+    {
+        return;
+    }
+    if (i_size > k_maxBlockSize)
+    {
+        std::free(i_block);
+        return;
+    }
+
+    const uint32_t sizeClass = GetClass(i_size);
+    FreeBlock* block = static_cast<FreeBlock*>(i_block);
+    block->next = t_cache.freeBlocks[sizeClass];
+    t_cache.freeBlocks[sizeClass] = block;
+
+    // A thread that only frees, like one destroying what others created, must not hoard blocks
+    if (++t_cache.counts[sizeClass] >= 2 * k_batchSize)
+    {
+        FreeBlock* first = t_cache.freeBlocks[sizeClass];
+        FreeBlock* last = first;
+        for (uint32_t i = 1; i < k_batchSize; i++)
+        {
+            last = last->next;
+        }
+        t_cache.freeBlocks[sizeClass] = last->next;
+        t_cache.counts[sizeClass] -= k_batchSize;
+
+        last->next = nullptr;
+        ReturnBlocks(sizeClass, first, last);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+ThreadCachingPool::FreeBlock* ThreadCachingPool::TakeBatch(uint32_t i_class, uint32_t& o_count)
+{
+    SizeClass& sizeClass = m_classes[i_class];
+    const size_t blockSize = k_minBlockSize << i_class;
+
+    std::lock_guard<std::mutex> lock(sizeClass.mutex);
+    if (sizeClass.freeBlocks == nullptr)
+    {
+        const size_t blockCount = std::max<size_t>(k_chunkSize / blockSize, k_batchSize);
+        char* chunk = static_cast<char*>(std::malloc(blockCount * blockSize));
+        if (chunk == nullptr)
+        {
+            o_count = 0;
+            return nullptr;
+        }
+
+        for (size_t i = 0; i < blockCount; i++)
+        {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + i * blockSize);
+            block->next = i + 1 < blockCount ? reinterpret_cast<FreeBlock*>(chunk + (i + 1) * blockSize) : nullptr;
+        }
+        sizeClass.freeBlocks = reinterpret_cast<FreeBlock*>(chunk);
+    }
+
+    FreeBlock* first = sizeClass.freeBlocks;
+    FreeBlock* last = first;
+    o_count = 1;
+    while (o_count < k_batchSize && last->next != nullptr)
+    {
+        last = last->next;
+        o_count++;
+    }
+    sizeClass.freeBlocks = last->next;
+    last->next = nullptr;
+    return first;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ThreadCachingPool::ReturnBlocks(uint32_t i_class, FreeBlock* i_first, FreeBlock* i_last)
+{
+    SizeClass& sizeClass = m_classes[i_class];
+
+    std::lock_guard<std::mutex> lock(sizeClass.mutex);
+    i_last->next = sizeClass.freeBlocks;
+    sizeClass.freeBlocks = i_first;
+}
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <mutex>
+
+///////////////////////////////////////////////////////////////////////////////
+// Size class allocator for many small, short lived blocks. Every thread keeps a free list per class
+// and only takes the lock of a class to move a batch of blocks from or to the shared list, so most
+// allocations and frees touch no lock and no heap. Blocks are 16 byte aligned. Memory carved into
+// blocks is never returned to the system, it stays available to later allocations of its class.
+// There is a single pool per process: blocks cached by a thread outlive any object using the pool.
+class ThreadCachingPool {
+///////////////////////////////////////////////////////////////////////////////
+public:
+    static constexpr size_t k_minBlockSize = 16;
+    static constexpr size_t k_maxBlockSize = 8 * 1024;
+    static constexpr uint32_t k_classCount = 10;
+    // Blocks moved between a thread and the shared list at once
+    static constexpr uint32_t k_batchSize = 32;
+
+    static ThreadCachingPool& Get();
+
+    // Larger sizes fall through to malloc, the result is null when out of memory
+    void* Allocate(size_t i_size);
+    // i_size must be the size passed to Allocate
+    void Free(void* i_block, size_t i_size);
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct alignas(64) SizeClass {
+        std::mutex mutex;
+        FreeBlock* freeBlocks = nullptr;
+    };
+
+    friend struct ThreadCache;
+
+    ThreadCachingPool() = default;
+
+    static uint32_t GetClass(size_t i_size);
+    // Takes up to k_batchSize blocks of i_class from the shared list, carving a new chunk when it is empty
+    FreeBlock* TakeBatch(uint32_t i_class, uint32_t& o_count);
+    void ReturnBlocks(uint32_t i_class, FreeBlock* i_first, FreeBlock* i_last);
+
+private:
+    SizeClass m_classes[k_classCount];
+};
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,51 @@
+#include "stdafx.h"
+#include "DeletionQueue.h"
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+
+DeletionQueue::DeletionQueue()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+DeletionQueue::~DeletionQueue()
+{
+    assert(m_entries.empty());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void DeletionQueue::Push(uint64_t i_retireFrame, std::function<void()> i_destroy)
+{
+    // Frame numbers only grow, so the queue stays sorted by retire frame
+    assert(m_entries.empty() || m_entries.back().retireFrame <= i_retireFrame);
+    m_entries.push_back(Entry{ i_retireFrame, std::move(i_destroy) });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void DeletionQueue::Flush(uint64_t i_oldestPendingFrame)
+{
+    while (!m_entries.empty() && m_entries.front().retireFrame <= i_oldestPendingFrame)
+    {
+        m_entries.front().destroy();
+        m_entries.pop_front();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void DeletionQueue::FlushAll()
+{
+    while (!m_entries.empty())
+    {
+        m_entries.front().destroy();
+        m_entries.pop_front();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+// Defers destruction of objects that frames still in flight may reference
+class DeletionQueue {
+///////////////////////////////////////////////////////////////////////////////
+public:
+    DeletionQueue();
+    ~DeletionQueue();
+
+    // i_retireFrame is the number of the first frame that no longer uses the object
+    void Push(uint64_t i_retireFrame, std::function<void()> i_destroy);
+    // Destroys everything retired at or before i_oldestPendingFrame, the oldest frame the GPU may still execute
+    void Flush(uint64_t i_oldestPendingFrame);
+    void FlushAll();
+
+private:
+    struct Entry
+    {
+        uint64_t retireFrame;
+        std::function<void()> destroy;
+    };
+
+    std::deque<Entry> m_entries;
+};
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
@@ -0,0 +1,127 @@
+#include "stdafx.h"
+#include "DeviceFeatures.h"
+
+#include <vulkan/vulkan.h>
+#include <algorithm>
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+
+DeviceFeatures DeviceFeatures::Query(VkPhysicalDevice i_device, uint32_t i_instanceApiVersion)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(i_device, &properties);
+    const uint32_t apiVersion = std::min(i_instanceApiVersion, properties.apiVersion);
+
+    // vkGetPhysicalDeviceFeatures2 itself is 1.1, and the per-version structs start at 1.2
+    DeviceFeatureChain chain(apiVersion);
+    if (apiVersion < VK_API_VERSION_1_2)
+    {
+        vkGetPhysicalDeviceFeatures(i_device, &chain.Get()->features);
+    }
+    else
+    {
+        vkGetPhysicalDeviceFeatures2(i_device, chain.Get());
+    }
+    return chain.Read();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void DeviceFeatures::Print() const
+{
+    auto yesNo = [](bool i_value) { return i_value ? "yes" : "no"; };
+
+    std::cout << "device features: Vulkan " << VK_API_VERSION_MAJOR(apiVersion) << "." << VK_API_VERSION_MINOR(apiVersion)
+        << ", pipeline statistics " << yesNo(pipelineStatisticsQuery)
+        << ", precise occlusion " << yesNo(occlusionQueryPrecise)
+        << ", draw parameters " << yesNo(shaderDrawParameters)
+        << ", timeline semaphores " << yesNo(timelineSemaphore)
+        << ", buffer device address " << yesNo(bufferDeviceAddress)
+        << ", descriptor indexing " << yesNo(descriptorIndexing)
+        << ", synchronization2 " << yesNo(synchronization2)
+        << ", dynamic rendering " << yesNo(dynamicRendering) << std::endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+DeviceFeatureChain::DeviceFeatureChain(uint32_t i_apiVersion)
+    : m_apiVersion(i_apiVersion)
+    , m_features2{}
+    , m_vulkan11Features{}
+    , m_vulkan12Features{}
+    , m_vulkan13Features{}
+{
+    m_features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    m_vulkan11Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES;
+    m_vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    m_vulkan13Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+
+    if (m_apiVersion >= VK_API_VERSION_1_2)
+    {
+        m_features2.pNext = &m_vulkan11Features;
+        m_vulkan11Features.pNext = &m_vulkan12Features;
+    }
+    if (m_apiVersion >= VK_API_VERSION_1_3)
+    {
+        m_vulkan12Features.pNext = &m_vulkan13Features;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void DeviceFeatureChain::Enable(const DeviceFeatures& i_features)
+{
+    m_features2.features.pipelineStatisticsQuery = i_features.pipelineStatisticsQuery ? VK_TRUE : VK_FALSE;
+    m_features2.features.occlusionQueryPrecise = i_features.occlusionQueryPrecise ? VK_TRUE : VK_FALSE;
+
+    m_vulkan11Features.shaderDrawParameters = i_features.shaderDrawParameters ? VK_TRUE : VK_FALSE;
+
+    m_vulkan12Features.timelineSemaphore = i_features.timelineSemaphore ? VK_TRUE : VK_FALSE;
+    m_vulkan12Features.bufferDeviceAddress = i_features.bufferDeviceAddress ? VK_TRUE : VK_FALSE;
+
+    const VkBool32 descriptorIndexing = i_features.descriptorIndexing ? VK_TRUE : VK_FALSE;
+    m_vulkan12Features.descriptorIndexing = descriptorIndexing;
+    m_vulkan12Features.runtimeDescriptorArray = descriptorIndexing;
+    m_vulkan12Features.shaderSampledImageArrayNonUniformIndexing = descriptorIndexing;
+    m_vulkan12Features.descriptorBindingPartiallyBound = descriptorIndexing;
+    m_vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = descriptorIndexing;
+    m_vulkan12Features.descriptorBindingVariableDescriptorCount = descriptorIndexing;
+
+    m_vulkan13Features.synchronization2 = i_features.synchronization2 ? VK_TRUE : VK_FALSE;
+    m_vulkan13Features.dynamicRendering = i_features.dynamicRendering ? VK_TRUE : VK_FALSE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+DeviceFeatures DeviceFeatureChain::Read() const
+{
+    DeviceFeatures features;
+    features.apiVersion = m_apiVersion;
+    features.pipelineStatisticsQuery = m_features2.features.pipelineStatisticsQuery == VK_TRUE;
+    features.occlusionQueryPrecise = m_features2.features.occlusionQueryPrecise == VK_TRUE;
+
+    if (m_apiVersion >= VK_API_VERSION_1_2)
+    {
+        features.shaderDrawParameters = m_vulkan11Features.shaderDrawParameters == VK_TRUE;
+        features.timelineSemaphore = m_vulkan12Features.timelineSemaphore == VK_TRUE;
+        features.bufferDeviceAddress = m_vulkan12Features.bufferDeviceAddress == VK_TRUE;
+        features.descriptorIndexing = m_vulkan12Features.descriptorIndexing == VK_TRUE
+            && m_vulkan12Features.runtimeDescriptorArray == VK_TRUE
+            && m_vulkan12Features.shaderSampledImageArrayNonUniformIndexing == VK_TRUE
+            && m_vulkan12Features.descriptorBindingPartiallyBound == VK_TRUE
+            && m_vulkan12Features.descriptorBindingSampledImageUpdateAfterBind == VK_TRUE
+            && m_vulkan12Features.descriptorBindingVariableDescriptorCount == VK_TRUE;
+    }
+    if (m_apiVersion >= VK_API_VERSION_1_3)
+    {
+        features.synchronization2 = m_vulkan13Features.synchronization2 == VK_TRUE;
+        features.dynamicRendering = m_vulkan13Features.dynamicRendering == VK_TRUE;
+    }
+
+    return features;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
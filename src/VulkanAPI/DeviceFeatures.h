@@ -0,0 +1,62 @@
+#pragma once
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+// Optional features the renderer can take fast paths on. Everything defaults to off, so a
+// Vulkan 1.0 device simply ends up with none of them.
+struct DeviceFeatures
+{
+    // The lower of the instance's and the device's version, features above it are never reported
+    uint32_t apiVersion = VK_API_VERSION_1_0;
+
+    // Vulkan 1.0
+    bool pipelineStatisticsQuery = false;
+    // Occlusion queries count the passing samples instead of only reporting whether any passed
+    bool occlusionQueryPrecise = false;
+    // Vulkan 1.1
+    bool shaderDrawParameters = false;
+    // Vulkan 1.2
+    bool timelineSemaphore = false;
+    bool bufferDeviceAddress = false;
+    // Bindless subset: runtime arrays, non-uniform sampled image indexing, partially bound and update after bind
+    bool descriptorIndexing = false;
+    // Vulkan 1.3
+    bool synchronization2 = false;
+    bool dynamicRendering = false;
+
+    static DeviceFeatures Query(VkPhysicalDevice i_device, uint32_t i_instanceApiVersion);
+
+    void Print() const;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// VkPhysicalDeviceFeatures2 with the VkPhysicalDeviceVulkan11/12/13Features its version knows chained behind it.
+// Used both to query a device and as the pNext of VkDeviceCreateInfo, below 1.2 only the core features of
+// Get()->features are used. Points into itself, it can't be copied.
+class DeviceFeatureChain {
+///////////////////////////////////////////////////////////////////////////////
+public:
+    // Structs newer than i_apiVersion are left out of the chain, the driver would reject them
+    DeviceFeatureChain(uint32_t i_apiVersion);
+    DeviceFeatureChain(const DeviceFeatureChain&) = delete;
+    DeviceFeatureChain& operator=(const DeviceFeatureChain&) = delete;
+
+    // Sets exactly the Vulkan feature bits backing i_features
+    void Enable(const DeviceFeatures& i_features);
+    DeviceFeatures Read() const;
+
+    VkPhysicalDeviceFeatures2* Get()
+    {
+        return &m_features2;
+    }
+
+private:
+    uint32_t m_apiVersion;
+    VkPhysicalDeviceFeatures2 m_features2;
+    VkPhysicalDeviceVulkan11Features m_vulkan11Features;
+    VkPhysicalDeviceVulkan12Features m_vulkan12Features;
+    VkPhysicalDeviceVulkan13Features m_vulkan13Features;
+};
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
@@ -0,0 +1,69 @@
+// Generated by "premake5 embed-shaders" from shaders/*.spv, do not edit
+
+constexpr uint32_t k_fragCode[] = {
+    0x07230203, 0x00010000, 0x000d000b, 0x00000021, 0x00000000, 0x00020011, 0x00000001, 0x0006000b,
+    0x00000001, 0x4c534c47, 0x6474732e, 0x3035342e, 0x00000000, 0x0003000e, 0x00000000, 0x00000001,
+    0x0007000f, 0x00000004, 0x00000004, 0x6e69616d, 0x00000000, 0x0000000b, 0x00000014, 0x00030010,
+    0x00000004, 0x00000007, 0x00030003, 0x00000002, 0x000001c2, 0x000a0004, 0x475f4c47, 0x4c474f4f,
+    0x70635f45, 0x74735f70, 0x5f656c79, 0x656e696c, 0x7269645f, 0x69746365, 0x00006576, 0x00080004,
+    0x475f4c47, 0x4c474f4f, 0x6e695f45, 0x64756c63, 0x69645f65, 0x74636572, 0x00657669, 0x00040005,
+    0x00000004, 0x6e69616d, 0x00000000, 0x00040005, 0x00000009, 0x6f6c6f63, 0x00000072, 0x00050005,
+    0x0000000b, 0x67617266, 0x6f6c6f43, 0x00000072, 0x00050005, 0x0000000d, 0x72675f6b, 0x63737961,
+    0x00656c61, 0x00050005, 0x00000014, 0x4374756f, 0x726f6c6f, 0x00000000, 0x00040047, 0x0000000b,
+    0x0000001e, 0x00000000, 0x00040047, 0x0000000d, 0x00000001, 0x00000000, 0x00040047, 0x00000014,
+    0x0000001e, 0x00000000, 0x00020013, 0x00000002, 0x00030021, 0x00000003, 0x00000002, 0x00030016,
+    0x00000006, 0x00000020, 0x00040017, 0x00000007, 0x00000006, 0x00000003, 0x00040020, 0x00000008,
+    0x00000007, 0x00000007, 0x00040020, 0x0000000a, 0x00000001, 0x00000007, 0x0004003b, 0x0000000a,
+    0x0000000b, 0x00000001, 0x00020014, 0x0000000c, 0x00030031, 0x0000000c, 0x0000000d, 0x0004002b,
+    0x00000006, 0x0000000e, 0x3e991687, 0x0004002b, 0x00000006, 0x0000000f, 0x3f1645a2, 0x0004002b,
+    0x00000006, 0x00000010, 0x3de978d5, 0x0006002c, 0x00000007, 0x00000011, 0x0000000e, 0x0000000f,
+    0x00000010, 0x00040017, 0x00000012, 0x00000006, 0x00000004, 0x00040020, 0x00000013, 0x00000003,
+    0x00000012, 0x0004003b, 0x00000013, 0x00000014, 0x00000003, 0x0004002b, 0x00000006, 0x00000015,
+    0x3f800000, 0x00050036, 0x00000002, 0x00000004, 0x00000000, 0x00000003, 0x000200f8, 0x00000005,
+    0x0004003b, 0x00000008, 0x00000009, 0x00000007, 0x0004003d, 0x00000007, 0x00000016, 0x0000000b,
+    0x0003003e, 0x00000009, 0x00000016, 0x000300f7, 0x00000018, 0x00000000, 0x000400fa, 0x0000000d,
+    0x00000017, 0x00000018, 0x000200f8, 0x00000017, 0x0004003d, 0x00000007, 0x00000019, 0x00000009,
+    0x00050094, 0x00000006, 0x0000001a, 0x00000019, 0x00000011, 0x00060050, 0x00000007, 0x0000001b,
+    0x0000001a, 0x0000001a, 0x0000001a, 0x0003003e, 0x00000009, 0x0000001b, 0x000200f9, 0x00000018,
+    0x000200f8, 0x00000018, 0x0004003d, 0x00000007, 0x0000001c, 0x00000009, 0x00050051, 0x00000006,
+    0x0000001d, 0x0000001c, 0x00000000, 0x00050051, 0x00000006, 0x0000001e, 0x0000001c, 0x00000001,
+    0x00050051, 0x00000006, 0x0000001f, 0x0000001c, 0x00000002, 0x00070050, 0x00000012, 0x00000020,
+    0x0000001d, 0x0000001e, 0x0000001f, 0x00000015, 0x0003003e, 0x00000014, 0x00000020, 0x000100fd,
+    0x00010038,
+};
+
+constexpr uint32_t k_vertCode[] = {
+    0x07230203, 0x00010000, 0x000d000b, 0x0000001e, 0x00000000, 0x00020011, 0x00000001, 0x0006000b,
+    0x00000001, 0x4c534c47, 0x6474732e, 0x3035342e, 0x00000000, 0x0003000e, 0x00000000, 0x00000001,
+    0x0009000f, 0x00000000, 0x00000004, 0x6e69616d, 0x00000000, 0x0000000a, 0x0000000f, 0x00000015,
+    0x00000017, 0x00030003, 0x00000002, 0x000001c2, 0x000a0004, 0x475f4c47, 0x4c474f4f, 0x70635f45,
+    0x74735f70, 0x5f656c79, 0x656e696c, 0x7269645f, 0x69746365, 0x00006576, 0x00080004, 0x475f4c47,
+    0x4c474f4f, 0x6e695f45, 0x64756c63, 0x69645f65, 0x74636572, 0x00657669, 0x00040005, 0x00000004,
+    0x6e69616d, 0x00000000, 0x00060005, 0x00000008, 0x505f6c67, 0x65567265, 0x78657472, 0x00000000,
+    0x00060006, 0x00000008, 0x00000000, 0x505f6c67, 0x7469736f, 0x006e6f69, 0x00030005, 0x0000000a,
+    0x00000000, 0x00050005, 0x0000000f, 0x6f506e69, 0x69746973, 0x00006e6f, 0x00050005, 0x00000015,
+    0x67617266, 0x6f6c6f43, 0x00000072, 0x00040005, 0x00000017, 0x6f436e69, 0x00726f6c, 0x00050048,
+    0x00000008, 0x00000000, 0x0000000b, 0x00000000, 0x00030047, 0x00000008, 0x00000002, 0x00040047,
+    0x0000000f, 0x0000001e, 0x00000000, 0x00040047, 0x00000015, 0x0000001e, 0x00000000, 0x00040047,
+    0x00000017, 0x0000001e, 0x00000001, 0x00020013, 0x00000002, 0x00030021, 0x00000003, 0x00000002,
+    0x00030016, 0x00000006, 0x00000020, 0x00040017, 0x00000007, 0x00000006, 0x00000004, 0x0003001e,
+    0x00000008, 0x00000007, 0x00040020, 0x00000009, 0x00000003, 0x00000008, 0x0004003b, 0x00000009,
+    0x0000000a, 0x00000003, 0x00040015, 0x0000000b, 0x00000020, 0x00000001, 0x0004002b, 0x0000000b,
+    0x0000000c, 0x00000000, 0x00040017, 0x0000000d, 0x00000006, 0x00000002, 0x00040020, 0x0000000e,
+    0x00000001, 0x0000000d, 0x0004003b, 0x0000000e, 0x0000000f, 0x00000001, 0x0004002b, 0x00000006,
+    0x00000010, 0x00000000, 0x0004002b, 0x00000006, 0x00000011, 0x3f800000, 0x00040020, 0x00000012,
+    0x00000003, 0x00000007, 0x00040017, 0x00000013, 0x00000006, 0x00000003, 0x00040020, 0x00000014,
+    0x00000003, 0x00000013, 0x0004003b, 0x00000014, 0x00000015, 0x00000003, 0x00040020, 0x00000016,
+    0x00000001, 0x00000013, 0x0004003b, 0x00000016, 0x00000017, 0x00000001, 0x00050036, 0x00000002,
+    0x00000004, 0x00000000, 0x00000003, 0x000200f8, 0x00000005, 0x0004003d, 0x0000000d, 0x00000018,
+    0x0000000f, 0x00050051, 0x00000006, 0x00000019, 0x00000018, 0x00000000, 0x00050051, 0x00000006,
+    0x0000001a, 0x00000018, 0x00000001, 0x00070050, 0x00000007, 0x0000001b, 0x00000019, 0x0000001a,
+    0x00000010, 0x00000011, 0x00050041, 0x00000012, 0x0000001c, 0x0000000a, 0x0000000c, 0x0003003e,
+    0x0000001c, 0x0000001b, 0x0004003d, 0x00000013, 0x0000001d, 0x00000017, 0x0003003e, 0x00000015,
+    0x0000001d, 0x000100fd, 0x00010038,
+};
+
+constexpr EmbeddedShader k_embeddedShaders[] = {
+    { "frag", k_fragCode, sizeof(k_fragCode) },
+    { "vert", k_vertCode, sizeof(k_vertCode) },
+};
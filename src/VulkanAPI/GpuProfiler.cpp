@@ -0,0 +1,436 @@
+#include "stdafx.h"
+#include "GpuProfiler.h"
+
+#include <vulkan/vulkan.h>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+constexpr uint32_t k_invalidScope = UINT32_MAX;
+
+// Results come back in bit order, the same order as the fields of GpuProfiler::Counters
+constexpr VkQueryPipelineStatisticFlags k_pipelineStatistics =
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+constexpr uint32_t k_pipelineStatisticCount = 6;
+
+///////////////////////////////////////////////////////////////////////////////
+
+GpuProfiler::GpuProfiler(VkPhysicalDevice i_physicalDevice, VkDevice i_device, uint32_t i_queueFamilyIndex, uint32_t i_framesInFlight, bool i_counters,
+    bool i_preciseOcclusion, const VkAllocationCallbacks* i_allocator)
+    : m_device(i_device)
+    , m_allocator(i_allocator)
+    , m_timestampMask(0)
+    , m_timestampPeriod(0.0)
+    , m_counters(i_counters)
+    , m_preciseOcclusion(i_preciseOcclusion)
+    , m_recordingFrame(nullptr)
+    , m_countedScope(k_invalidScope)
+    , m_frameCount(0)
+    , m_missingCount(0)
+{
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(i_physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(i_physicalDevice, &queueFamilyCount, queueFamilies.data());
+    assert(i_queueFamilyIndex < queueFamilyCount);
+
+    const uint32_t validBits = queueFamilies[i_queueFamilyIndex].timestampValidBits;
+    if (validBits == 0)
+    {
+        std::cout << "gpu profiler: no timestamps on queue family " << i_queueFamilyIndex << ", disabled" << std::endl;
+        return;
+    }
+    m_timestampMask = validBits >= 64 ? UINT64_MAX : (uint64_t(1) << validBits) - 1;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(i_physicalDevice, &properties);
+    m_timestampPeriod = properties.limits.timestampPeriod;
+
+    m_frames.resize(i_framesInFlight);
+    for (FrameQueries& frame : m_frames)
+    {
+        VkQueryPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        poolInfo.queryCount = k_maxScopesPerFrame * 2;
+
+        if (vkCreateQueryPool(m_device, &poolInfo, m_allocator, &frame.pool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create timestamp query pool!");
+        }
+        frame.scopes.reserve(k_maxScopesPerFrame);
+
+        if (m_counters)
+        {
+            VkQueryPoolCreateInfo statisticsPoolInfo{};
+            statisticsPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            statisticsPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+            statisticsPoolInfo.queryCount = k_maxScopesPerFrame;
+            statisticsPoolInfo.pipelineStatistics = k_pipelineStatistics;
+
+            if (vkCreateQueryPool(m_device, &statisticsPoolInfo, m_allocator, &frame.statisticsPool) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create pipeline statistics query pool!");
+            }
+
+            VkQueryPoolCreateInfo occlusionPoolInfo{};
+            occlusionPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            occlusionPoolInfo.queryType = VK_QUERY_TYPE_OCCLUSION;
+            occlusionPoolInfo.queryCount = k_maxScopesPerFrame;
+
+            if (vkCreateQueryPool(m_device, &occlusionPoolInfo, m_allocator, &frame.occlusionPool) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create occlusion query pool!");
+            }
+        }
+    }
+    // Large enough for the timestamps of a frame and for the statistics of one scope
+    m_results.resize(std::max(k_maxScopesPerFrame * 2 * 2, k_pipelineStatisticCount + 1));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+GpuProfiler::~GpuProfiler()
+{
+    for (FrameQueries& frame : m_frames)
+    {
+        vkDestroyQueryPool(m_device, frame.pool, m_allocator);
+        vkDestroyQueryPool(m_device, frame.statisticsPool, m_allocator);
+        vkDestroyQueryPool(m_device, frame.occlusionPool, m_allocator);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void GpuProfiler::BeginFrame(uint32_t i_frameIndex, VkCommandBuffer i_commandBuffer)
+{
+    if (!IsSupported())
+    {
+        return;
+    }
+
+    assert(i_frameIndex < m_frames.size());
+    FrameQueries& frame = m_frames[i_frameIndex];
+    CollectResults(frame);
+
+    vkCmdResetQueryPool(i_commandBuffer, frame.pool, 0, k_maxScopesPerFrame * 2);
+    if (m_counters)
+    {
+        vkCmdResetQueryPool(i_commandBuffer, frame.statisticsPool, 0, k_maxScopesPerFrame);
+        vkCmdResetQueryPool(i_commandBuffer, frame.occlusionPool, 0, k_maxScopesPerFrame);
+    }
+    frame.pending = true;
+    m_recordingFrame = &frame;
+    m_countedScope = k_invalidScope;
+    m_frameCount++;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+uint32_t GpuProfiler::BeginScope(VkCommandBuffer i_commandBuffer, const char* i_name)
+{
+    if (m_recordingFrame == nullptr)
+    {
+        return k_invalidScope;
+    }
+
+    FrameQueries& frame = *m_recordingFrame;
+    if (frame.scopes.size() == k_maxScopesPerFrame)
+    {
+        m_missingCount++;
+        return k_invalidScope;
+    }
+
+    const uint32_t scope = static_cast<uint32_t>(frame.scopes.size());
+    const bool hasCounters = m_counters && m_countedScope == k_invalidScope;
+    frame.scopes.push_back({ i_name, hasCounters });
+    vkCmdWriteTimestamp(i_commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.pool, scope * 2);
+
+    if (hasCounters)
+    {
+        vkCmdBeginQuery(i_commandBuffer, frame.statisticsPool, scope, 0);
+        vkCmdBeginQuery(i_commandBuffer, frame.occlusionPool, scope, m_preciseOcclusion ? VK_QUERY_CONTROL_PRECISE_BIT : 0);
+        m_countedScope = scope;
+    }
+    return scope;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void GpuProfiler::EndScope(VkCommandBuffer i_commandBuffer, uint32_t i_scope)
+{
+    if (m_recordingFrame == nullptr || i_scope == k_invalidScope)
+    {
+        return;
+    }
+
+    FrameQueries& frame = *m_recordingFrame;
+    assert(i_scope < frame.scopes.size());
+    if (i_scope == m_countedScope)
+    {
+        vkCmdEndQuery(i_commandBuffer, frame.occlusionPool, i_scope);
+        vkCmdEndQuery(i_commandBuffer, frame.statisticsPool, i_scope);
+        m_countedScope = k_invalidScope;
+    }
+    vkCmdWriteTimestamp(i_commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.pool, i_scope * 2 + 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void GpuProfiler::EndFrame()
+{
+    assert(m_countedScope == k_invalidScope);
+    m_recordingFrame = nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void GpuProfiler::Flush()
+{
+    for (FrameQueries& frame : m_frames)
+    {
+        CollectResults(frame);
+    }
+    m_recordingFrame = nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void GpuProfiler::CollectResults(FrameQueries& io_frame)
+{
+    if (!io_frame.pending)
+    {
+        return;
+    }
+    io_frame.pending = false;
+
+    const uint32_t scopeCount = static_cast<uint32_t>(io_frame.scopes.size());
+    if (scopeCount > 0)
+    {
+        // No wait flag, a query that is not available yet is counted as missing instead of stalling
+        const uint32_t queryCount = scopeCount * 2;
+        const VkResult result = vkGetQueryPoolResults(m_device, io_frame.pool, 0, queryCount, queryCount * 2 * sizeof(uint64_t), m_results.data(),
+            2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        if (result != VK_SUCCESS && result != VK_NOT_READY) {
+            throw std::runtime_error("failed to read timestamp queries!");
+        }
+
+        for (uint32_t scope = 0; scope < scopeCount; scope++)
+        {
+            const uint64_t* begin = &m_results[scope * 4];
+            const uint64_t* end = &m_results[scope * 4 + 2];
+            if (begin[1] == 0 || end[1] == 0)
+            {
+                m_missingCount++;
+                continue;
+            }
+
+            // Masked so a counter wrapping between the two writes still gives the right distance
+            const uint64_t ticks = (end[0] - begin[0]) & m_timestampMask;
+            AddSample(io_frame.scopes[scope].name, static_cast<float>(ticks * m_timestampPeriod * 1e-6));
+        }
+
+        // Read after the timestamps, m_results is reused
+        for (uint32_t scope = 0; scope < scopeCount; scope++)
+        {
+            Counters counters;
+            if (io_frame.scopes[scope].hasCounters && ReadCounters(io_frame, scope, counters))
+            {
+                AddCounters(io_frame.scopes[scope].name, counters);
+            }
+        }
+    }
+
+    io_frame.scopes.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool GpuProfiler::ReadCounters(FrameQueries& i_frame, uint32_t i_scope, Counters& o_counters)
+{
+    const VkQueryResultFlags flags = VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT;
+    const size_t statisticsSize = (k_pipelineStatisticCount + 1) * sizeof(uint64_t);
+
+    VkResult result = vkGetQueryPoolResults(m_device, i_frame.statisticsPool, i_scope, 1, statisticsSize, m_results.data(), statisticsSize, flags);
+    if (result != VK_SUCCESS && result != VK_NOT_READY) {
+        throw std::runtime_error("failed to read pipeline statistics queries!");
+    }
+    if (m_results[k_pipelineStatisticCount] == 0)
+    {
+        m_missingCount++;
+        return false;
+    }
+
+    o_counters.inputAssemblyVertices = static_cast<double>(m_results[0]);
+    o_counters.inputAssemblyPrimitives = static_cast<double>(m_results[1]);
+    o_counters.vertexShaderInvocations = static_cast<double>(m_results[2]);
+    o_counters.clippingInvocations = static_cast<double>(m_results[3]);
+    o_counters.clippingPrimitives = static_cast<double>(m_results[4]);
+    o_counters.fragmentShaderInvocations = static_cast<double>(m_results[5]);
+
+    uint64_t occlusion[2] = {};
+    result = vkGetQueryPoolResults(m_device, i_frame.occlusionPool, i_scope, 1, sizeof(occlusion), occlusion, sizeof(occlusion), flags);
+    if (result != VK_SUCCESS && result != VK_NOT_READY) {
+        throw std::runtime_error("failed to read occlusion queries!");
+    }
+    if (occlusion[1] == 0)
+    {
+        m_missingCount++;
+        return false;
+    }
+    // An imprecise query may return any nonzero value once a sample passed
+    if (m_preciseOcclusion)
+    {
+        o_counters.samplesPassed = static_cast<double>(occlusion[0]);
+    }
+    else
+    {
+        o_counters.samplesPassed = occlusion[0] != 0 ? 1.0 : 0.0;
+    }
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void GpuProfiler::AddSample(const std::string& i_name, float i_milliseconds)
+{
+    PassHistory& history = m_passes[i_name];
+    if (history.milliseconds.size() < k_historySize)
+    {
+        history.milliseconds.push_back(i_milliseconds);
+        return;
+    }
+
+    history.milliseconds[history.next] = i_milliseconds;
+    history.next = (history.next + 1) % k_historySize;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void GpuProfiler::AddCounters(const std::string& i_name, const Counters& i_counters)
+{
+    PassHistory& history = m_passes[i_name];
+    if (history.counters.size() < k_historySize)
+    {
+        history.counters.push_back(i_counters);
+        return;
+    }
+
+    history.counters[history.nextCounters] = i_counters;
+    history.nextCounters = (history.nextCounters + 1) % k_historySize;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+GpuProfiler::Statistics GpuProfiler::GetStatistics()
+{
+    Statistics statistics;
+    statistics.frameCount = m_frameCount;
+    statistics.missingCount = m_missingCount;
+    statistics.preciseOcclusion = m_preciseOcclusion;
+
+    std::vector<float> sorted;
+    for (const auto& pass : m_passes)
+    {
+        PassStatistics passStatistics;
+        passStatistics.name = pass.first;
+
+        const std::vector<float>& samples = pass.second.milliseconds;
+        if (!samples.empty())
+        {
+            sorted.assign(samples.begin(), samples.end());
+            std::sort(sorted.begin(), sorted.end());
+
+            double sum = 0.0;
+            for (float sample : sorted)
+            {
+                sum += sample;
+            }
+
+            // Nearest rank
+            const size_t p99Rank = static_cast<size_t>(std::ceil(0.99 * sorted.size()));
+
+            passStatistics.sampleCount = static_cast<uint32_t>(sorted.size());
+            passStatistics.minMilliseconds = sorted.front();
+            passStatistics.averageMilliseconds = sum / sorted.size();
+            passStatistics.p99Milliseconds = sorted[std::max<size_t>(p99Rank, 1) - 1];
+        }
+
+        const std::vector<Counters>& counters = pass.second.counters;
+        if (!counters.empty())
+        {
+            Counters& average = passStatistics.averageCounters;
+            for (const Counters& sample : counters)
+            {
+                average.inputAssemblyVertices += sample.inputAssemblyVertices;
+                average.inputAssemblyPrimitives += sample.inputAssemblyPrimitives;
+                average.vertexShaderInvocations += sample.vertexShaderInvocations;
+                average.clippingInvocations += sample.clippingInvocations;
+                average.clippingPrimitives += sample.clippingPrimitives;
+                average.fragmentShaderInvocations += sample.fragmentShaderInvocations;
+                average.samplesPassed += sample.samplesPassed;
+            }
+
+            const double count = static_cast<double>(counters.size());
+            average.inputAssemblyVertices /= count;
+            average.inputAssemblyPrimitives /= count;
+            average.vertexShaderInvocations /= count;
+            average.clippingInvocations /= count;
+            average.clippingPrimitives /= count;
+            average.fragmentShaderInvocations /= count;
+            average.samplesPassed /= count;
+            passStatistics.counterSampleCount = static_cast<uint32_t>(counters.size());
+        }
+
+        statistics.passes.push_back(passStatistics);
+    }
+
+    return statistics;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void GpuProfiler::PrintStatistics()
+{
+    if (!IsSupported())
+    {
+        return;
+    }
+
+    const Statistics statistics = GetStatistics();
+
+    std::cout << "gpu passes: " << statistics.frameCount << " frames profiled, " << statistics.missingCount << " scopes without results" << std::endl;
+    for (const PassStatistics& pass : statistics.passes)
+    {
+        std::cout << std::fixed << std::setprecision(3)
+            << "  " << pass.name << ": min " << pass.minMilliseconds << " ms, avg " << pass.averageMilliseconds
+            << " ms, p99 " << pass.p99Milliseconds << " ms over the last " << pass.sampleCount << " frames" << std::endl;
+
+        if (pass.counterSampleCount > 0)
+        {
+            const Counters& counters = pass.averageCounters;
+            std::cout << std::setprecision(0)
+                << "    per frame: " << counters.inputAssemblyVertices << " vertices, " << counters.inputAssemblyPrimitives << " primitives, "
+                << counters.vertexShaderInvocations << " vertex shader invocations, "
+                << counters.clippingInvocations << " primitives clipped into " << counters.clippingPrimitives << ", "
+                << counters.fragmentShaderInvocations << " fragment shader invocations, ";
+            if (statistics.preciseOcclusion)
+            {
+                std::cout << counters.samplesPassed << " samples passed" << std::endl;
+            }
+            else
+            {
+                std::cout << "visible in " << counters.samplesPassed * 100.0 << "% of frames" << std::endl;
+            }
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
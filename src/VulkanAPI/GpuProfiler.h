@@ -0,0 +1,159 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+// Measures GPU time of named passes with timestamp queries, one query pool per frame in flight.
+// Optionally also counts the work of each pass with pipeline statistics and occlusion queries.
+// A slot's results are read when the slot comes around again, after its fence has signaled,
+// so reading never waits on the GPU. Every pass keeps a rolling window of its last samples.
+// Not thread safe, scopes can only be recorded into primary command buffers of the render thread.
+class GpuProfiler {
+///////////////////////////////////////////////////////////////////////////////
+public:
+    // Work done by one pass in one frame
+    struct Counters {
+        double inputAssemblyVertices = 0.0;
+        double inputAssemblyPrimitives = 0.0;
+        double vertexShaderInvocations = 0.0;
+        double clippingInvocations = 0.0;
+        double clippingPrimitives = 0.0;
+        double fragmentShaderInvocations = 0.0;
+        // Samples that passed the depth and stencil tests, from an occlusion query. Without precise
+        // occlusion queries only 1 when any sample passed, averaged it is the fraction of frames with visible output
+        double samplesPassed = 0.0;
+    };
+
+    struct PassStatistics {
+        std::string name;
+        uint32_t sampleCount = 0;
+        double minMilliseconds = 0.0;
+        double averageMilliseconds = 0.0;
+        double p99Milliseconds = 0.0;
+        // 0 without counters, the averages are per frame over the same window as the timings
+        uint32_t counterSampleCount = 0;
+        Counters averageCounters;
+    };
+
+    struct Statistics {
+        uint64_t frameCount = 0;
+        // Scopes whose queries had no result, recorded but never submitted or exceeding k_maxScopesPerFrame
+        uint64_t missingCount = 0;
+        // Whether Counters::samplesPassed is a sample count or a visibility flag
+        bool preciseOcclusion = false;
+        // Sorted by name
+        std::vector<PassStatistics> passes;
+    };
+
+    // Begins on construction and ends when it goes out of scope
+    class Scope {
+    public:
+        Scope(GpuProfiler& i_profiler, VkCommandBuffer i_commandBuffer, const char* i_name)
+            : m_profiler(i_profiler)
+            , m_commandBuffer(i_commandBuffer)
+            , m_index(i_profiler.BeginScope(i_commandBuffer, i_name))
+        {
+        }
+
+        ~Scope()
+        {
+            m_profiler.EndScope(m_commandBuffer, m_index);
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        GpuProfiler& m_profiler;
+        VkCommandBuffer m_commandBuffer;
+        uint32_t m_index;
+    };
+
+    static constexpr uint32_t k_maxScopesPerFrame = 32;
+    // Samples per pass the statistics are computed over
+    static constexpr uint32_t k_historySize = 256;
+
+    // i_queueFamilyIndex is the family the profiled command buffers are submitted to. i_counters needs the
+    // pipelineStatisticsQuery device feature enabled, i_preciseOcclusion the occlusionQueryPrecise one.
+    GpuProfiler(VkPhysicalDevice i_physicalDevice, VkDevice i_device, uint32_t i_queueFamilyIndex, uint32_t i_framesInFlight, bool i_counters,
+        bool i_preciseOcclusion, const VkAllocationCallbacks* i_allocator);
+    ~GpuProfiler();
+
+    // False when the queue family has no timestamps, every other call is then a no-op
+    bool IsSupported()
+    {
+        return m_timestampMask != 0;
+    }
+
+    // Call once the fence of i_frameIndex has signaled, right after beginning the frame's command buffer
+    // and outside any render pass. Collects the results the slot produced last time and resets its pool.
+    void BeginFrame(uint32_t i_frameIndex, VkCommandBuffer i_commandBuffer);
+    // Scopes may nest, use Scope rather than pairing these by hand. Counters are only taken for the
+    // outermost scope, Vulkan can't have two queries of a type active at once. Counted scopes must not
+    // execute secondary command buffers.
+    uint32_t BeginScope(VkCommandBuffer i_commandBuffer, const char* i_name);
+    void EndScope(VkCommandBuffer i_commandBuffer, uint32_t i_scope);
+    // Every scope must have ended, later scopes are ignored until the next BeginFrame
+    void EndFrame();
+
+    // Collects every slot still holding results, the device must be idle
+    void Flush();
+
+    Statistics GetStatistics();
+    void PrintStatistics();
+
+private:
+    struct ScopeRecord {
+        std::string name;
+        bool hasCounters;
+    };
+
+    struct FrameQueries {
+        VkQueryPool pool = VK_NULL_HANDLE;
+        // One query per scope, VK_NULL_HANDLE without counters
+        VkQueryPool statisticsPool = VK_NULL_HANDLE;
+        VkQueryPool occlusionPool = VK_NULL_HANDLE;
+        std::vector<ScopeRecord> scopes;
+        bool pending = false;
+    };
+
+    // Rings of the last k_historySize samples
+    struct PassHistory {
+        std::vector<float> milliseconds;
+        size_t next = 0;
+        std::vector<Counters> counters;
+        size_t nextCounters = 0;
+    };
+
+    void CollectResults(FrameQueries& io_frame);
+    bool ReadCounters(FrameQueries& i_frame, uint32_t i_scope, Counters& o_counters);
+    void AddSample(const std::string& i_name, float i_milliseconds);
+    void AddCounters(const std::string& i_name, const Counters& i_counters);
+
+private:
+    VkDevice m_device;
+    const VkAllocationCallbacks* m_allocator;
+    // Valid bits of a timestamp, 0 when unsupported
+    uint64_t m_timestampMask;
+    // Nanoseconds per tick
+    double m_timestampPeriod;
+
+    bool m_counters;
+    bool m_preciseOcclusion;
+
+    std::vector<FrameQueries> m_frames;
+    FrameQueries* m_recordingFrame;
+    // Scope holding the active pipeline statistics and occlusion queries
+    uint32_t m_countedScope;
+    // Kept across frames, (value, availability) pairs as returned by vkGetQueryPoolResults
+    std::vector<uint64_t> m_results;
+
+    std::map<std::string, PassHistory> m_passes;
+    uint64_t m_frameCount;
+    uint64_t m_missingCount;
+};
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
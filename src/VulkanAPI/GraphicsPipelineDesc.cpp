@@ -0,0 +1,162 @@
+#include "stdafx.h"
+#include "GraphicsPipelineDesc.h"
+
+#include <vulkan/vulkan.h>
+#include <cstring>
+#include <type_traits>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+    // Multiply and xorshift over whole 64-bit words, descriptions are mostly 32-bit fields so this
+    // does a fraction of the rounds of a byte-wise hash
+    class Hasher {
+    public:
+        void Add(uint64_t i_value)
+        {
+            m_hash = (m_hash ^ i_value) * 0x9E3779B97F4A7C15ull;
+            m_hash ^= m_hash >> 29;
+        }
+
+        void AddBytes(const void* i_data, size_t i_size)
+        {
+            Add(i_size);
+            const uint8_t* bytes = static_cast<const uint8_t*>(i_data);
+            for (; i_size >= sizeof(uint64_t); i_size -= sizeof(uint64_t), bytes += sizeof(uint64_t))
+            {
+                uint64_t word;
+                memcpy(&word, bytes, sizeof(word));
+                Add(word);
+            }
+            if (i_size > 0)
+            {
+                uint64_t word = 0;
+                memcpy(&word, bytes, i_size);
+                Add(word);
+            }
+        }
+
+        template<typename T>
+        void AddArray(const std::vector<T>& i_values)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "hashed as raw bytes");
+            AddBytes(i_values.data(), i_values.size() * sizeof(T));
+        }
+
+        template<typename T>
+        void AddHandle(T i_handle)
+        {
+            // Non-dispatchable handles are pointers on 64-bit targets and uint64_t on 32-bit ones
+            uint64_t bits = 0;
+            memcpy(&bits, &i_handle, sizeof(i_handle));
+            Add(bits);
+        }
+
+        uint64_t Get() const
+        {
+            // Final avalanche so the top bits are usable for sharding
+            uint64_t hash = m_hash;
+            hash ^= hash >> 33;
+            hash *= 0xFF51AFD7ED558CCDull;
+            hash ^= hash >> 33;
+            return hash;
+        }
+
+    private:
+        uint64_t m_hash = 0xCBF29CE484222325ull;
+    };
+
+    // The Vulkan structs stored in a description have no padding to trip memcmp, VkSpecializationMapEntry
+    // ends in a size_t right after two 4-byte fields
+    template<typename T>
+    bool EqualArrays(const std::vector<T>& i_a, const std::vector<T>& i_b)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "compared as raw bytes");
+        return i_a.size() == i_b.size() && (i_a.empty() || memcmp(i_a.data(), i_b.data(), i_a.size() * sizeof(T)) == 0);
+    }
+}
+///////////////////////////////////////////////////////////////////////////////
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+
+uint64_t GraphicsPipelineDesc::Hash() const
+{
+    Hasher hasher;
+
+    hasher.Add(shaderStages.size());
+    for (const ShaderStage& shaderStage : shaderStages)
+    {
+        hasher.Add(shaderStage.stage);
+        hasher.AddHandle(shaderStage.module);
+        hasher.AddBytes(shaderStage.entryPoint.data(), shaderStage.entryPoint.size());
+        hasher.AddArray(shaderStage.specializationEntries);
+        hasher.AddArray(shaderStage.specializationData);
+    }
+
+    hasher.AddArray(vertexBindings);
+    hasher.AddArray(vertexAttributes);
+    hasher.Add(topology);
+
+    hasher.Add(polygonMode);
+    hasher.Add(cullMode);
+    hasher.Add(frontFace);
+
+    hasher.Add((depthTestEnable ? 1u : 0u) | (depthWriteEnable ? 2u : 0u));
+    hasher.Add(depthCompareOp);
+
+    hasher.AddArray(colorBlendAttachments);
+    hasher.AddArray(dynamicStates);
+
+    hasher.AddArray(colorFormats);
+    hasher.Add(depthFormat);
+    hasher.Add(rasterizationSamples);
+
+    hasher.AddHandle(layout);
+    hasher.AddHandle(renderPass);
+    hasher.Add(subpass);
+
+    return hasher.Get();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool GraphicsPipelineDesc::operator==(const GraphicsPipelineDesc& i_other) const
+{
+    if (shaderStages.size() != i_other.shaderStages.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < shaderStages.size(); i++)
+    {
+        const ShaderStage& a = shaderStages[i];
+        const ShaderStage& b = i_other.shaderStages[i];
+        if (a.stage != b.stage || a.module != b.module || a.entryPoint != b.entryPoint
+            || !EqualArrays(a.specializationEntries, b.specializationEntries) || !EqualArrays(a.specializationData, b.specializationData))
+        {
+            return false;
+        }
+    }
+
+    return EqualArrays(vertexBindings, i_other.vertexBindings)
+        && EqualArrays(vertexAttributes, i_other.vertexAttributes)
+        && topology == i_other.topology
+        && polygonMode == i_other.polygonMode
+        && cullMode == i_other.cullMode
+        && frontFace == i_other.frontFace
+        && depthTestEnable == i_other.depthTestEnable
+        && depthWriteEnable == i_other.depthWriteEnable
+        && depthCompareOp == i_other.depthCompareOp
+        && EqualArrays(colorBlendAttachments, i_other.colorBlendAttachments)
+        && EqualArrays(dynamicStates, i_other.dynamicStates)
+        && EqualArrays(colorFormats, i_other.colorFormats)
+        && depthFormat == i_other.depthFormat
+        && rasterizationSamples == i_other.rasterizationSamples
+        && layout == i_other.layout
+        && renderPass == i_other.renderPass
+        && subpass == i_other.subpass;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
@@ -0,0 +1,58 @@
+#pragma once
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+// Self-contained description of a graphics pipeline. Owns every array that
+// VkGraphicsPipelineCreateInfo points to, so it can be handed to another thread.
+struct GraphicsPipelineDesc
+{
+    struct ShaderStage
+    {
+        VkShaderStageFlagBits stage;
+        VkShaderModule module;
+        std::string entryPoint = "main";
+        // Owned VkSpecializationInfo, empty keeps the defaults compiled into the module
+        std::vector<VkSpecializationMapEntry> specializationEntries;
+        std::vector<uint8_t> specializationData;
+        // Feature switches the module declares, see ShaderPermutation. Follows from module, so Hash and == skip it.
+        uint32_t featureBits = 0;
+    };
+
+    std::vector<ShaderStage> shaderStages;
+
+    std::vector<VkVertexInputBindingDescription> vertexBindings;
+    std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+    VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+    VkFrontFace frontFace = VK_FRONT_FACE_CLOCKWISE;
+
+    bool depthTestEnable = false;
+    bool depthWriteEnable = false;
+    VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS;
+
+    std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments;
+    std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+    // Render targets the pipeline draws into, they have to match the attachments of renderPass.
+    // With renderPass left VK_NULL_HANDLE the pipeline is built for dynamic rendering from these alone.
+    std::vector<VkFormat> colorFormats;
+    VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+    VkSampleCountFlagBits rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    uint32_t subpass = 0;
+
+    // Covers every field, shader modules and other handles are compared by value
+    uint64_t Hash() const;
+    bool operator==(const GraphicsPipelineDesc& i_other) const;
+    bool operator!=(const GraphicsPipelineDesc& i_other) const
+    {
+        return !(*this == i_other);
+    }
+};
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
@@ -0,0 +1,17 @@
+#pragma once
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+// Who serves the host memory the driver allocates for Vulkan objects
+enum class HostAllocationMode
+{
+    // The driver's own allocator, no VkAllocationCallbacks are passed
+    Default,
+    // malloc behind callbacks counting bytes and calls per allocation scope and call site
+    Tracked,
+    // The same counting, backed by the ThreadCachingPool
+    Pooled,
+};
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
@@ -0,0 +1,275 @@
+#include "stdafx.h"
+#include "HostAllocator.h"
+
+#include "ThreadCachingPool.h"
+
+#include <vulkan/vulkan.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+    const char* const k_scopeNames[] = { "command", "object", "cache", "device", "instance" };
+
+    // Relaxed, the counters are statistics and never order other memory
+    void AddLiveBytes(std::atomic<uint64_t>& io_live, std::atomic<uint64_t>& io_peak, uint64_t i_bytes)
+    {
+        const uint64_t live = io_live.fetch_add(i_bytes, std::memory_order_relaxed) + i_bytes;
+        uint64_t peak = io_peak.load(std::memory_order_relaxed);
+        while (live > peak && !io_peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void Accumulate(VulkanAPI::HostAllocator::Counters& io_total, const VulkanAPI::HostAllocator::Counters& i_counters)
+    {
+        io_total.allocationCount += i_counters.allocationCount;
+        io_total.freeCount += i_counters.freeCount;
+        io_total.allocatedBytes += i_counters.allocatedBytes;
+        io_total.liveBytes += i_counters.liveBytes;
+        // Peaks of different sites need not coincide, the sum is an upper bound
+        io_total.peakLiveBytes += i_counters.peakLiveBytes;
+        io_total.liveInternalBytes += i_counters.liveInternalBytes;
+    }
+
+    void PrintCounters(const std::string& i_name, const VulkanAPI::HostAllocator::Counters& i_counters)
+    {
+        constexpr double k_kib = 1024.0;
+        std::cout << "  " << std::left << std::setw(40) << i_name << std::right
+            << std::setw(10) << i_counters.allocationCount
+            << std::setw(10) << i_counters.freeCount
+            << std::setw(12) << i_counters.allocatedBytes / k_kib
+            << std::setw(10) << i_counters.liveBytes / k_kib
+            << std::setw(10) << i_counters.peakLiveBytes / k_kib
+            << std::setw(10) << i_counters.liveInternalBytes / k_kib << std::endl;
+    }
+}
+///////////////////////////////////////////////////////////////////////////////
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+
+HostAllocator::HostAllocator(HostAllocationMode i_mode)
+    : m_mode(i_mode)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+HostAllocator::~HostAllocator()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+const VkAllocationCallbacks* HostAllocator::GetCallbacks(const char* i_callSite)
+{
+    if (m_mode == HostAllocationMode::Default)
+    {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(m_callSitesMutex);
+    std::unique_ptr<CallSite>& callSite = m_callSites[i_callSite];
+    if (callSite == nullptr)
+    {
+        callSite = std::make_unique<CallSite>();
+        callSite->allocator = this;
+        callSite->callbacks.pUserData = callSite.get();
+        callSite->callbacks.pfnAllocation = &HostAllocator::Allocate;
+        callSite->callbacks.pfnReallocation = &HostAllocator::Reallocate;
+        callSite->callbacks.pfnFree = &HostAllocator::Free;
+        callSite->callbacks.pfnInternalAllocation = &HostAllocator::InternalAllocate;
+        callSite->callbacks.pfnInternalFree = &HostAllocator::InternalFree;
+    }
+    return &callSite->callbacks;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void* HostAllocator::AllocateBacking(size_t i_size)
+{
+    return m_mode == HostAllocationMode::Pooled ? ThreadCachingPool::Get().Allocate(i_size) : std::malloc(i_size);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void HostAllocator::FreeBacking(void* i_block, size_t i_size)
+{
+    if (m_mode == HostAllocationMode::Pooled)
+    {
+        ThreadCachingPool::Get().Free(i_block, i_size);
+    }
+    else
+    {
+        std::free(i_block);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void* VKAPI_PTR HostAllocator::Allocate(void* i_userData, size_t i_size, size_t i_alignment, VkSystemAllocationScope i_scope)
+{
+    // Callbacks must not throw, failure is reported with a null pointer
+    if (i_size == 0)
+    {
+        return nullptr;
+    }
+
+    CallSite* callSite = static_cast<CallSite*>(i_userData);
+    assert(i_scope >= 0 && static_cast<uint32_t>(i_scope) < k_scopeCount);
+
+    // Backing blocks are 16 byte aligned, the header keeps the block aligned to at least that
+    const size_t alignment = std::max<size_t>(i_alignment, alignof(Header));
+    const size_t backingSize = sizeof(Header) + i_size + alignment - alignof(Header);
+    void* base = callSite->allocator->AllocateBacking(backingSize);
+    if (base == nullptr)
+    {
+        return nullptr;
+    }
+
+    const uintptr_t address = (reinterpret_cast<uintptr_t>(base) + sizeof(Header) + alignment - 1) & ~(uintptr_t(alignment) - 1);
+    Header* header = reinterpret_cast<Header*>(address) - 1;
+    header->base = base;
+    header->size = i_size;
+    header->backingSize = backingSize;
+    header->callSite = callSite;
+    header->scope = i_scope;
+
+    ScopeCounters& counters = callSite->scopes[i_scope];
+    counters.allocationCount.fetch_add(1, std::memory_order_relaxed);
+    counters.allocatedBytes.fetch_add(i_size, std::memory_order_relaxed);
+    AddLiveBytes(counters.liveBytes, counters.peakLiveBytes, i_size);
+
+    return reinterpret_cast<void*>(address);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void* VKAPI_PTR HostAllocator::Reallocate(void* i_userData, void* i_original, size_t i_size, size_t i_alignment, VkSystemAllocationScope i_scope)
+{
+    if (i_original == nullptr)
+    {
+        return Allocate(i_userData, i_size, i_alignment, i_scope);
+    }
+    if (i_size == 0)
+    {
+        Free(i_userData, i_original);
+        return nullptr;
+    }
+
+    // The original stays untouched when the new block can't be had
+    void* memory = Allocate(i_userData, i_size, i_alignment, i_scope);
+    if (memory == nullptr)
+    {
+        return nullptr;
+    }
+
+    const Header* original = static_cast<const Header*>(i_original) - 1;
+    std::memcpy(memory, i_original, std::min(original->size, i_size));
+    Free(i_userData, i_original);
+    return memory;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void VKAPI_PTR HostAllocator::Free(void* /*i_userData*/, void* i_memory)
+{
+    if (i_memory == nullptr)
+    {
+        return;
+    }
+
+    // Counted where it was allocated, whichever site frees it
+    const Header header = *(static_cast<const Header*>(i_memory) - 1);
+    ScopeCounters& counters = header.callSite->scopes[header.scope];
+    counters.freeCount.fetch_add(1, std::memory_order_relaxed);
+    counters.liveBytes.fetch_sub(header.size, std::memory_order_relaxed);
+
+    header.callSite->allocator->FreeBacking(header.base, header.backingSize);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void VKAPI_PTR HostAllocator::InternalAllocate(void* i_userData, size_t i_size, VkInternalAllocationType, VkSystemAllocationScope i_scope)
+{
+    CallSite* callSite = static_cast<CallSite*>(i_userData);
+    callSite->scopes[i_scope].liveInternalBytes.fetch_add(i_size, std::memory_order_relaxed);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void VKAPI_PTR HostAllocator::InternalFree(void* i_userData, size_t i_size, VkInternalAllocationType, VkSystemAllocationScope i_scope)
+{
+    CallSite* callSite = static_cast<CallSite*>(i_userData);
+    callSite->scopes[i_scope].liveInternalBytes.fetch_sub(i_size, std::memory_order_relaxed);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+HostAllocator::Statistics HostAllocator::GetStatistics()
+{
+    Statistics statistics;
+
+    std::lock_guard<std::mutex> lock(m_callSitesMutex);
+    for (const auto& callSite : m_callSites)
+    {
+        Counters siteCounters;
+        for (uint32_t scope = 0; scope < k_scopeCount; scope++)
+        {
+            const ScopeCounters& scopeCounters = callSite.second->scopes[scope];
+
+            Counters counters;
+            counters.allocationCount = scopeCounters.allocationCount.load(std::memory_order_relaxed);
+            counters.freeCount = scopeCounters.freeCount.load(std::memory_order_relaxed);
+            counters.allocatedBytes = scopeCounters.allocatedBytes.load(std::memory_order_relaxed);
+            counters.liveBytes = scopeCounters.liveBytes.load(std::memory_order_relaxed);
+            counters.peakLiveBytes = scopeCounters.peakLiveBytes.load(std::memory_order_relaxed);
+            counters.liveInternalBytes = scopeCounters.liveInternalBytes.load(std::memory_order_relaxed);
+
+            Accumulate(statistics.scopes[scope], counters);
+            Accumulate(siteCounters, counters);
+        }
+        statistics.callSites.emplace_back(callSite.first, siteCounters);
+    }
+
+    std::sort(statistics.callSites.begin(), statistics.callSites.end(), [](const auto& i_a, const auto& i_b)
+    {
+        return i_a.second.allocatedBytes > i_b.second.allocatedBytes;
+    });
+    return statistics;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void HostAllocator::PrintStatistics()
+{
+    if (m_mode == HostAllocationMode::Default)
+    {
+        return;
+    }
+
+    const Statistics statistics = GetStatistics();
+
+    std::cout << std::fixed << std::setprecision(1)
+        << "host allocations (" << (m_mode == HostAllocationMode::Pooled ? "pooled" : "tracked") << "), sizes in KiB:" << std::endl
+        << "  " << std::left << std::setw(40) << "scope / call site" << std::right
+        << std::setw(10) << "allocs" << std::setw(10) << "frees" << std::setw(12) << "allocated"
+        << std::setw(10) << "live" << std::setw(10) << "peak" << std::setw(10) << "internal" << std::endl;
+
+    for (uint32_t scope = 0; scope < k_scopeCount; scope++)
+    {
+        PrintCounters(k_scopeNames[scope], statistics.scopes[scope]);
+    }
+    for (const auto& callSite : statistics.callSites)
+    {
+        PrintCounters(callSite.first, callSite.second);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "VulkanAPI/HostAllocationMode.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+// VkAllocationCallbacks that attribute every driver host allocation to the call site that passed
+// them and to its VkSystemAllocationScope. Each call site gets its own callbacks, pUserData points
+// to its counters. Any of them can free what another allocated, so create and destroy calls may use
+// different sites. Must outlive every object created with its callbacks.
+class HostAllocator {
+///////////////////////////////////////////////////////////////////////////////
+public:
+    static constexpr uint32_t k_scopeCount = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+    struct Counters {
+        // Allocations and reallocations
+        uint64_t allocationCount = 0;
+        uint64_t freeCount = 0;
+        uint64_t allocatedBytes = 0;
+        uint64_t liveBytes = 0;
+        uint64_t peakLiveBytes = 0;
+        // Reported through the internal allocation notifications, memory the driver got elsewhere
+        uint64_t liveInternalBytes = 0;
+    };
+
+    struct Statistics {
+        Counters scopes[k_scopeCount];
+        // Sorted by allocated bytes, largest first
+        std::vector<std::pair<std::string, Counters>> callSites;
+    };
+
+    HostAllocator(HostAllocationMode i_mode);
+    ~HostAllocator();
+
+    // Null in HostAllocationMode::Default. i_callSite names the code passing the callbacks.
+    const VkAllocationCallbacks* GetCallbacks(const char* i_callSite);
+
+    HostAllocationMode GetMode()
+    {
+        return m_mode;
+    }
+
+    Statistics GetStatistics();
+    void PrintStatistics();
+
+private:
+    struct ScopeCounters {
+        std::atomic<uint64_t> allocationCount{ 0 };
+        std::atomic<uint64_t> freeCount{ 0 };
+        std::atomic<uint64_t> allocatedBytes{ 0 };
+        std::atomic<uint64_t> liveBytes{ 0 };
+        std::atomic<uint64_t> peakLiveBytes{ 0 };
+        std::atomic<uint64_t> liveInternalBytes{ 0 };
+    };
+
+    struct CallSite {
+        HostAllocator* allocator;
+        VkAllocationCallbacks callbacks;
+        ScopeCounters scopes[k_scopeCount];
+    };
+
+    // Placed right before every block handed to the driver
+    struct alignas(16) Header {
+        void* base;
+        size_t size;
+        size_t backingSize;
+        CallSite* callSite;
+        VkSystemAllocationScope scope;
+    };
+
+    static void* VKAPI_PTR Allocate(void* i_userData, size_t i_size, size_t i_alignment, VkSystemAllocationScope i_scope);
+    static void* VKAPI_PTR Reallocate(void* i_userData, void* i_original, size_t i_size, size_t i_alignment, VkSystemAllocationScope i_scope);
+    static void VKAPI_PTR Free(void* i_userData, void* i_memory);
+    static void VKAPI_PTR InternalAllocate(void* i_userData, size_t i_size, VkInternalAllocationType i_type, VkSystemAllocationScope i_scope);
+    static void VKAPI_PTR InternalFree(void* i_userData, size_t i_size, VkInternalAllocationType i_type, VkSystemAllocationScope i_scope);
+
+    void* AllocateBacking(size_t i_size);
+    void FreeBacking(void* i_block, size_t i_size);
+
+private:
+    HostAllocationMode m_mode;
+
+    std::mutex m_callSitesMutex;
+    // Nodes keep their address, the driver holds on to the callbacks inside
+    std::map<std::string, std::unique_ptr<CallSite>> m_callSites;
+};
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
@@ -1,19 +1,40 @@
 #include "stdafx.h"
 #include "Instance.h"
 
+#include "VulkanAPI/DeviceFeatures.h"
+#include "VulkanAPI/GpuProfiler.h"
+#include "VulkanAPI/HostAllocator.h"
 #include "VulkanAPI/LogicalDevice.h"
+#include "VulkanAPI/MemoryAllocator.h"
+#include "VulkanAPI/OffscreenTarget.h"
+#include "VulkanAPI/ParallelCommandRecorder.h"
 #include "VulkanAPI/PhysicalDevice.h"
+#include "VulkanAPI/PipelineCache.h"
+#include "VulkanAPI/PipelineLayoutCache.h"
+#include "VulkanAPI/PipelineStateCache.h"
 #include "VulkanAPI/QueueFamilyIndices.h"
 #include "VulkanAPI/RequiredInstanceExtensionsInfo.h"
+#include "VulkanAPI/ShaderPermutation.h"
+#include "VulkanAPI/ShaderReflection.h"
+#include "VulkanAPI/ShaderRegistry.h"
+#include "VulkanAPI/StagingRing.h"
 #include "VulkanAPI/SwapChainSupportDetails.h"
 #include "VulkanAPI/WindowSurface.h"
 
+#include "CpuTrace.h"
 #include "FileSystem.h"
+#include "FileWatcher.h"
+#include "JobSystem.h"
 #include "Window.h"
 
 #include <cstdint>
 #include <limits>
 #include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <cmath>
+#include <iterator>
 
 ///////////////////////////////////////////////////////////////////////////////
 namespace
@@ -28,23 +49,95 @@ namespace
 
         return VK_FALSE;
     }
+
+    // Matches the inputs of shader.vert
+    struct Vertex {
+        float position[2];
+        float color[3];
+    };
+
+    const Vertex k_triangleVertices[] = {
+        { { 0.0f, -0.5f }, { 1.0f, 0.0f, 0.0f } },
+        { { 0.5f, 0.5f }, { 0.0f, 1.0f, 0.0f } },
+        { { -0.5f, 0.5f }, { 0.0f, 0.0f, 1.0f } },
+    };
+
+    uint64_t CountHostAllocations(const VulkanAPI::HostAllocator::Statistics& i_statistics)
+    {
+        uint64_t count = 0;
+        for (const VulkanAPI::HostAllocator::Counters& counters : i_statistics.scopes)
+        {
+            count += counters.allocationCount;
+        }
+        return count;
+    }
+
+    VkImageMemoryBarrier MakeColorAttachmentBarrier(VkImage i_image, VkImageLayout i_oldLayout, VkImageLayout i_newLayout)
+    {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = i_oldLayout;
+        barrier.newLayout = i_newLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = i_image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.layerCount = 1;
+        return barrier;
+    }
 }
 ///////////////////////////////////////////////////////////////////////////////
 
 namespace VulkanAPI
 {
 ///////////////////////////////////////////////////////////////////////////////
-const std::vector<const char*> k_deviceExtensions = {
-    VK_KHR_SWAPCHAIN_EXTENSION_NAME
-};
+const std::string k_pipelineCacheFileName = "pipeline_cache.bin";
+// Used when no window dictates the size, the headless surface reports an undefined extent
+const VkExtent2D k_headlessExtent = { 800, 600 };
+constexpr uint32_t k_offscreenImageCount = 3;
+constexpr VkDeviceSize k_stagingBytesPerFrame = 8 * 1024 * 1024;
+constexpr uint32_t k_recordBenchmarkChunkSize = 1024;
+constexpr uint32_t k_recordBenchmarkRuns = 5;
+// A 4x4 float matrix, the size of a typical per object update
+constexpr VkDeviceSize k_uploadBenchmarkSize = 64;
+constexpr uint32_t k_uploadBenchmarkFrames = 256;
+// The triangle turns once every this many frames
+constexpr uint32_t k_triangleFramesPerTurn = 600;
+constexpr uint32_t k_spirvMagic = 0x07230203;
+constexpr size_t k_spirvHeaderSize = 5 * sizeof(uint32_t);
 ///////////////////////////////////////////////////////////////////////////////
 
-Instance::Instance(const std::vector<const char*>& i_validationLayers, RequiredInstanceExtensionsInfo& i_requiredInstanceExtensionsInfo, std::unique_ptr<Window>& i_window, std::unique_ptr<FileSystem>& i_fileSystem)
-    : m_instance(nullptr)
+Instance::Instance(const std::vector<const char*>& i_validationLayers, RequiredInstanceExtensionsInfo& i_requiredInstanceExtensionsInfo, std::unique_ptr<Window>& i_window, std::unique_ptr<FileSystem>& i_fileSystem, PresentTarget i_presentTarget, HostAllocationMode i_hostAllocationMode)
+    : m_hostAllocator(std::make_unique<HostAllocator>(i_hostAllocationMode))
+    , m_instance(nullptr)
+    , m_apiVersion(VK_API_VERSION_1_0)
     , m_fileSystem(i_fileSystem)
+    , m_debugMessenger(nullptr)
     , m_window(i_window)
+    , m_presentTarget(i_presentTarget)
+    , m_swapChain(VK_NULL_HANDLE)
+    , m_offscreenTarget(nullptr)
+    , m_renderPass(VK_NULL_HANDLE)
+    , m_dynamicRendering(false)
+    , m_vkCmdBeginRendering(nullptr)
+    , m_vkCmdEndRendering(nullptr)
+    , m_vertShaderModule(VK_NULL_HANDLE)
+    , m_fragShaderModule(VK_NULL_HANDLE)
+    , m_shaderPermutation(0)
+    , m_shaderWatcher(nullptr)
+    , m_reloadedVertShaderModule(VK_NULL_HANDLE)
+    , m_reloadedFragShaderModule(VK_NULL_HANDLE)
+    , m_shaderReloadQueued(false)
+    , m_pipelineCompiler(nullptr)
+    , m_pipelineStateCache(nullptr)
+    , m_commandPool(VK_NULL_HANDLE)
+    , m_stagingRing(nullptr)
+    , m_vertexBuffer(VK_NULL_HANDLE)
+    , m_gpuProfiler(nullptr)
+    , m_currentFrame(0)
+    , m_frameNumber(0)
     , m_surface(nullptr)
-    , m_debugMessenger(nullptr)
     , k_validationLayers(i_validationLayers)
     , m_physicalDevice(nullptr)
 {
@@ -60,7 +153,15 @@ Instance::Instance(const std::vector<const char*>& i_validationLayers, RequiredI
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName = "No Engine";
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+    // Vulkan 1.3 when the loader knows it, devices are still picked on 1.0 features and dynamic rendering needs 1.3.
+    // A 1.0 loader has no vkEnumerateInstanceVersion and rejects anything above 1.0.
+    auto enumerateInstanceVersion = (PFN_vkEnumerateInstanceVersion)vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion");
+    uint32_t loaderVersion = VK_API_VERSION_1_0;
+    if (enumerateInstanceVersion != nullptr && enumerateInstanceVersion(&loaderVersion) == VK_SUCCESS)
+    {
+        m_apiVersion = std::min(loaderVersion, static_cast<uint32_t>(VK_API_VERSION_1_3));
+    }
+    appInfo.apiVersion = m_apiVersion;
 
     ///
     VkInstanceCreateInfo createInfo{};
@@ -69,6 +170,27 @@ Instance::Instance(const std::vector<const char*>& i_validationLayers, RequiredI
     {
         requiredExtension.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
     }
+
+    assert((m_presentTarget == PresentTarget::Window) == (m_window != nullptr));
+    if (m_presentTarget == PresentTarget::HeadlessSurface)
+    {
+        if (CheckInstanceExtensionSupport(VK_KHR_SURFACE_EXTENSION_NAME) && CheckInstanceExtensionSupport(VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME))
+        {
+            requiredExtension.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+            requiredExtension.push_back(VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME);
+        }
+        else
+        {
+            std::cout << VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME << " not available, rendering to offscreen images" << std::endl;
+            m_presentTarget = PresentTarget::Offscreen;
+        }
+    }
+
+    // Without a surface there is nothing to present to and no swapchain to create
+    if (m_presentTarget != PresentTarget::Offscreen)
+    {
+        m_deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    }
     
     createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     createInfo.pApplicationInfo = &appInfo;
@@ -90,7 +212,7 @@ Instance::Instance(const std::vector<const char*>& i_validationLayers, RequiredI
         createInfo.pNext = (VkDebugUtilsMessengerCreateInfoEXT*)&debugCreateInfo;
     }
 
-    VkResult createResult = vkCreateInstance(&createInfo, nullptr, &m_instance);
+    VkResult createResult = vkCreateInstance(&createInfo, m_hostAllocator->GetCallbacks("Instance::Instance"), &m_instance);
     if (createResult != VK_SUCCESS)
     {
         throw std::runtime_error("failed to create instance!");
@@ -105,25 +227,90 @@ Instance::~Instance()
     assert(logicalDevice != nullptr);
     VkDevice device = logicalDevice->GetDevice();
 
-    vkDestroyPipeline(device, m_graphicsPipeline, nullptr);
-    vkDestroyPipelineLayout(device, m_pipelineLayout, nullptr);
-    vkDestroyRenderPass(device, m_renderPass, nullptr);
+    // Joins the workers, anything still queued is compiled first, then the cache destroys every pipeline
+    m_pipelineCompiler.reset();
+    m_pipelineStateCache.reset();
+
+    // A rebuild that never got swapped in
+    vkDestroyShaderModule(device, m_reloadedFragShaderModule, m_hostAllocator->GetCallbacks("Instance::CreateShaderModule"));
+    vkDestroyShaderModule(device, m_reloadedVertShaderModule, m_hostAllocator->GetCallbacks("Instance::CreateShaderModule"));
+
+    // The device is idle at this point, retired swapchains can go regardless of their frame
+    m_deletionQueue.FlushAll();
+
+    for (const FrameResources& frame : m_frames) {
+        vkDestroySemaphore(device, frame.imageAvailableSemaphore, m_hostAllocator->GetCallbacks("Instance::CreateSyncObjects"));
+        vkDestroyFence(device, frame.inFlightFence, m_hostAllocator->GetCallbacks("Instance::CreateSyncObjects"));
+    }
+    for (VkSemaphore semaphore : m_renderFinishedSemaphores) {
+        vkDestroySemaphore(device, semaphore, m_hostAllocator->GetCallbacks("Instance::CreateSwapChainSemaphores"));
+    }
+    m_gpuProfiler.reset();
+    vkDestroyBuffer(device, m_vertexBuffer, m_hostAllocator->GetCallbacks("Instance::CreateCommandBuffers"));
+    logicalDevice->GetMemoryAllocator()->Free(m_vertexMemory);
+    m_stagingRing.reset();
+    vkDestroyCommandPool(device, m_commandPool, m_hostAllocator->GetCallbacks("Instance::CreateCommandPool"));
+    for (VkFramebuffer framebuffer : m_swapChainFramebuffers) {
+        vkDestroyFramebuffer(device, framebuffer, m_hostAllocator->GetCallbacks("Instance::CreateFramebuffers"));
+    }
+    vkDestroyShaderModule(device, m_fragShaderModule, m_hostAllocator->GetCallbacks("Instance::CreateShaderModule"));
+    vkDestroyShaderModule(device, m_vertShaderModule, m_hostAllocator->GetCallbacks("Instance::CreateShaderModule"));
+    vkDestroyRenderPass(device, m_renderPass, m_hostAllocator->GetCallbacks("Instance::CreateRenderPass"));
     for (auto imageView : m_swapChainImageViews) {
-        vkDestroyImageView(device, imageView, nullptr);
+        vkDestroyImageView(device, imageView, m_hostAllocator->GetCallbacks("Instance::CreateImageViews"));
     }
-    vkDestroySwapchainKHR(device, m_swapChain, nullptr);
+    if (m_swapChain != VK_NULL_HANDLE) {
+        vkDestroySwapchainKHR(device, m_swapChain, m_hostAllocator->GetCallbacks("Instance::CreateSwapChain"));
+    }
+    m_offscreenTarget.reset();
     m_physicalDevice.reset();
     DestroyDebugUtilsMessenger();
     m_surface.reset();
-    vkDestroyInstance(m_instance, nullptr);
+    vkDestroyInstance(m_instance, m_hostAllocator->GetCallbacks("Instance::Instance"));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
 void Instance::CreateSurface()
 {
-    VkSurfaceKHR surface = m_window->CreateVulkanSurface(m_instance);
-    m_surface = std::make_unique<WindowSurface>(m_instance, surface);
+    switch (m_presentTarget)
+    {
+    case PresentTarget::Window:
+    {
+        const VkAllocationCallbacks* allocator = m_hostAllocator->GetCallbacks("Instance::CreateSurface");
+        VkSurfaceKHR surface = m_window->CreateVulkanSurface(m_instance, allocator);
+        m_surface = std::make_unique<WindowSurface>(m_instance, surface, allocator);
+        break;
+    }
+    case PresentTarget::HeadlessSurface:
+        CreateHeadlessSurface();
+        break;
+    case PresentTarget::Offscreen:
+        break;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Instance::CreateHeadlessSurface()
+{
+    VkHeadlessSurfaceCreateInfoEXT createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT;
+
+    auto func = (PFN_vkCreateHeadlessSurfaceEXT)vkGetInstanceProcAddr(m_instance, "vkCreateHeadlessSurfaceEXT");
+    if (func == nullptr)
+    {
+        throw std::runtime_error("failed to create headless surface! Extension not present!");
+    }
+
+    const VkAllocationCallbacks* allocator = m_hostAllocator->GetCallbacks("Instance::CreateHeadlessSurface");
+    VkSurfaceKHR surface;
+    if (func(m_instance, &createInfo, allocator, &surface) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create headless surface!");
+    }
+
+    m_surface = std::make_unique<WindowSurface>(m_instance, surface, allocator);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -161,7 +348,7 @@ void Instance::CreateDebugUtilsMessenger()
     auto func = (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr(m_instance, "vkCreateDebugUtilsMessengerEXT");
     if (func != nullptr)
     {
-        VkResult result = func(m_instance, &createInfo, nullptr, &m_debugMessenger);
+        VkResult result = func(m_instance, &createInfo, m_hostAllocator->GetCallbacks("Instance::CreateDebugUtilsMessenger"), &m_debugMessenger);
         if (result != VK_SUCCESS)
         {
             throw std::runtime_error("failed to set up debug messenger!");
@@ -179,7 +366,7 @@ void Instance::DestroyDebugUtilsMessenger()
 {
     auto func = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(m_instance, "vkDestroyDebugUtilsMessengerEXT");
     if (func != nullptr && m_debugMessenger != nullptr) {
-        func(m_instance, m_debugMessenger, nullptr);
+        func(m_instance, m_debugMessenger, m_hostAllocator->GetCallbacks("Instance::CreateDebugUtilsMessenger"));
     }
 }
 
@@ -217,8 +404,31 @@ bool Instance::CheckValidationLayerSupport(const std::vector<const char*>& i_val
 
 ///////////////////////////////////////////////////////////////////////////////
 
+bool Instance::CheckInstanceExtensionSupport(const char* i_extensionName)
+{
+    uint32_t extensionCount = 0;
+    vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+
+    for (const VkExtensionProperties& extension : extensions)
+    {
+        if (strcmp(i_extensionName, extension.extensionName) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void Instance::PickPhysicalDevice()
 {
+    CPU_TRACE_ZONE("Instance::PickPhysicalDevice");
+
     uint32_t deviceCount = 0;
     vkEnumeratePhysicalDevices(m_instance, &deviceCount, nullptr);
 
@@ -253,15 +463,66 @@ void Instance::PickPhysicalDevice()
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void Instance::CreateLogicalDevice()
+void Instance::CreateLogicalDevice(bool i_preferDynamicRendering)
 {
-    m_physicalDevice->CreateLogicalDevice(k_validationLayers, k_deviceExtensions);
+    // Everything the device offers is enabled, the renderer picks its paths from the result
+    const DeviceFeatures features = m_physicalDevice->QueryFeatures(m_apiVersion);
+    features.Print();
+
+    if (i_preferDynamicRendering)
+    {
+        m_dynamicRendering = features.dynamicRendering;
+        if (!m_dynamicRendering)
+        {
+            std::cout << "dynamic rendering not available, using a render pass" << std::endl;
+        }
+    }
+
+    m_physicalDevice->CreateLogicalDevice(k_validationLayers, m_deviceExtensions, features, *m_hostAllocator);
+
+    LogicalDevice* logicalDevice = m_physicalDevice->GetLogicalDevice();
+    assert(logicalDevice != nullptr);
+
+    if (m_dynamicRendering)
+    {
+        // Core 1.3 commands are not exported by older loaders, the executable must still start there
+        m_vkCmdBeginRendering = (PFN_vkCmdBeginRendering)vkGetDeviceProcAddr(logicalDevice->GetDevice(), "vkCmdBeginRendering");
+        m_vkCmdEndRendering = (PFN_vkCmdEndRendering)vkGetDeviceProcAddr(logicalDevice->GetDevice(), "vkCmdEndRendering");
+        if (m_vkCmdBeginRendering == nullptr || m_vkCmdEndRendering == nullptr) {
+            throw std::runtime_error("failed to load dynamic rendering commands!");
+        }
+        std::cout << "rendering without render pass objects (dynamic rendering)" << std::endl;
+    }
+    PipelineCache* pipelineCache = logicalDevice->GetPipelineCache();
+    pipelineCache->Load(*m_fileSystem, k_pipelineCacheFileName);
+
+    QueueFamilyIndices indices = m_physicalDevice->GetQueueFamilyIndices();
+    std::cout << "queue families: graphics " << indices.optGraphicsFamily.value()
+        << ", transfer " << indices.GetTransferFamily() << (logicalDevice->HasDedicatedTransferQueue() ? " (dedicated)" : " (shared)") << std::endl;
+
+    m_pipelineCompiler = std::make_unique<PipelineCompiler>(logicalDevice->GetDevice(), pipelineCache->GetCache(), m_hostAllocator->GetCallbacks("PipelineCompiler"));
+    m_pipelineStateCache = std::make_unique<PipelineStateCache>(logicalDevice->GetDevice(), *m_pipelineCompiler);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
 void Instance::CreateSwapChain()
 {
+    if (m_presentTarget == PresentTarget::Offscreen)
+    {
+        LogicalDevice* logicalDevice = m_physicalDevice->GetLogicalDevice();
+        assert(logicalDevice != nullptr);
+
+        VkFormat format = OffscreenTarget::ChooseFormat(m_physicalDevice->GetDevice());
+        m_offscreenTarget = std::make_unique<OffscreenTarget>(*logicalDevice->GetMemoryAllocator(), logicalDevice->GetDevice(), format, k_headlessExtent, k_offscreenImageCount, m_hostAllocator->GetCallbacks("OffscreenTarget"));
+
+        m_swapChainImages = m_offscreenTarget->GetImages();
+        m_swapChainImageFormat = m_offscreenTarget->GetFormat();
+        m_swapChainExtent = m_offscreenTarget->GetExtent();
+        m_imagesInFlight.assign(m_swapChainImages.size(), VK_NULL_HANDLE);
+        return;
+    }
+
     SwapChainSupportDetails swapChainSupport = QuerySwapChainSupport(m_physicalDevice->GetDevice());
 
     VkSurfaceFormatKHR surfaceFormat = ChooseSwapSurfaceFormat(swapChainSupport.formats);
@@ -305,11 +566,12 @@ void Instance::CreateSwapChain()
     createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     createInfo.presentMode = presentMode;
     createInfo.clipped = VK_TRUE;
-    createInfo.oldSwapchain = VK_NULL_HANDLE;
+    // Set when recreating, lets the driver hand resources over from the retired swapchain
+    createInfo.oldSwapchain = m_swapChain;
     
     LogicalDevice* logicalDevice = m_physicalDevice->GetLogicalDevice();
     assert(logicalDevice != nullptr);
-    if (vkCreateSwapchainKHR(logicalDevice->GetDevice(), &createInfo, nullptr, &m_swapChain) != VK_SUCCESS) {
+    if (vkCreateSwapchainKHR(logicalDevice->GetDevice(), &createInfo, m_hostAllocator->GetCallbacks("Instance::CreateSwapChain"), &m_swapChain) != VK_SUCCESS) {
         throw std::runtime_error("failed to create swap chain!");
     }
 
@@ -341,7 +603,7 @@ void Instance::CreateImageViews()
         createInfo.subresourceRange.levelCount = 1;
         createInfo.subresourceRange.baseArrayLayer = 0;
         createInfo.subresourceRange.layerCount = 1;
-        if (vkCreateImageView(logicalDevice->GetDevice(), &createInfo, nullptr, &m_swapChainImageViews[i]) != VK_SUCCESS) {
+        if (vkCreateImageView(logicalDevice->GetDevice(), &createInfo, m_hostAllocator->GetCallbacks("Instance::CreateImageViews"), &m_swapChainImageViews[i]) != VK_SUCCESS) {
             throw std::runtime_error("failed to create image views!");
         }
     }
@@ -351,6 +613,12 @@ void Instance::CreateImageViews()
 
 void Instance::CreateRenderPass()
 {
+    // Pipelines and passes are described by attachment formats alone
+    if (m_dynamicRendering)
+    {
+        return;
+    }
+
     VkAttachmentDescription colorAttachment{};
     colorAttachment.format = m_swapChainImageFormat;
     colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
@@ -359,7 +627,8 @@ void Instance::CreateRenderPass()
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    // Offscreen images are only ever read back, there is no presentation engine to hand them to
+    colorAttachment.finalLayout = m_presentTarget == PresentTarget::Offscreen ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
     VkAttachmentReference colorAttachmentRef{};
     colorAttachmentRef.attachment = 0;
@@ -370,97 +639,51 @@ void Instance::CreateRenderPass()
     subpass.colorAttachmentCount = 1;
     subpass.pColorAttachments = &colorAttachmentRef;
 
+    // The layout transition at the start of the pass must wait for the acquire semaphore,
+    // which is only waited on at the color attachment output stage
+    VkSubpassDependency dependency{};
+    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependency.dstSubpass = 0;
+    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.srcAccessMask = 0;
+    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
     VkRenderPassCreateInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
     renderPassInfo.attachmentCount = 1;
     renderPassInfo.pAttachments = &colorAttachment;
     renderPassInfo.subpassCount = 1;
     renderPassInfo.pSubpasses = &subpass;
+    renderPassInfo.dependencyCount = 1;
+    renderPassInfo.pDependencies = &dependency;
 
     LogicalDevice* logicalDevice = m_physicalDevice->GetLogicalDevice();
     assert(logicalDevice != nullptr);
 
-    if (vkCreateRenderPass(logicalDevice->GetDevice(), &renderPassInfo, nullptr, &m_renderPass) != VK_SUCCESS) {
+    if (vkCreateRenderPass(logicalDevice->GetDevice(), &renderPassInfo, m_hostAllocator->GetCallbacks("Instance::CreateRenderPass"), &m_renderPass) != VK_SUCCESS) {
         throw std::runtime_error("failed to create render pass!");
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void Instance::CreateGraphicsPipeline()
+void Instance::CreateGraphicsPipeline(const std::string& i_shaderOverrideDirectory, uint32_t i_shaderPermutation)
 {
+    CPU_TRACE_ZONE("Instance::CreateGraphicsPipeline");
+
     LogicalDevice* logicalDevice = m_physicalDevice->GetLogicalDevice();
     assert(logicalDevice != nullptr);
-    VkDevice device = logicalDevice->GetDevice();
+    PipelineCache* pipelineCache = logicalDevice->GetPipelineCache();
 
-    auto vertShaderCode = m_fileSystem->ReadFile("shaders/vert.spv");
-    auto fragShaderCode = m_fileSystem->ReadFile("shaders/frag.spv");
-
-    VkShaderModule vertShaderModule = CreateShaderModule(vertShaderCode);
-    VkShaderModule fragShaderModule = CreateShaderModule(fragShaderCode);
-
-    VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
-    vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-    vertShaderStageInfo.module = vertShaderModule;
-    vertShaderStageInfo.pName = "main";
-
-    VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
-    fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    fragShaderStageInfo.module = fragShaderModule;
-    fragShaderStageInfo.pName = "main";
-
-    VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
-
-    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInputInfo.vertexBindingDescriptionCount = 0;
-    vertexInputInfo.pVertexBindingDescriptions = nullptr; // Optional
-    vertexInputInfo.vertexAttributeDescriptionCount = 0;
-    vertexInputInfo.pVertexAttributeDescriptions = nullptr; // Optional
-
-    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-    inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-    std::vector<VkDynamicState> dynamicStates = {
-    VK_DYNAMIC_STATE_VIEWPORT,
-    VK_DYNAMIC_STATE_SCISSOR
-    };
+    m_shaderOverrideDirectory = i_shaderOverrideDirectory;
+    m_shaderPermutation = i_shaderPermutation;
 
-    VkPipelineDynamicStateCreateInfo dynamicState{};
-    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-    dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
-    dynamicState.pDynamicStates = dynamicStates.data();
-
-    VkPipelineViewportStateCreateInfo viewportState{};
-    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    viewportState.viewportCount = 1;
-    viewportState.scissorCount = 1;
-
-    VkPipelineRasterizationStateCreateInfo rasterizer{};
-    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterizer.depthClampEnable = VK_FALSE;
-    rasterizer.rasterizerDiscardEnable = VK_FALSE;
-    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-    rasterizer.lineWidth = 1.0f;
-    rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-    rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
-    rasterizer.depthBiasEnable = VK_FALSE;
-    rasterizer.depthBiasConstantFactor = 0.0f; // Optional
-    rasterizer.depthBiasClamp = 0.0f; // Optional
-    rasterizer.depthBiasSlopeFactor = 0.0f; // Optional
-
-    VkPipelineMultisampleStateCreateInfo multisampling{};
-    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    multisampling.sampleShadingEnable = VK_FALSE;
-    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-    multisampling.minSampleShading = 1.0f; // Optional
-    multisampling.pSampleMask = nullptr; // Optional
-    multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
-    multisampling.alphaToOneEnable = VK_FALSE; // Optional
+    // Kept alive until the compiler is done with them
+    ShaderReflection vertReflection;
+    ShaderReflection fragReflection;
+    m_vertShaderModule = LoadShaderModule("vert", vertReflection);
+    m_fragShaderModule = LoadShaderModule("frag", fragReflection);
 
     VkPipelineColorBlendAttachmentState colorBlendAttachment{};
     colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
@@ -472,226 +695,964 @@ void Instance::CreateGraphicsPipeline()
     colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
     colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD; // Optional
 
-    VkPipelineColorBlendStateCreateInfo colorBlending{};
-    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    colorBlending.logicOpEnable = VK_FALSE;
-    colorBlending.logicOp = VK_LOGIC_OP_COPY; // Optional
-    colorBlending.attachmentCount = 1;
-    colorBlending.pAttachments = &colorBlendAttachment;
-    colorBlending.blendConstants[0] = 0.0f; // Optional
-    colorBlending.blendConstants[1] = 0.0f; // Optional
-    colorBlending.blendConstants[2] = 0.0f; // Optional
-    colorBlending.blendConstants[3] = 0.0f; // Optional
-
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 0; // Optional
-    pipelineLayoutInfo.pSetLayouts = nullptr; // Optional
-    pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
-    pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
-
-    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create pipeline layout!");
+    GraphicsPipelineDesc desc;
+    desc.shaderStages.push_back({ VK_SHADER_STAGE_VERTEX_BIT, m_vertShaderModule, "main" });
+    desc.shaderStages.push_back({ VK_SHADER_STAGE_FRAGMENT_BIT, m_fragShaderModule, "main" });
+    desc.colorBlendAttachments.push_back(colorBlendAttachment);
+    ApplyShaderInterface(vertReflection, fragReflection, desc);
+    m_pipelineLayout = desc.layout;
+    desc.colorFormats.push_back(m_swapChainImageFormat);
+    desc.renderPass = m_renderPass;
+    desc.subpass = 0;
+    m_graphicsPipelineDesc = desc;
+
+    // Embedded shaders can't change, only an override directory is worth watching
+    if (!m_shaderOverrideDirectory.empty())
+    {
+        try
+        {
+            m_shaderWatcher = std::make_unique<FileWatcher>(m_shaderOverrideDirectory);
+            std::cout << "watching " << m_shaderOverrideDirectory << " for shader changes" << std::endl;
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "shader hot reload disabled: " << e.what() << std::endl;
+        }
     }
 
-    VkGraphicsPipelineCreateInfo pipelineInfo{};
-    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipelineInfo.stageCount = 2;
-    pipelineInfo.pStages = shaderStages;
-    pipelineInfo.pVertexInputState = &vertexInputInfo;
-    pipelineInfo.pInputAssemblyState = &inputAssembly;
-    pipelineInfo.pViewportState = &viewportState;
-    pipelineInfo.pRasterizationState = &rasterizer;
-    pipelineInfo.pMultisampleState = &multisampling;
-    pipelineInfo.pDepthStencilState = nullptr; // Optional
-    pipelineInfo.pColorBlendState = &colorBlending;
-    pipelineInfo.pDynamicState = &dynamicState;
-    pipelineInfo.layout = m_pipelineLayout;
-    pipelineInfo.renderPass = m_renderPass;
-    pipelineInfo.subpass = 0;
-    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
-    pipelineInfo.basePipelineIndex = -1; // Optional
-
-    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_graphicsPipeline) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create graphics pipeline!");
-    }
+    // Compiled in the background, frames are recorded without the draw until it is ready
+    m_graphicsPipeline = m_pipelineStateCache->GetPipeline(desc, m_shaderPermutation, [pipelineCache](VkPipeline i_pipeline, double i_compileMilliseconds)
+    {
+        if (i_pipeline == VK_NULL_HANDLE)
+        {
+            return;
+        }
 
-    vkDestroyShaderModule(device, fragShaderModule, nullptr);
-    vkDestroyShaderModule(device, vertShaderModule, nullptr);
+        if (pipelineCache->IsWarm())
+        {
+            std::cout << "graphics pipeline compiled in " << i_compileMilliseconds << " ms (warm cache";
+            if (pipelineCache->GetColdCreateMilliseconds() > 0.0)
+            {
+                std::cout << ", cold start took " << pipelineCache->GetColdCreateMilliseconds() << " ms";
+            }
+            std::cout << ")" << std::endl;
+        }
+        else
+        {
+            pipelineCache->SetColdCreateMilliseconds(i_compileMilliseconds);
+            std::cout << "graphics pipeline compiled in " << i_compileMilliseconds << " ms (cold cache)" << std::endl;
+        }
+    });
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-int Instance::RateDeviceSuitability(VkPhysicalDevice i_device)
+void Instance::CreateFramebuffers()
 {
-    if (!IsDeviceSuitable(i_device))
+    // Image views are attached when rendering begins
+    if (m_dynamicRendering)
     {
-        return 0;
+        return;
     }
 
-    VkPhysicalDeviceProperties properties;
-    VkPhysicalDeviceFeatures features;
-    int score = 0;
-
-    vkGetPhysicalDeviceProperties(i_device, &properties);
-    vkGetPhysicalDeviceFeatures(i_device, &features);
+    LogicalDevice* logicalDevice = m_physicalDevice->GetLogicalDevice();
+    assert(logicalDevice != nullptr);
 
-    // Discrete GPUs have a significant performance advantage
-    if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+    m_swapChainFramebuffers.resize(m_swapChainImageViews.size());
+    for (size_t i = 0; i < m_swapChainImageViews.size(); i++)
     {
-        score += 1000;
-    }
-
-    // Maximum possible size of textures affects graphics quality
-    score += properties.limits.maxImageDimension2D;
-
-    // Application can't function without geometry shaders
-    if (!features.geometryShader) {
-        return 0;
+        VkImageView attachments[] = { m_swapChainImageViews[i] };
+
+        VkFramebufferCreateInfo framebufferInfo{};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = m_renderPass;
+        framebufferInfo.attachmentCount = 1;
+        framebufferInfo.pAttachments = attachments;
+        framebufferInfo.width = m_swapChainExtent.width;
+        framebufferInfo.height = m_swapChainExtent.height;
+        framebufferInfo.layers = 1;
+
+        if (vkCreateFramebuffer(logicalDevice->GetDevice(), &framebufferInfo, m_hostAllocator->GetCallbacks("Instance::CreateFramebuffers"), &m_swapChainFramebuffers[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create framebuffer!");
+        }
     }
-
-    return score;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-bool Instance::IsDeviceSuitable(VkPhysicalDevice i_device)
+void Instance::CreateCommandPool()
 {
-    QueueFamilyIndices indices = FindQueueFamily(i_device);
+    LogicalDevice* logicalDevice = m_physicalDevice->GetLogicalDevice();
+    assert(logicalDevice != nullptr);
+    QueueFamilyIndices indices = m_physicalDevice->GetQueueFamilyIndices();
 
-    bool extensionsSupported = CheckDeviceExtensionSupport(i_device);
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = indices.optGraphicsFamily.value();
 
-    bool swapChainAdequate = false;
-    if (extensionsSupported) {
-        SwapChainSupportDetails swapChainSupport = QuerySwapChainSupport(i_device);
-        swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
+    if (vkCreateCommandPool(logicalDevice->GetDevice(), &poolInfo, m_hostAllocator->GetCallbacks("Instance::CreateCommandPool"), &m_commandPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create command pool!");
     }
-
-    return indices.IsComplete() && extensionsSupported && swapChainAdequate;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-QueueFamilyIndices Instance::FindQueueFamily(VkPhysicalDevice i_device)
+void Instance::CreateCommandBuffers(uint32_t i_framesInFlight, bool i_gpuCounters)
 {
-    QueueFamilyIndices indices;
-    uint32_t count = 0;
-    vkGetPhysicalDeviceQueueFamilyProperties(i_device, &count, nullptr);
+    assert(i_framesInFlight > 0);
+    LogicalDevice* logicalDevice = m_physicalDevice->GetLogicalDevice();
+    assert(logicalDevice != nullptr);
 
-    std::vector<VkQueueFamilyProperties> families(count);
-    vkGetPhysicalDeviceQueueFamilyProperties(i_device, &count, families.data());
+    std::vector<VkCommandBuffer> commandBuffers(i_framesInFlight);
 
-    int i = 0;
-    for (const VkQueueFamilyProperties& family : families)
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = m_commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = i_framesInFlight;
+
+    if (vkAllocateCommandBuffers(logicalDevice->GetDevice(), &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate command buffers!");
+    }
+
+    m_frames.resize(i_framesInFlight);
+    for (uint32_t i = 0; i < i_framesInFlight; i++)
     {
-        if (family.queueFlags & VK_QUEUE_GRAPHICS_BIT)
-        {
-            indices.optGraphicsFamily = i;
-        }
+        m_frames[i].commandBuffer = commandBuffers[i];
+    }
 
-        VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(i_device, i, m_surface->GetSurface(), &presentSupport);
-        if (presentSupport)
-        {
-            indices.optPresentFamily = i;
-        }
+    QueueFamilyIndices indices = m_physicalDevice->GetQueueFamilyIndices();
+    const uint32_t graphicsFamily = indices.optGraphicsFamily.value();
+    m_stagingRing = std::make_unique<StagingRing>(*logicalDevice->GetMemoryAllocator(), logicalDevice->GetDevice(), m_commandPool, graphicsFamily,
+        indices.GetTransferFamily(), logicalDevice->GetTransferQueue(), k_stagingBytesPerFrame, i_framesInFlight, m_hostAllocator->GetCallbacks("StagingRing"));
+
+    // Written by the staging copies only, the slot of a frame is rewritten once its fence has signaled
+    VkBufferCreateInfo vertexBufferInfo{};
+    vertexBufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    vertexBufferInfo.size = sizeof(k_triangleVertices) * i_framesInFlight;
+    vertexBufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    vertexBufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(logicalDevice->GetDevice(), &vertexBufferInfo, m_hostAllocator->GetCallbacks("Instance::CreateCommandBuffers"), &m_vertexBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create vertex buffer!");
+    }
+    m_vertexMemory = logicalDevice->GetMemoryAllocator()->AllocateForBuffer(m_vertexBuffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-        if (indices.IsComplete())
-        {
-            break;
-        }
+    const bool gpuCounters = i_gpuCounters && logicalDevice->GetFeatures().pipelineStatisticsQuery;
+    if (i_gpuCounters && !gpuCounters)
+    {
+        std::cout << "pipeline statistics queries not available, profiling timings only" << std::endl;
+    }
 
-        i++;
+    const bool preciseOcclusion = logicalDevice->GetFeatures().occlusionQueryPrecise;
+    if (gpuCounters && !preciseOcclusion)
+    {
+        std::cout << "precise occlusion queries not available, reporting visibility only" << std::endl;
     }
 
-    return indices;
+    m_gpuProfiler = std::make_unique<GpuProfiler>(m_physicalDevice->GetDevice(), logicalDevice->GetDevice(), graphicsFamily, i_framesInFlight, gpuCounters,
+        preciseOcclusion, m_hostAllocator->GetCallbacks("GpuProfiler"));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-bool Instance::CheckDeviceExtensionSupport(VkPhysicalDevice i_device)
+void Instance::CreateSyncObjects()
 {
-    uint32_t extensionCount;
-    vkEnumerateDeviceExtensionProperties(i_device, nullptr, &extensionCount, nullptr);
+    LogicalDevice* logicalDevice = m_physicalDevice->GetLogicalDevice();
+    assert(logicalDevice != nullptr);
+    VkDevice device = logicalDevice->GetDevice();
 
-    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
-    vkEnumerateDeviceExtensionProperties(i_device, nullptr, &extensionCount, availableExtensions.data());
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-    std::set<std::string> requiredExtensions(k_deviceExtensions.begin(), k_deviceExtensions.end());
+    // Signaled so the first wait on every frame slot returns immediately
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-    for (const auto& extension : availableExtensions)
+    const VkAllocationCallbacks* allocator = m_hostAllocator->GetCallbacks("Instance::CreateSyncObjects");
+    for (FrameResources& frame : m_frames)
     {
-        requiredExtensions.erase(extension.extensionName);
+        if (vkCreateSemaphore(device, &semaphoreInfo, allocator, &frame.imageAvailableSemaphore) != VK_SUCCESS
+            || vkCreateFence(device, &fenceInfo, allocator, &frame.inFlightFence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create synchronization objects for a frame!");
+        }
     }
 
-    return requiredExtensions.empty();
+    CreateSwapChainSemaphores();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-SwapChainSupportDetails Instance::QuerySwapChainSupport(VkPhysicalDevice i_device)
+void Instance::CreateSwapChainSemaphores()
 {
-    SwapChainSupportDetails details;
-    VkSurfaceKHR surface = m_surface->GetSurface();
+    LogicalDevice* logicalDevice = m_physicalDevice->GetLogicalDevice();
+    assert(logicalDevice != nullptr);
 
-    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(i_device, surface, &details.capabilities);
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-    uint32_t formatCount;
+    m_renderFinishedSemaphores.resize(m_swapChainImages.size());
+    for (VkSemaphore& semaphore : m_renderFinishedSemaphores)
     {
-        vkGetPhysicalDeviceSurfaceFormatsKHR(i_device, surface, &formatCount, nullptr);
-
-        if (formatCount != 0) {
-            details.formats.resize(formatCount);
-            vkGetPhysicalDeviceSurfaceFormatsKHR(i_device, surface, &formatCount, details.formats.data());
+        if (vkCreateSemaphore(logicalDevice->GetDevice(), &semaphoreInfo, m_hostAllocator->GetCallbacks("Instance::CreateSwapChainSemaphores"), &semaphore) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create synchronization objects for a swapchain image!");
         }
     }
+}
 
-    uint32_t presentModeCount;
+///////////////////////////////////////////////////////////////////////////////
+
+void Instance::DrawFrame()
+{
+    CPU_TRACE_ZONE("Instance::DrawFrame");
+
+    LogicalDevice* logicalDevice = m_physicalDevice->GetLogicalDevice();
+    assert(logicalDevice != nullptr);
+    VkDevice device = logicalDevice->GetDevice();
+    FrameResources& frame = m_frames[m_currentFrame];
+
+    // Only this slot's previous submission has to be retired, the other slots keep the GPU busy
+    // while the CPU records this one
     {
-        vkGetPhysicalDeviceSurfacePresentModesKHR(i_device, surface, &presentModeCount, nullptr);
+        CPU_TRACE_ZONE("wait for frame fence");
+        vkWaitForFences(device, 1, &frame.inFlightFence, VK_TRUE, UINT64_MAX);
+    }
 
-        if (presentModeCount != 0) {
-            details.presentModes.resize(presentModeCount);
-            vkGetPhysicalDeviceSurfacePresentModesKHR(i_device, surface, &presentModeCount, details.presentModes.data());
-        }
+    // Every frame before the ones still owned by the other slots has completed
+    const uint64_t framesInFlight = m_frames.size();
+    const uint64_t oldestPendingFrame = m_frameNumber + 1 > framesInFlight ? m_frameNumber + 1 - framesInFlight : 0;
+    m_deletionQueue.Flush(oldestPendingFrame);
+
+    // The slot's staging partition was consumed by the submission the fence just retired
+    m_stagingRing->BeginFrame(m_currentFrame);
+
+    UpdateShaderHotReload();
+
+    if (m_presentTarget == PresentTarget::Offscreen)
+    {
+        DrawOffscreenFrame(frame);
+        return;
     }
 
-    return details;
-}
+    uint32_t imageIndex;
+    VkResult acquireResult;
+    {
+        CPU_TRACE_ZONE("acquire image");
+        acquireResult = vkAcquireNextImageKHR(device, m_swapChain, UINT64_MAX, frame.imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
+    }
+    if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR) {
+        // Nothing was acquired, the fence stays signaled and the slot is reused next frame
+        RecreateSwapChain();
+        return;
+    }
+    if (acquireResult != VK_SUCCESS && acquireResult != VK_SUBOPTIMAL_KHR) {
+        throw std::runtime_error("failed to acquire swap chain image!");
+    }
 
-///////////////////////////////////////////////////////////////////////////////
+    vkResetFences(device, 1, &frame.inFlightFence);
 
-VkSurfaceFormatKHR Instance::ChooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& i_availableFormats)
-{
-    for (const auto& availableFormat : i_availableFormats) {
-        if (availableFormat.format == VK_FORMAT_B8G8R8A8_SRGB && availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
-            return availableFormat;
-        }
+    vkResetCommandBuffer(frame.commandBuffer, 0);
+    RecordCommandBuffer(frame.commandBuffer, imageIndex);
+
+    VkCommandBuffer commandBuffers[2];
+    VkSemaphore waitSemaphores[2] = { frame.imageAvailableSemaphore };
+    VkPipelineStageFlags waitStages[2] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+    uint32_t waitSemaphoreCount = 1;
+    const uint32_t commandBufferCount = GatherCommandBuffers(frame, commandBuffers, waitSemaphores[1], waitStages[1]);
+    if (waitSemaphores[1] != VK_NULL_HANDLE)
+    {
+        waitSemaphoreCount++;
     }
 
-    return i_availableFormats[0];
-}
+    VkSemaphore signalSemaphores[] = { m_renderFinishedSemaphores[imageIndex] };
 
-///////////////////////////////////////////////////////////////////////////////
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.waitSemaphoreCount = waitSemaphoreCount;
+    submitInfo.pWaitSemaphores = waitSemaphores;
+    submitInfo.pWaitDstStageMask = waitStages;
+    submitInfo.commandBufferCount = commandBufferCount;
+    submitInfo.pCommandBuffers = commandBuffers;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = signalSemaphores;
 
-VkPresentModeKHR Instance::ChooseSwapPresentMode(const std::vector<VkPresentModeKHR>& i_availablePresentModes)
-{
-    for (const auto& availablePresentMode : i_availablePresentModes) {
-        if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-            return availablePresentMode;
+    {
+        CPU_TRACE_ZONE("submit");
+        if (vkQueueSubmit(logicalDevice->GetGraphicsQueue(), 1, &submitInfo, frame.inFlightFence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit draw command buffer!");
         }
     }
 
-    return VK_PRESENT_MODE_FIFO_KHR;
+    VkPresentInfoKHR presentInfo{};
+    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    presentInfo.waitSemaphoreCount = 1;
+    presentInfo.pWaitSemaphores = signalSemaphores;
+    presentInfo.swapchainCount = 1;
+    presentInfo.pSwapchains = &m_swapChain;
+    presentInfo.pImageIndices = &imageIndex;
+
+    VkResult presentResult;
+    {
+        CPU_TRACE_ZONE("present");
+        presentResult = vkQueuePresentKHR(logicalDevice->GetPresentQueue(), &presentInfo);
+    }
+
+    m_frameNumber++;
+    m_currentFrame = (m_currentFrame + 1) % static_cast<uint32_t>(m_frames.size());
+
+    const bool windowResized = m_window != nullptr && m_window->ConsumeResized();
+    if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR || windowResized) {
+        RecreateSwapChain();
+    }
+    else if (presentResult != VK_SUCCESS) {
+        throw std::runtime_error("failed to present swap chain image!");
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-VkExtent2D Instance::ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& i_capabilities)
+void Instance::DrawOffscreenFrame(FrameResources& i_frame)
 {
-    if (i_capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) 
-    {
-        return i_capabilities.currentExtent;
+    LogicalDevice* logicalDevice = m_physicalDevice->GetLogicalDevice();
+    assert(logicalDevice != nullptr);
+    VkDevice device = logicalDevice->GetDevice();
+
+    // No presentation engine hands out images, cycle through them and wait for whichever frame last used one
+    const uint32_t imageIndex = static_cast<uint32_t>(m_frameNumber % m_swapChainImages.size());
+    if (m_imagesInFlight[imageIndex] != VK_NULL_HANDLE && m_imagesInFlight[imageIndex] != i_frame.inFlightFence) {
+        CPU_TRACE_ZONE("wait for image fence");
+        vkWaitForFences(device, 1, &m_imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+    }
+    m_imagesInFlight[imageIndex] = i_frame.inFlightFence;
+
+    vkResetFences(device, 1, &i_frame.inFlightFence);
+
+    vkResetCommandBuffer(i_frame.commandBuffer, 0);
+    RecordCommandBuffer(i_frame.commandBuffer, imageIndex);
+
+    VkCommandBuffer commandBuffers[2];
+    VkSemaphore stagingSemaphore;
+    VkPipelineStageFlags stagingStage;
+    const uint32_t commandBufferCount = GatherCommandBuffers(i_frame, commandBuffers, stagingSemaphore, stagingStage);
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    if (stagingSemaphore != VK_NULL_HANDLE)
+    {
+        submitInfo.waitSemaphoreCount = 1;
+        submitInfo.pWaitSemaphores = &stagingSemaphore;
+        submitInfo.pWaitDstStageMask = &stagingStage;
+    }
+    submitInfo.commandBufferCount = commandBufferCount;
+    submitInfo.pCommandBuffers = commandBuffers;
+
+    {
+        CPU_TRACE_ZONE("submit");
+        if (vkQueueSubmit(logicalDevice->GetGraphicsQueue(), 1, &submitInfo, i_frame.inFlightFence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit draw command buffer!");
+        }
+    }
+
+    m_frameNumber++;
+    m_currentFrame = (m_currentFrame + 1) % static_cast<uint32_t>(m_frames.size());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+uint32_t Instance::GatherCommandBuffers(FrameResources& i_frame, VkCommandBuffer (&o_commandBuffers)[2], VkSemaphore& o_waitSemaphore, VkPipelineStageFlags& o_waitStage)
+{
+    uint32_t count = 0;
+
+    // The staging command buffer either holds the copies or acquires what the transfer queue wrote,
+    // both end in a barrier against every later command on the queue
+    StagingRing::Submission staging = m_stagingRing->EndFrame();
+    if (staging.commandBuffer != VK_NULL_HANDLE)
+    {
+        o_commandBuffers[count++] = staging.commandBuffer;
+    }
+    o_waitSemaphore = staging.waitSemaphore;
+    o_waitStage = staging.waitStage;
+    o_commandBuffers[count++] = i_frame.commandBuffer;
+
+    return count;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Instance::CaptureFrame(const std::string& i_fileName)
+{
+    if (m_offscreenTarget == nullptr)
+    {
+        throw std::runtime_error("frame capture needs an offscreen target!");
+    }
+    if (m_frameNumber == 0)
+    {
+        throw std::runtime_error("no frame was rendered to capture!");
+    }
+
+    LogicalDevice* logicalDevice = m_physicalDevice->GetLogicalDevice();
+    assert(logicalDevice != nullptr);
+    vkDeviceWaitIdle(logicalDevice->GetDevice());
+
+    const uint32_t imageIndex = static_cast<uint32_t>((m_frameNumber - 1) % m_swapChainImages.size());
+    std::vector<uint8_t> pixels = m_offscreenTarget->ReadPixels(imageIndex, m_commandPool, logicalDevice->GetGraphicsQueue());
+
+    const std::string header = "P6\n" + std::to_string(m_swapChainExtent.width) + " " + std::to_string(m_swapChainExtent.height) + "\n255\n";
+    std::vector<char> file(header.begin(), header.end());
+    file.insert(file.end(), pixels.begin(), pixels.end());
+
+    m_fileSystem->WriteFile(i_fileName, file);
+    std::cout << "captured frame " << m_frameNumber - 1 << " to " << i_fileName << std::endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Instance::RecreateSwapChain()
+{
+    // Minimized, the swapchain is rebuilt once the window has a size again
+    if (m_window != nullptr && m_window->IsMinimized())
+    {
+        return;
+    }
+
+    const VkFormat previousFormat = m_swapChainImageFormat;
+
+    RetireSwapChain();
+    CreateSwapChain();
+
+    if (m_swapChainImageFormat != previousFormat)
+    {
+        // The render pass and every pipeline built against it would have to be rebuilt
+        throw std::runtime_error("swap chain format changed on recreation!");
+    }
+
+    CreateImageViews();
+    CreateFramebuffers();
+    CreateSwapChainSemaphores();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Instance::RetireSwapChain()
+{
+    LogicalDevice* logicalDevice = m_physicalDevice->GetLogicalDevice();
+    assert(logicalDevice != nullptr);
+    VkDevice device = logicalDevice->GetDevice();
+
+    // The handle stays in m_swapChain so CreateSwapChain passes it as oldSwapchain,
+    // everything else moves out and is destroyed once the frames that used it retire
+    VkSwapchainKHR swapChain = m_swapChain;
+    std::vector<VkImageView> imageViews = std::move(m_swapChainImageViews);
+    std::vector<VkFramebuffer> framebuffers = std::move(m_swapChainFramebuffers);
+    std::vector<VkSemaphore> semaphores = std::move(m_renderFinishedSemaphores);
+    m_swapChainImageViews.clear();
+    m_swapChainFramebuffers.clear();
+    m_renderFinishedSemaphores.clear();
+    m_swapChainImages.clear();
+
+    // The host allocator outlives the deletion queue, it is the last member to go
+    HostAllocator* hostAllocator = m_hostAllocator.get();
+    m_deletionQueue.Push(m_frameNumber, [device, swapChain, imageViews, framebuffers, semaphores, hostAllocator]()
+    {
+        for (VkFramebuffer framebuffer : framebuffers) {
+            vkDestroyFramebuffer(device, framebuffer, hostAllocator->GetCallbacks("Instance::CreateFramebuffers"));
+        }
+        for (VkImageView imageView : imageViews) {
+            vkDestroyImageView(device, imageView, hostAllocator->GetCallbacks("Instance::CreateImageViews"));
+        }
+        for (VkSemaphore semaphore : semaphores) {
+            vkDestroySemaphore(device, semaphore, hostAllocator->GetCallbacks("Instance::CreateSwapChainSemaphores"));
+        }
+        vkDestroySwapchainKHR(device, swapChain, hostAllocator->GetCallbacks("Instance::CreateSwapChain"));
+    });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Instance::WaitIdle()
+{
+    LogicalDevice* logicalDevice = m_physicalDevice->GetLogicalDevice();
+    assert(logicalDevice != nullptr);
+
+    vkDeviceWaitIdle(logicalDevice->GetDevice());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Instance::WaitForPipelines()
+{
+    m_pipelineCompiler->WaitIdle();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Instance::SavePipelineCache()
+{
+    LogicalDevice* logicalDevice = m_physicalDevice->GetLogicalDevice();
+    assert(logicalDevice != nullptr);
+
+    // Pipelines still compiling would be missing from the saved blob
+    m_pipelineCompiler->WaitIdle();
+    logicalDevice->GetPipelineCache()->Save(*m_fileSystem, k_pipelineCacheFileName);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Instance::PrintMemoryStatistics()
+{
+    LogicalDevice* logicalDevice = m_physicalDevice->GetLogicalDevice();
+    assert(logicalDevice != nullptr);
+    logicalDevice->GetMemoryAllocator()->PrintStatistics();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Instance::PrintPipelineStatistics()
+{
+    m_pipelineStateCache->PrintStatistics();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Instance::PrintGpuStatistics()
+{
+    // The last frames in flight were never collected, their slots did not come around again
+    m_gpuProfiler->Flush();
+    m_gpuProfiler->PrintStatistics();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Instance::PrintHostAllocationStatistics()
+{
+    m_hostAllocator->PrintStatistics();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Instance::BenchmarkCommandRecording(uint32_t i_drawCount)
+{
+    using Clock = std::chrono::steady_clock;
+
+    LogicalDevice* logicalDevice = m_physicalDevice->GetLogicalDevice();
+    assert(logicalDevice != nullptr);
+    VkDevice device = logicalDevice->GetDevice();
+    const uint32_t graphicsFamily = m_physicalDevice->GetQueueFamilyIndices().optGraphicsFamily.value();
+
+    const VkPipeline pipeline = m_graphicsPipeline.Wait();
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = m_commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+
+    VkCommandBuffer primary;
+    if (vkAllocateCommandBuffers(device, &allocInfo, &primary) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate benchmark command buffer!");
+    }
+
+    VkCommandBufferInheritanceRenderingInfo inheritanceRendering{};
+    inheritanceRendering.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+    inheritanceRendering.colorAttachmentCount = 1;
+    inheritanceRendering.pColorAttachmentFormats = &m_swapChainImageFormat;
+    inheritanceRendering.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkCommandBufferInheritanceInfo inheritance{};
+    inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    if (m_dynamicRendering)
+    {
+        inheritance.pNext = &inheritanceRendering;
+    }
+    else
+    {
+        inheritance.renderPass = m_renderPass;
+        inheritance.subpass = 0;
+        inheritance.framebuffer = m_swapChainFramebuffers[0];
+    }
+
+    VkViewport viewport{};
+    viewport.width = static_cast<float>(m_swapChainExtent.width);
+    viewport.height = static_cast<float>(m_swapChainExtent.height);
+    viewport.maxDepth = 1.0f;
+
+    VkRect2D scissor{};
+    scissor.extent = m_swapChainExtent;
+
+    // Secondaries inherit no state, every chunk binds and sets its own
+    const VkDeviceSize vertexOffset = 0;
+    const ParallelCommandRecorder::RecordFunction record = [&](VkCommandBuffer i_commandBuffer, uint32_t i_first, uint32_t i_count) {
+        vkCmdBindPipeline(i_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        vkCmdSetViewport(i_commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(i_commandBuffer, 0, 1, &scissor);
+        vkCmdBindVertexBuffers(i_commandBuffer, 0, 1, &m_vertexBuffer, &vertexOffset);
+        for (uint32_t i = 0; i < i_count; i++)
+        {
+            vkCmdDraw(i_commandBuffer, static_cast<uint32_t>(std::size(k_triangleVertices)), 1, 0, i_first + i);
+        }
+    };
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    std::vector<uint32_t> threadCounts;
+    const uint32_t coreCount = std::max(1u, std::thread::hardware_concurrency());
+    for (uint32_t threadCount = 1; threadCount < coreCount; threadCount *= 2)
+    {
+        threadCounts.push_back(threadCount);
+    }
+    threadCounts.push_back(coreCount);
+
+    std::cout << "recording " << i_drawCount << " draws in chunks of " << k_recordBenchmarkChunkSize << ", best of " << k_recordBenchmarkRuns << " runs" << std::endl;
+
+    double singleThreadMilliseconds = 0.0;
+    for (uint32_t threadCount : threadCounts)
+    {
+        JobSystem jobSystem(threadCount);
+        ParallelCommandRecorder recorder(jobSystem, device, graphicsFamily, 1, m_hostAllocator->GetCallbacks("ParallelCommandRecorder"));
+
+        double bestMilliseconds = 0.0;
+        // One extra run first so pools and secondaries are allocated before timing
+        for (uint32_t run = 0; run <= k_recordBenchmarkRuns; run++)
+        {
+            const Clock::time_point start = Clock::now();
+
+            recorder.BeginFrame(0);
+            vkResetCommandBuffer(primary, 0);
+            vkBeginCommandBuffer(primary, &beginInfo);
+            BeginRenderTarget(primary, 0, true);
+            recorder.Record(primary, inheritance, i_drawCount, k_recordBenchmarkChunkSize, record);
+            EndRenderTarget(primary, 0);
+            vkEndCommandBuffer(primary);
+
+            const double milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            if (run > 0 && (bestMilliseconds == 0.0 || milliseconds < bestMilliseconds))
+            {
+                bestMilliseconds = milliseconds;
+            }
+        }
+
+        if (threadCount == 1)
+        {
+            singleThreadMilliseconds = bestMilliseconds;
+        }
+
+        std::cout << std::fixed << std::setprecision(2)
+            << "  " << threadCount << " threads: " << bestMilliseconds << " ms, "
+            << singleThreadMilliseconds / bestMilliseconds << "x" << std::endl;
+    }
+
+    vkFreeCommandBuffers(device, m_commandPool, 1, &primary);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Instance::BenchmarkUploads(uint32_t i_uploadCount)
+{
+    using Clock = std::chrono::steady_clock;
+
+    LogicalDevice* logicalDevice = m_physicalDevice->GetLogicalDevice();
+    assert(logicalDevice != nullptr);
+    VkDevice device = logicalDevice->GetDevice();
+    MemoryAllocator* memoryAllocator = logicalDevice->GetMemoryAllocator();
+
+    if (i_uploadCount > m_stagingRing->GetBytesPerFrame() / k_uploadBenchmarkSize) {
+        throw std::runtime_error("upload benchmark does not fit into a staging partition!");
+    }
+
+    // Every upload gets its own range of one destination, like the per object constants of a scene
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = k_uploadBenchmarkSize * i_uploadCount;
+    bufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VkBuffer buffer;
+    if (vkCreateBuffer(device, &bufferInfo, m_hostAllocator->GetCallbacks("Instance::BenchmarkUploads"), &buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create upload benchmark buffer!");
+    }
+    MemoryAllocation memory = memoryAllocator->AllocateForBuffer(buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    float matrix[k_uploadBenchmarkSize / sizeof(float)] = {};
+    const uint32_t framesInFlight = static_cast<uint32_t>(m_frames.size());
+
+    StagingRing::Statistics stagingBefore;
+    MemoryAllocator::Statistics memoryBefore;
+    uint64_t hostAllocationsBefore = 0;
+    double cpuMilliseconds = 0.0;
+
+    std::cout << "uploading " << i_uploadCount << " ranges of " << k_uploadBenchmarkSize << " bytes per frame, " << k_uploadBenchmarkFrames << " frames" << std::endl;
+
+    // The first frame of every slot grows the staging ring's copy lists, counting starts after them
+    for (uint32_t frameIndex = 0; frameIndex < framesInFlight + k_uploadBenchmarkFrames; frameIndex++)
+    {
+        if (frameIndex == framesInFlight)
+        {
+            stagingBefore = m_stagingRing->GetStatistics();
+            memoryBefore = memoryAllocator->GetStatistics();
+            hostAllocationsBefore = CountHostAllocations(m_hostAllocator->GetStatistics());
+        }
+
+        FrameResources& frame = m_frames[m_currentFrame];
+        vkWaitForFences(device, 1, &frame.inFlightFence, VK_TRUE, UINT64_MAX);
+        vkResetFences(device, 1, &frame.inFlightFence);
+
+        const Clock::time_point start = Clock::now();
+
+        m_stagingRing->BeginFrame(m_currentFrame);
+        matrix[0] = static_cast<float>(frameIndex);
+        for (uint32_t i = 0; i < i_uploadCount; i++)
+        {
+            matrix[1] = static_cast<float>(i);
+            m_stagingRing->UploadToBuffer(matrix, sizeof(matrix), buffer, i * k_uploadBenchmarkSize);
+        }
+        const StagingRing::Submission staging = m_stagingRing->EndFrame();
+
+        if (frameIndex >= framesInFlight)
+        {
+            cpuMilliseconds += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        }
+
+        // Stands in for the frame's own submit, which would carry its command buffer after the staging one
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        if (staging.waitSemaphore != VK_NULL_HANDLE)
+        {
+            submitInfo.waitSemaphoreCount = 1;
+            submitInfo.pWaitSemaphores = &staging.waitSemaphore;
+            submitInfo.pWaitDstStageMask = &staging.waitStage;
+        }
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &staging.commandBuffer;
+
+        if (vkQueueSubmit(logicalDevice->GetGraphicsQueue(), 1, &submitInfo, frame.inFlightFence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit upload benchmark frame!");
+        }
+
+        m_frameNumber++;
+        m_currentFrame = (m_currentFrame + 1) % framesInFlight;
+    }
+
+    const StagingRing::Statistics stagingAfter = m_stagingRing->GetStatistics();
+    const MemoryAllocator::Statistics memoryAfter = memoryAllocator->GetStatistics();
+    const uint64_t hostAllocations = CountHostAllocations(m_hostAllocator->GetStatistics()) - hostAllocationsBefore;
+
+    vkDeviceWaitIdle(device);
+    vkDestroyBuffer(device, buffer, m_hostAllocator->GetCallbacks("Instance::BenchmarkUploads"));
+    memoryAllocator->Free(memory);
+
+    const double transferSubmits = static_cast<double>(stagingAfter.transferSubmitCount - stagingBefore.transferSubmitCount) / k_uploadBenchmarkFrames;
+    std::cout << std::fixed << std::setprecision(3)
+        << "  " << cpuMilliseconds / k_uploadBenchmarkFrames << " ms per frame to queue and record, "
+        << cpuMilliseconds * 1000000.0 / (static_cast<double>(k_uploadBenchmarkFrames) * i_uploadCount) << " ns per upload" << std::endl;
+    std::cout << std::setprecision(2)
+        << "  per frame: 1 staging command buffer in the graphics submit, " << transferSubmits << " transfer queue submits" << std::endl;
+    std::cout << "  allocations while uploading: " << stagingAfter.allocationCount - stagingBefore.allocationCount << " staging ring, "
+        << memoryAfter.vkAllocateMemoryCount - memoryBefore.vkAllocateMemoryCount << " device memory, ";
+    if (m_hostAllocator->GetMode() == HostAllocationMode::Default)
+    {
+        std::cout << "driver host memory not counted without --host-allocator" << std::endl;
+    }
+    else
+    {
+        std::cout << hostAllocations << " driver host" << std::endl;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int Instance::RateDeviceSuitability(VkPhysicalDevice i_device)
+{
+    if (!IsDeviceSuitable(i_device))
+    {
+        return 0;
+    }
+
+    VkPhysicalDeviceProperties properties;
+    VkPhysicalDeviceFeatures features;
+    int score = 0;
+
+    vkGetPhysicalDeviceProperties(i_device, &properties);
+    vkGetPhysicalDeviceFeatures(i_device, &features);
+
+    // Discrete GPUs have a significant performance advantage
+    if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+    {
+        score += 1000;
+    }
+
+    // Maximum possible size of textures affects graphics quality
+    score += properties.limits.maxImageDimension2D;
+
+    // Application can't function without geometry shaders
+    if (!features.geometryShader) {
+        return 0;
+    }
+
+    return score;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool Instance::IsDeviceSuitable(VkPhysicalDevice i_device)
+{
+    QueueFamilyIndices indices = FindQueueFamily(i_device);
+
+    bool extensionsSupported = CheckDeviceExtensionSupport(i_device);
+
+    // Offscreen rendering has no surface the device has to support
+    bool swapChainAdequate = m_surface == nullptr;
+    if (extensionsSupported && m_surface != nullptr) {
+        SwapChainSupportDetails swapChainSupport = QuerySwapChainSupport(i_device);
+        swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
+    }
+
+    return indices.IsComplete() && extensionsSupported && swapChainAdequate;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+QueueFamilyIndices Instance::FindQueueFamily(VkPhysicalDevice i_device)
+{
+    QueueFamilyIndices indices;
+    uint32_t count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(i_device, &count, nullptr);
+
+    std::vector<VkQueueFamilyProperties> families(count);
+    vkGetPhysicalDeviceQueueFamilyProperties(i_device, &count, families.data());
+
+    // Look at every family, the dedicated transfer one usually comes after graphics
+    uint32_t i = 0;
+    for (const VkQueueFamilyProperties& family : families)
+    {
+        const bool hasGraphics = (family.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+        const bool hasCompute = (family.queueFlags & VK_QUEUE_COMPUTE_BIT) != 0;
+        const bool hasTransfer = (family.queueFlags & VK_QUEUE_TRANSFER_BIT) != 0;
+
+        if (hasGraphics && !indices.optGraphicsFamily.has_value())
+        {
+            indices.optGraphicsFamily = i;
+        }
+        if (hasTransfer && !hasGraphics && !hasCompute && !indices.optTransferFamily.has_value())
+        {
+            indices.optTransferFamily = i;
+        }
+
+        VkBool32 presentSupport = false;
+        if (m_surface != nullptr)
+        {
+            vkGetPhysicalDeviceSurfaceSupportKHR(i_device, i, m_surface->GetSurface(), &presentSupport);
+        }
+        else
+        {
+            // Nothing is presented, the graphics queue doubles as the present queue
+            presentSupport = (family.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+        }
+
+        // Presenting from the graphics family avoids an ownership transfer of the swapchain image
+        if (presentSupport && (!indices.optPresentFamily.has_value() || indices.optGraphicsFamily == i))
+        {
+            indices.optPresentFamily = i;
+        }
+
+        i++;
+    }
+
+    return indices;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool Instance::CheckDeviceExtensionSupport(VkPhysicalDevice i_device)
+{
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(i_device, nullptr, &extensionCount, nullptr);
+
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(i_device, nullptr, &extensionCount, availableExtensions.data());
+
+    std::set<std::string> requiredExtensions(m_deviceExtensions.begin(), m_deviceExtensions.end());
+
+    for (const auto& extension : availableExtensions)
+    {
+        requiredExtensions.erase(extension.extensionName);
+    }
+
+    return requiredExtensions.empty();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+SwapChainSupportDetails Instance::QuerySwapChainSupport(VkPhysicalDevice i_device)
+{
+    SwapChainSupportDetails details;
+    VkSurfaceKHR surface = m_surface->GetSurface();
+
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(i_device, surface, &details.capabilities);
+
+    uint32_t formatCount;
+    {
+        vkGetPhysicalDeviceSurfaceFormatsKHR(i_device, surface, &formatCount, nullptr);
+
+        if (formatCount != 0) {
+            details.formats.resize(formatCount);
+            vkGetPhysicalDeviceSurfaceFormatsKHR(i_device, surface, &formatCount, details.formats.data());
+        }
+    }
+
+    uint32_t presentModeCount;
+    {
+        vkGetPhysicalDeviceSurfacePresentModesKHR(i_device, surface, &presentModeCount, nullptr);
+
+        if (presentModeCount != 0) {
+            details.presentModes.resize(presentModeCount);
+            vkGetPhysicalDeviceSurfacePresentModesKHR(i_device, surface, &presentModeCount, details.presentModes.data());
+        }
+    }
+
+    return details;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+VkSurfaceFormatKHR Instance::ChooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& i_availableFormats)
+{
+    for (const auto& availableFormat : i_availableFormats) {
+        if (availableFormat.format == VK_FORMAT_B8G8R8A8_SRGB && availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
+            return availableFormat;
+        }
+    }
+
+    return i_availableFormats[0];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+VkPresentModeKHR Instance::ChooseSwapPresentMode(const std::vector<VkPresentModeKHR>& i_availablePresentModes)
+{
+    for (const auto& availablePresentMode : i_availablePresentModes) {
+        if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
+            return availablePresentMode;
+        }
+    }
+
+    return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+VkExtent2D Instance::ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& i_capabilities)
+{
+    if (i_capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) 
+    {
+        return i_capabilities.currentExtent;
+    }
+    else if (m_window == nullptr)
+    {
+        return k_headlessExtent;
     }
     else 
     {
@@ -724,21 +1685,322 @@ void Instance::RetrievingSwapChainImages()
 
 ///////////////////////////////////////////////////////////////////////////////
 
-VkShaderModule Instance::CreateShaderModule(const std::vector<char>& i_code)
+VkShaderModule Instance::CreateShaderModule(const uint32_t* i_code, size_t i_codeSize)
 {
     VkShaderModuleCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = i_code.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(i_code.data());
+    createInfo.codeSize = i_codeSize;
+    createInfo.pCode = i_code;
     VkShaderModule shaderModule;
 
     LogicalDevice* logicalDevice = m_physicalDevice->GetLogicalDevice();
     assert(logicalDevice != nullptr);
-    if (vkCreateShaderModule(logicalDevice->GetDevice(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+    if (vkCreateShaderModule(logicalDevice->GetDevice(), &createInfo, m_hostAllocator->GetCallbacks("Instance::CreateShaderModule"), &shaderModule) != VK_SUCCESS) {
         throw std::runtime_error("failed to create shader module!");
     }
     return shaderModule;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+
+VkShaderModule Instance::LoadShaderModule(const std::string& i_name, ShaderReflection& o_reflection)
+{
+    if (!m_shaderOverrideDirectory.empty())
+    {
+        // Straight from disk, a mounted archive would keep serving its packed copy and hot reload would never see an edit.
+        // The driver copies the code, the mapping only has to outlive vkCreateShaderModule
+        MappedFile code(m_shaderOverrideDirectory + "/" + i_name + ".spv", FileAccess::Sequential);
+        // SPIR-V is read as words, mappings are page aligned
+        assert(reinterpret_cast<uintptr_t>(code.GetData()) % alignof(uint32_t) == 0);
+
+        // A file caught halfway through being written must not reach the driver
+        const uint32_t* words = reinterpret_cast<const uint32_t*>(code.GetData());
+        if (code.GetSize() < k_spirvHeaderSize || code.GetSize() % sizeof(uint32_t) != 0 || words[0] != k_spirvMagic) {
+            throw std::runtime_error("failed to load shader, not SPIR-V!");
+        }
+        o_reflection = ShaderReflection::Reflect(words, code.GetSize());
+        return CreateShaderModule(words, code.GetSize());
+    }
+
+    const EmbeddedShader* shader = ShaderRegistry::Find(i_name);
+    if (shader == nullptr) {
+        throw std::runtime_error("failed to find embedded shader!");
+    }
+    o_reflection = ShaderReflection::Reflect(shader->code, shader->codeSize);
+    return CreateShaderModule(shader->code, shader->codeSize);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Instance::ApplyShaderInterface(const ShaderReflection& i_vertReflection, const ShaderReflection& i_fragReflection, GraphicsPipelineDesc& io_desc)
+{
+    if (i_vertReflection.stage != VK_SHADER_STAGE_VERTEX_BIT || i_fragReflection.stage != VK_SHADER_STAGE_FRAGMENT_BIT) {
+        throw std::runtime_error("failed to create graphics pipeline, shader stages do not match!");
+    }
+
+    io_desc.shaderStages[0].entryPoint = i_vertReflection.entryPoint;
+    io_desc.shaderStages[1].entryPoint = i_fragReflection.entryPoint;
+
+    // Switches are set per request by the state cache, a bit no stage declares fails here instead of at the first draw
+    io_desc.shaderStages[0].featureBits = ShaderPermutation::GetFeatureBits(i_vertReflection);
+    io_desc.shaderStages[1].featureBits = ShaderPermutation::GetFeatureBits(i_fragReflection);
+    if ((m_shaderPermutation & ~(io_desc.shaderStages[0].featureBits | io_desc.shaderStages[1].featureBits)) != 0) {
+        throw std::runtime_error("failed to specialize shaders, the permutation sets a feature bit no shader declares!");
+    }
+    i_vertReflection.BuildVertexInput(0, io_desc.vertexBindings, io_desc.vertexAttributes);
+
+    // Shared with every pipeline declaring the same interface, owned by the cache
+    PipelineLayoutCache* pipelineLayoutCache = m_physicalDevice->GetLogicalDevice()->GetPipelineLayoutCache();
+    io_desc.layout = pipelineLayoutCache->GetPipelineLayout({ &i_vertReflection, &i_fragReflection });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Instance::UpdateShaderHotReload()
+{
+    CPU_TRACE_ZONE("Instance::UpdateShaderHotReload");
+
+    if (m_shaderWatcher == nullptr)
+    {
+        return;
+    }
+
+    for (const std::string& fileName : m_shaderWatcher->PollChanges())
+    {
+        if (fileName == "vert.spv" || fileName == "frag.spv")
+        {
+            m_shaderReloadQueued = true;
+        }
+    }
+
+    LogicalDevice* logicalDevice = m_physicalDevice->GetLogicalDevice();
+    assert(logicalDevice != nullptr);
+    VkDevice device = logicalDevice->GetDevice();
+
+    if (m_reloadedPipeline.IsValid())
+    {
+        const PipelineHandle::Status status = m_reloadedPipeline.GetStatus();
+        if (status == PipelineHandle::Status::Pending)
+        {
+            return;
+        }
+
+        if (status == PipelineHandle::Status::Ready)
+        {
+            // Frames before this one may still bind the old pipeline, the modules were only needed to compile it.
+            // The old state leaves the cache before its modules die, their handles may be reused.
+            VkPipeline oldPipeline = m_pipelineStateCache->Remove(m_graphicsPipelineDesc, m_shaderPermutation).Get();
+            const VkAllocationCallbacks* pipelineAllocator = m_pipelineCompiler->GetAllocator();
+            m_deletionQueue.Push(m_frameNumber, [device, oldPipeline, pipelineAllocator]()
+            {
+                vkDestroyPipeline(device, oldPipeline, pipelineAllocator);
+            });
+            vkDestroyShaderModule(device, m_vertShaderModule, m_hostAllocator->GetCallbacks("Instance::CreateShaderModule"));
+            vkDestroyShaderModule(device, m_fragShaderModule, m_hostAllocator->GetCallbacks("Instance::CreateShaderModule"));
+
+            m_graphicsPipeline = m_reloadedPipeline;
+            m_vertShaderModule = m_reloadedVertShaderModule;
+            m_fragShaderModule = m_reloadedFragShaderModule;
+            // The interface may have changed with the shaders, layouts stay alive in the cache
+            m_graphicsPipelineDesc = m_reloadedPipelineDesc;
+            m_pipelineLayout = m_graphicsPipelineDesc.layout;
+            std::cout << "shaders reloaded, pipeline rebuilt in " << m_graphicsPipeline.GetCompileMilliseconds() << " ms" << std::endl;
+        }
+        else
+        {
+            m_pipelineStateCache->Remove(m_reloadedPipelineDesc, m_shaderPermutation);
+            vkDestroyShaderModule(device, m_reloadedVertShaderModule, m_hostAllocator->GetCallbacks("Instance::CreateShaderModule"));
+            vkDestroyShaderModule(device, m_reloadedFragShaderModule, m_hostAllocator->GetCallbacks("Instance::CreateShaderModule"));
+            std::cerr << "shader reload failed to compile, keeping the previous pipeline" << std::endl;
+        }
+
+        m_reloadedPipeline = PipelineHandle();
+        m_reloadedVertShaderModule = VK_NULL_HANDLE;
+        m_reloadedFragShaderModule = VK_NULL_HANDLE;
+    }
+
+    // One rebuild at a time, and the startup compile has to land before it can be replaced
+    if (!m_shaderReloadQueued || m_graphicsPipeline.GetStatus() == PipelineHandle::Status::Pending)
+    {
+        return;
+    }
+    m_shaderReloadQueued = false;
+
+    m_reloadedPipelineDesc = m_graphicsPipelineDesc;
+    try
+    {
+        ShaderReflection vertReflection;
+        ShaderReflection fragReflection;
+        m_reloadedVertShaderModule = LoadShaderModule("vert", vertReflection);
+        m_reloadedFragShaderModule = LoadShaderModule("frag", fragReflection);
+        m_reloadedPipelineDesc.shaderStages[0].module = m_reloadedVertShaderModule;
+        m_reloadedPipelineDesc.shaderStages[1].module = m_reloadedFragShaderModule;
+        ApplyShaderInterface(vertReflection, fragReflection, m_reloadedPipelineDesc);
+    }
+    catch (const std::exception& e)
+    {
+        vkDestroyShaderModule(device, m_reloadedVertShaderModule, m_hostAllocator->GetCallbacks("Instance::CreateShaderModule"));
+        vkDestroyShaderModule(device, m_reloadedFragShaderModule, m_hostAllocator->GetCallbacks("Instance::CreateShaderModule"));
+        m_reloadedVertShaderModule = VK_NULL_HANDLE;
+        m_reloadedFragShaderModule = VK_NULL_HANDLE;
+        std::cerr << "shader reload failed: " << e.what() << std::endl;
+        return;
+    }
+
+    // Frames keep rendering with the current pipeline while the compiler works
+    m_reloadedPipeline = m_pipelineStateCache->GetPipeline(m_reloadedPipelineDesc, m_shaderPermutation);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Instance::UploadVertices()
+{
+    CPU_TRACE_ZONE("Instance::UploadVertices");
+
+    // Turned a little every frame, so the slot really changes between its uses
+    const float angle = static_cast<float>(m_frameNumber % k_triangleFramesPerTurn) * (6.2831853f / k_triangleFramesPerTurn);
+    const float cosAngle = std::cos(angle);
+    const float sinAngle = std::sin(angle);
+
+    Vertex vertices[std::size(k_triangleVertices)];
+    for (size_t i = 0; i < std::size(k_triangleVertices); i++)
+    {
+        vertices[i] = k_triangleVertices[i];
+        vertices[i].position[0] = k_triangleVertices[i].position[0] * cosAngle - k_triangleVertices[i].position[1] * sinAngle;
+        vertices[i].position[1] = k_triangleVertices[i].position[0] * sinAngle + k_triangleVertices[i].position[1] * cosAngle;
+    }
+
+    // The copy lands ahead of the frame's draw in the same submit, or on the transfer queue the submit waits for
+    if (!m_stagingRing->UploadToBuffer(vertices, sizeof(vertices), m_vertexBuffer, m_currentFrame * sizeof(vertices))) {
+        throw std::runtime_error("failed to upload vertices, staging partition full!");
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Instance::RecordCommandBuffer(VkCommandBuffer i_commandBuffer, uint32_t i_imageIndex)
+{
+    CPU_TRACE_ZONE("Instance::RecordCommandBuffer");
+
+    UploadVertices();
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if (vkBeginCommandBuffer(i_commandBuffer, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin recording command buffer!");
+    }
+
+    // This slot's fence has signaled, its previous timestamps are ready
+    m_gpuProfiler->BeginFrame(m_currentFrame, i_commandBuffer);
+    {
+        GpuProfiler::Scope mainPassScope(*m_gpuProfiler, i_commandBuffer, "main pass");
+        BeginRenderTarget(i_commandBuffer, i_imageIndex, false);
+
+        // Until the compiler delivers the pipeline the frame is only cleared
+        VkPipeline pipeline = m_graphicsPipeline.Get();
+        if (pipeline != VK_NULL_HANDLE)
+        {
+            vkCmdBindPipeline(i_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+
+            VkViewport viewport{};
+            viewport.x = 0.0f;
+            viewport.y = 0.0f;
+            viewport.width = static_cast<float>(m_swapChainExtent.width);
+            viewport.height = static_cast<float>(m_swapChainExtent.height);
+            viewport.minDepth = 0.0f;
+            viewport.maxDepth = 1.0f;
+            vkCmdSetViewport(i_commandBuffer, 0, 1, &viewport);
+
+            VkRect2D scissor{};
+            scissor.offset = { 0, 0 };
+            scissor.extent = m_swapChainExtent;
+            vkCmdSetScissor(i_commandBuffer, 0, 1, &scissor);
+
+            const VkDeviceSize vertexOffset = m_currentFrame * sizeof(k_triangleVertices);
+            vkCmdBindVertexBuffers(i_commandBuffer, 0, 1, &m_vertexBuffer, &vertexOffset);
+            vkCmdDraw(i_commandBuffer, static_cast<uint32_t>(std::size(k_triangleVertices)), 1, 0, 0);
+        }
+
+        EndRenderTarget(i_commandBuffer, i_imageIndex);
+    }
+    m_gpuProfiler->EndFrame();
+
+    if (vkEndCommandBuffer(i_commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record command buffer!");
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Instance::BeginRenderTarget(VkCommandBuffer i_commandBuffer, uint32_t i_imageIndex, bool i_secondaryCommandBuffers)
+{
+    VkClearValue clearColor = { {{0.0f, 0.0f, 0.0f, 1.0f}} };
+
+    if (!m_dynamicRendering)
+    {
+        VkRenderPassBeginInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = m_renderPass;
+        renderPassInfo.framebuffer = m_swapChainFramebuffers[i_imageIndex];
+        renderPassInfo.renderArea.offset = { 0, 0 };
+        renderPassInfo.renderArea.extent = m_swapChainExtent;
+        renderPassInfo.clearValueCount = 1;
+        renderPassInfo.pClearValues = &clearColor;
+
+        vkCmdBeginRenderPass(i_commandBuffer, &renderPassInfo, i_secondaryCommandBuffers ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+        return;
+    }
+
+    // The render pass did this through initialLayout and its external dependency: the contents are discarded,
+    // and the transition waits for the acquire semaphore, which is waited on at color attachment output
+    VkImageMemoryBarrier barrier = MakeColorAttachmentBarrier(m_swapChainImages[i_imageIndex], VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    vkCmdPipelineBarrier(i_commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    VkRenderingAttachmentInfo colorAttachment{};
+    colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+    colorAttachment.imageView = m_swapChainImageViews[i_imageIndex];
+    colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachment.clearValue = clearColor;
+
+    VkRenderingInfo renderingInfo{};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+    renderingInfo.flags = i_secondaryCommandBuffers ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
+    renderingInfo.renderArea.offset = { 0, 0 };
+    renderingInfo.renderArea.extent = m_swapChainExtent;
+    renderingInfo.layerCount = 1;
+    renderingInfo.colorAttachmentCount = 1;
+    renderingInfo.pColorAttachments = &colorAttachment;
+
+    m_vkCmdBeginRendering(i_commandBuffer, &renderingInfo);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Instance::EndRenderTarget(VkCommandBuffer i_commandBuffer, uint32_t i_imageIndex)
+{
+    if (!m_dynamicRendering)
+    {
+        vkCmdEndRenderPass(i_commandBuffer);
+        return;
+    }
+
+    m_vkCmdEndRendering(i_commandBuffer);
+
+    // The finalLayout of the render pass path, offscreen images are read back instead of presented
+    const bool offscreen = m_presentTarget == PresentTarget::Offscreen;
+    VkImageMemoryBarrier barrier = MakeColorAttachmentBarrier(m_swapChainImages[i_imageIndex], VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        offscreen ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+    barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barrier.dstAccessMask = offscreen ? VK_ACCESS_TRANSFER_READ_BIT : 0;
+    vkCmdPipelineBarrier(i_commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        offscreen ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 } //namespace Instance
\ No newline at end of file
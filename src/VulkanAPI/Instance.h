@@ -1,12 +1,25 @@
 #pragma once
 
+#include "VulkanAPI/DeletionQueue.h"
+#include "VulkanAPI/HostAllocationMode.h"
+#include "VulkanAPI/MemoryAllocator.h"
+#include "VulkanAPI/PipelineCompiler.h"
+#include "VulkanAPI/PresentTarget.h"
+
 class FileSystem;
+class FileWatcher;
 class Window;
 
 namespace VulkanAPI
 {
     struct QueueFamilyIndices;
+    class GpuProfiler;
+    class HostAllocator;
+    class OffscreenTarget;
+    class StagingRing;
     class PhysicalDevice;
+    class PipelineStateCache;
+    struct ShaderReflection;
     class RequiredInstanceExtensionsInfo;
     class WindowSurface;
     struct SwapChainSupportDetails;
@@ -18,24 +31,61 @@ namespace VulkanAPI
 class Instance {
 ///////////////////////////////////////////////////////////////////////////////
 public:
-    Instance(const std::vector<const char*>& i_validationLayers, RequiredInstanceExtensionsInfo& i_requiredInstanceExtensionsInfo, std::unique_ptr<Window>& i_window, std::unique_ptr<FileSystem>& i_fileSystem);
+    Instance(const std::vector<const char*>& i_validationLayers, RequiredInstanceExtensionsInfo& i_requiredInstanceExtensionsInfo, std::unique_ptr<Window>& i_window, std::unique_ptr<FileSystem>& i_fileSystem, PresentTarget i_presentTarget, HostAllocationMode i_hostAllocationMode);
     ~Instance();
 
     void CreateSurface();
     void SetupDebugMessenger();
     void PickPhysicalDevice();
-    void CreateLogicalDevice();
+    // Falls back to a render pass when the device can't do Vulkan 1.3 dynamic rendering
+    void CreateLogicalDevice(bool i_preferDynamicRendering);
     void CreateSwapChain();
     void CreateImageViews();
     void CreateRenderPass();
-    void CreateGraphicsPipeline();
+    // Shaders come from the executable unless i_shaderOverrideDirectory names a directory of .spv files.
+    // i_shaderPermutation switches shader features on, see ShaderPermutation.
+    void CreateGraphicsPipeline(const std::string& i_shaderOverrideDirectory, uint32_t i_shaderPermutation);
+    void CreateFramebuffers();
+    void CreateCommandPool();
+    // i_gpuCounters adds pipeline statistics and occlusion counts to the GPU profile when the device has them
+    void CreateCommandBuffers(uint32_t i_framesInFlight, bool i_gpuCounters);
+    void CreateSyncObjects();
+
+    void DrawFrame();
+    void WaitIdle();
+    // Blocks until every queued pipeline compile has finished
+    void WaitForPipelines();
+    void SavePipelineCache();
+    void PrintMemoryStatistics();
+    void PrintPipelineStatistics();
+    // GPU time per pass, the device must be idle
+    void PrintGpuStatistics();
+    // Driver host memory per allocation scope and call site, nothing unless host allocations are tracked
+    void PrintHostAllocationStatistics();
+    // Records i_drawCount draws into secondary command buffers with an increasing number of threads and prints the timings
+    void BenchmarkCommandRecording(uint32_t i_drawCount);
+    // Queues i_uploadCount small buffer uploads per frame through the staging ring and prints their cost per frame,
+    // the submits they took and any allocation once the first frame of every slot is done
+    void BenchmarkUploads(uint32_t i_uploadCount);
+    // Writes the last rendered frame as a binary PPM, offscreen target only
+    void CaptureFrame(const std::string& i_fileName);
 
 private:
+    // Everything the CPU touches while recording one frame, one set per frame in flight
+    struct FrameResources
+    {
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkSemaphore imageAvailableSemaphore = VK_NULL_HANDLE;
+        VkFence inFlightFence = VK_NULL_HANDLE;
+    };
+
     void CreateDebugUtilsMessenger();
     void DestroyDebugUtilsMessenger();
     void PopulateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& o_createInfo);
 
     bool CheckValidationLayerSupport(const std::vector<const char*>& i_validationLayers);
+    bool CheckInstanceExtensionSupport(const char* i_extensionName);
+    void CreateHeadlessSurface();
 
     int RateDeviceSuitability(VkPhysicalDevice i_device);
     bool IsDeviceSuitable(VkPhysicalDevice i_device);
@@ -47,24 +97,91 @@ private:
     VkPresentModeKHR ChooseSwapPresentMode(const std::vector<VkPresentModeKHR>& i_availablePresentModes);
     VkExtent2D ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& i_capabilities);
     void RetrievingSwapChainImages();
+    void CreateSwapChainSemaphores();
+    void RecreateSwapChain();
+    void RetireSwapChain();
 
-    VkShaderModule CreateShaderModule(const std::vector<char>& i_code);
+    VkShaderModule CreateShaderModule(const uint32_t* i_code, size_t i_codeSize);
+    // By name without extension, from the override directory when one is set
+    VkShaderModule LoadShaderModule(const std::string& i_name, ShaderReflection& o_reflection);
+    // Entry points, specialization, vertex input and a cached pipeline layout, all taken from the shaders
+    void ApplyShaderInterface(const ShaderReflection& i_vertReflection, const ShaderReflection& i_fragReflection, GraphicsPipelineDesc& io_desc);
+    // At a frame boundary: starts a rebuild when shaders changed on disk, swaps the pipeline in once it is ready
+    void UpdateShaderHotReload();
+
+    // Refills the current frame's slot of the vertex buffer through the staging ring
+    void UploadVertices();
+    void RecordCommandBuffer(VkCommandBuffer i_commandBuffer, uint32_t i_imageIndex);
+    // Starts drawing into swapchain image i_imageIndex, cleared, through the render pass or dynamic rendering
+    void BeginRenderTarget(VkCommandBuffer i_commandBuffer, uint32_t i_imageIndex, bool i_secondaryCommandBuffers);
+    void EndRenderTarget(VkCommandBuffer i_commandBuffer, uint32_t i_imageIndex);
+    void DrawOffscreenFrame(FrameResources& i_frame);
+    // Staging copies of the frame first, then the frame itself, returns the count written to o_commandBuffers.
+    // o_waitSemaphore is the transfer queue's, VK_NULL_HANDLE when the copies run on the graphics queue
+    uint32_t GatherCommandBuffers(FrameResources& i_frame, VkCommandBuffer (&o_commandBuffers)[2], VkSemaphore& o_waitSemaphore, VkPipelineStageFlags& o_waitStage);
 
 private:
+    // First so it is destroyed last, every object created with its callbacks has to be gone by then
+    std::unique_ptr<HostAllocator> m_hostAllocator;
     VkInstance m_instance;
+    uint32_t m_apiVersion;
     std::unique_ptr<FileSystem>& m_fileSystem;
     VkDebugUtilsMessengerEXT m_debugMessenger;
 
     std::unique_ptr<Window>& m_window;
+    PresentTarget m_presentTarget;
+    std::vector<const char*> m_deviceExtensions;
     VkSwapchainKHR m_swapChain;
+    // Replaces the swapchain images for PresentTarget::Offscreen
+    std::unique_ptr<OffscreenTarget> m_offscreenTarget;
+    // Fence of the frame last rendering into each offscreen image
+    std::vector<VkFence> m_imagesInFlight;
     std::vector<VkImage> m_swapChainImages;
     std::vector<VkImageView> m_swapChainImageViews;
+    std::vector<VkFramebuffer> m_swapChainFramebuffers;
+    // Indexed by swapchain image, the presentation engine may hold on to it longer than a frame slot
+    std::vector<VkSemaphore> m_renderFinishedSemaphores;
     VkFormat m_swapChainImageFormat;
     VkExtent2D m_swapChainExtent;
 
+    // VK_NULL_HANDLE with dynamic rendering, there are no framebuffers either
     VkRenderPass m_renderPass;
+    bool m_dynamicRendering;
+    PFN_vkCmdBeginRendering m_vkCmdBeginRendering;
+    PFN_vkCmdEndRendering m_vkCmdEndRendering;
+    // Owned by the PipelineLayoutCache of the logical device
     VkPipelineLayout m_pipelineLayout;
-    VkPipeline m_graphicsPipeline;
+    VkShaderModule m_vertShaderModule;
+    VkShaderModule m_fragShaderModule;
+    std::string m_shaderOverrideDirectory;
+    uint32_t m_shaderPermutation;
+    // Unspecialized, the state cache applies m_shaderPermutation on every lookup
+    GraphicsPipelineDesc m_graphicsPipelineDesc;
+    // Hot reload of the override directory, the rebuilt pipeline and its modules until they are swapped in
+    std::unique_ptr<FileWatcher> m_shaderWatcher;
+    PipelineHandle m_reloadedPipeline;
+    GraphicsPipelineDesc m_reloadedPipelineDesc;
+    VkShaderModule m_reloadedVertShaderModule;
+    VkShaderModule m_reloadedFragShaderModule;
+    bool m_shaderReloadQueued;
+    std::unique_ptr<PipelineCompiler> m_pipelineCompiler;
+    // Owns every graphics pipeline, identical descriptions share one
+    std::unique_ptr<PipelineStateCache> m_pipelineStateCache;
+    PipelineHandle m_graphicsPipeline;
+
+    VkCommandPool m_commandPool;
+    std::vector<FrameResources> m_frames;
+    // CPU to GPU uploads, partitioned per frame in flight
+    std::unique_ptr<StagingRing> m_stagingRing;
+    // Device local, one slot of the triangle's vertices per frame in flight
+    VkBuffer m_vertexBuffer;
+    MemoryAllocation m_vertexMemory;
+    // Timestamps around the passes of every frame
+    std::unique_ptr<GpuProfiler> m_gpuProfiler;
+    uint32_t m_currentFrame;
+    // Number of frames submitted so far
+    uint64_t m_frameNumber;
+    DeletionQueue m_deletionQueue;
 
     std::unique_ptr<WindowSurface> m_surface;
 
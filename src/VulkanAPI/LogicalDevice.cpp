@@ -1,6 +1,10 @@
 #include "stdafx.h"
 #include "LogicalDevice.h"
 
+#include "VulkanAPI/HostAllocator.h"
+#include "VulkanAPI/MemoryAllocator.h"
+#include "VulkanAPI/PipelineCache.h"
+#include "VulkanAPI/PipelineLayoutCache.h"
 #include "VulkanAPI/QueueFamilyIndices.h"
 
 #include <vulkan/vulkan.h>
@@ -9,20 +13,36 @@ namespace VulkanAPI
 {
 ///////////////////////////////////////////////////////////////////////////////
 
-LogicalDevice::LogicalDevice(VkDevice i_device, QueueFamilyIndices i_queueFamilyIndices)
+LogicalDevice::LogicalDevice(VkPhysicalDevice i_physicalDevice, VkDevice i_device, QueueFamilyIndices i_queueFamilyIndices, const DeviceFeatures& i_features, const VkAllocationCallbacks* i_allocator, HostAllocator& i_hostAllocator)
     : m_device(i_device)
+    , m_allocator(i_allocator)
+    , m_features(i_features)
     , m_graphicsQueue(nullptr)
     , m_presentQueue(nullptr)
+    , m_transferQueue(nullptr)
+    , m_pipelineCache(nullptr)
+    , m_memoryAllocator(nullptr)
+    , m_pipelineLayoutCache(nullptr)
 {
     vkGetDeviceQueue(m_device, i_queueFamilyIndices.optGraphicsFamily.value(), 0, &m_graphicsQueue);
     vkGetDeviceQueue(m_device, i_queueFamilyIndices.optPresentFamily.value(), 0, &m_presentQueue);
+    vkGetDeviceQueue(m_device, i_queueFamilyIndices.GetTransferFamily(), 0, &m_transferQueue);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(i_physicalDevice, &properties);
+    m_pipelineCache = std::make_unique<PipelineCache>(m_device, properties, i_hostAllocator.GetCallbacks("PipelineCache"));
+    m_memoryAllocator = std::make_unique<MemoryAllocator>(i_physicalDevice, m_device, i_hostAllocator.GetCallbacks("MemoryAllocator"));
+    m_pipelineLayoutCache = std::make_unique<PipelineLayoutCache>(m_device, i_hostAllocator.GetCallbacks("PipelineLayoutCache"));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
 LogicalDevice::~LogicalDevice()
 {
-    vkDestroyDevice(m_device, nullptr);
+    m_pipelineCache.reset();
+    m_memoryAllocator.reset();
+    m_pipelineLayoutCache.reset();
+    vkDestroyDevice(m_device, m_allocator);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1,7 +1,13 @@
 #pragma once
 
+#include "VulkanAPI/DeviceFeatures.h"
+
 namespace VulkanAPI
 {
+    class HostAllocator;
+    class MemoryAllocator;
+    class PipelineCache;
+    class PipelineLayoutCache;
     struct QueueFamilyIndices;
 }
 
@@ -11,7 +17,8 @@ namespace VulkanAPI
 class LogicalDevice {
 ///////////////////////////////////////////////////////////////////////////////
 public:
-    LogicalDevice(VkDevice i_device, QueueFamilyIndices i_queueFamilyIndices);
+    // i_allocator is what i_device was created with, the objects the device owns get call sites of their own
+    LogicalDevice(VkPhysicalDevice i_physicalDevice, VkDevice i_device, QueueFamilyIndices i_queueFamilyIndices, const DeviceFeatures& i_features, const VkAllocationCallbacks* i_allocator, HostAllocator& i_hostAllocator);
     ~LogicalDevice();
 
     VkDevice GetDevice()
@@ -19,10 +26,59 @@ public:
         return m_device;
     }
 
+    VkQueue GetGraphicsQueue()
+    {
+        return m_graphicsQueue;
+    }
+
+    VkQueue GetPresentQueue()
+    {
+        return m_presentQueue;
+    }
+
+    // The graphics queue when the device has no dedicated transfer family
+    VkQueue GetTransferQueue()
+    {
+        return m_transferQueue;
+    }
+
+    bool HasDedicatedTransferQueue()
+    {
+        return m_transferQueue != m_graphicsQueue;
+    }
+
+    PipelineCache* GetPipelineCache()
+    {
+        return m_pipelineCache.get();
+    }
+
+    MemoryAllocator* GetMemoryAllocator()
+    {
+        return m_memoryAllocator.get();
+    }
+
+    PipelineLayoutCache* GetPipelineLayoutCache()
+    {
+        return m_pipelineLayoutCache.get();
+    }
+
+    // What the device was created with, branch on these instead of querying the physical device again
+    const DeviceFeatures& GetFeatures()
+    {
+        return m_features;
+    }
+
 private:
     VkDevice m_device;
+    // The callbacks vkCreateDevice got, vkDestroyDevice needs compatible ones
+    const VkAllocationCallbacks* m_allocator;
+    DeviceFeatures m_features;
     VkQueue m_graphicsQueue;
     VkQueue m_presentQueue;
+    VkQueue m_transferQueue;
+    std::unique_ptr<PipelineCache> m_pipelineCache;
+    std::unique_ptr<MemoryAllocator> m_memoryAllocator;
+    std::unique_ptr<PipelineLayoutCache> m_pipelineLayoutCache;
 };
 ///////////////////////////////////////////////////////////////////////////////
 } //namespace Instance
\ No newline at end of file
@@ -0,0 +1,304 @@
+#include "stdafx.h"
+#include "MemoryAllocator.h"
+
+#include "VulkanAPI/MemoryBlock.h"
+
+#include <vulkan/vulkan.h>
+#include <algorithm>
+#include <iomanip>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+    constexpr VkDeviceSize k_defaultBlockSize = 64ull * 1024 * 1024;
+    // Heaps at or below this size, typically the host visible BAR window, get blocks of a fraction of the heap
+    constexpr VkDeviceSize k_smallHeapSize = 1024ull * 1024 * 1024;
+    constexpr VkDeviceSize k_smallHeapBlockDivisor = 8;
+}
+///////////////////////////////////////////////////////////////////////////////
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+
+MemoryAllocator::MemoryAllocator(VkPhysicalDevice i_physicalDevice, VkDevice i_device, const VkAllocationCallbacks* i_allocator)
+    : m_device(i_device)
+    , m_allocator(i_allocator)
+    , m_bufferImageGranularity(1)
+    , m_maxMemoryAllocationCount(0)
+    , m_deviceMemoryCount(0)
+    , m_dedicatedAllocationCount(0)
+    , m_dedicatedBytes(0)
+    , m_vkAllocateMemoryCount(0)
+{
+    vkGetPhysicalDeviceMemoryProperties(i_physicalDevice, &m_memoryProperties);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(i_physicalDevice, &properties);
+    m_bufferImageGranularity = properties.limits.bufferImageGranularity;
+    m_maxMemoryAllocationCount = properties.limits.maxMemoryAllocationCount;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+MemoryAllocator::~MemoryAllocator()
+{
+    assert(m_dedicatedAllocationCount == 0);
+    for (auto& kindPools : m_pools)
+    {
+        for (auto& pool : kindPools)
+        {
+            pool.clear();
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+MemoryAllocation MemoryAllocator::Allocate(const VkMemoryRequirements& i_requirements, VkMemoryPropertyFlags i_properties, ResourceKind i_kind)
+{
+    const uint32_t memoryType = FindMemoryType(i_requirements.memoryTypeBits, i_properties);
+    const VkDeviceSize blockSize = GetBlockSize(memoryType);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    MemoryAllocation allocation;
+    allocation.memoryType = memoryType;
+
+    // Large resources would mostly waste a block, they get their own memory
+    if (i_requirements.size > blockSize / 2)
+    {
+        allocation.memory = AllocateDeviceMemory(memoryType, i_requirements.size, allocation.mappedData);
+        allocation.offset = 0;
+        allocation.size = i_requirements.size;
+        m_dedicatedAllocationCount++;
+        m_dedicatedBytes += allocation.size;
+        return allocation;
+    }
+
+    const uint32_t kind = m_bufferImageGranularity > 1 ? static_cast<uint32_t>(i_kind) : 0;
+    std::vector<std::unique_ptr<MemoryBlock>>& pool = m_pools[memoryType][kind];
+
+    MemoryBlock* block = nullptr;
+    for (const std::unique_ptr<MemoryBlock>& candidate : pool)
+    {
+        if (candidate->Allocate(i_requirements.size, i_requirements.alignment, allocation.offset, allocation.size, allocation.node))
+        {
+            block = candidate.get();
+            break;
+        }
+    }
+
+    if (block == nullptr)
+    {
+        void* mappedData = nullptr;
+        VkDeviceMemory memory = AllocateDeviceMemory(memoryType, blockSize, mappedData);
+        pool.push_back(std::make_unique<MemoryBlock>(m_device, memory, blockSize, memoryType, mappedData, m_allocator));
+        block = pool.back().get();
+
+        if (!block->Allocate(i_requirements.size, i_requirements.alignment, allocation.offset, allocation.size, allocation.node))
+        {
+            throw std::runtime_error("failed to sub-allocate from a new memory block!");
+        }
+    }
+
+    allocation.memory = block->GetMemory();
+    allocation.block = block;
+    if (block->GetMappedData() != nullptr)
+    {
+        allocation.mappedData = static_cast<char*>(block->GetMappedData()) + allocation.offset;
+    }
+
+    return allocation;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void MemoryAllocator::Free(MemoryAllocation& io_allocation)
+{
+    if (io_allocation.memory == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (io_allocation.block == nullptr)
+    {
+        if (io_allocation.mappedData != nullptr)
+        {
+            vkUnmapMemory(m_device, io_allocation.memory);
+        }
+        vkFreeMemory(m_device, io_allocation.memory, m_allocator);
+        m_deviceMemoryCount--;
+        m_dedicatedAllocationCount--;
+        m_dedicatedBytes -= io_allocation.size;
+    }
+    else
+    {
+        MemoryBlock* block = io_allocation.block;
+        block->Free(io_allocation.node);
+
+        // Keep one empty block around per pool so a free/allocate pattern does not hit the driver every time
+        if (block->IsEmpty())
+        {
+            for (auto& pool : m_pools[block->GetMemoryType()])
+            {
+                auto it = std::find_if(pool.begin(), pool.end(), [block](const std::unique_ptr<MemoryBlock>& i_block) { return i_block.get() == block; });
+                if (it == pool.end())
+                {
+                    continue;
+                }
+
+                const bool hasOtherEmpty = std::any_of(pool.begin(), pool.end(), [block](const std::unique_ptr<MemoryBlock>& i_block) { return i_block.get() != block && i_block->IsEmpty(); });
+                if (hasOtherEmpty)
+                {
+                    pool.erase(it);
+                    m_deviceMemoryCount--;
+                }
+                break;
+            }
+        }
+    }
+
+    io_allocation = MemoryAllocation();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+MemoryAllocation MemoryAllocator::AllocateForBuffer(VkBuffer i_buffer, VkMemoryPropertyFlags i_properties)
+{
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(m_device, i_buffer, &memRequirements);
+
+    MemoryAllocation allocation = Allocate(memRequirements, i_properties, ResourceKind::Linear);
+    if (vkBindBufferMemory(m_device, i_buffer, allocation.memory, allocation.offset) != VK_SUCCESS) {
+        Free(allocation);
+        throw std::runtime_error("failed to bind buffer memory!");
+    }
+
+    return allocation;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+MemoryAllocation MemoryAllocator::AllocateForImage(VkImage i_image, VkMemoryPropertyFlags i_properties, VkImageTiling i_tiling)
+{
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(m_device, i_image, &memRequirements);
+
+    const ResourceKind kind = i_tiling == VK_IMAGE_TILING_OPTIMAL ? ResourceKind::Optimal : ResourceKind::Linear;
+    MemoryAllocation allocation = Allocate(memRequirements, i_properties, kind);
+    if (vkBindImageMemory(m_device, i_image, allocation.memory, allocation.offset) != VK_SUCCESS) {
+        Free(allocation);
+        throw std::runtime_error("failed to bind image memory!");
+    }
+
+    return allocation;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+MemoryAllocator::Statistics MemoryAllocator::GetStatistics()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Statistics statistics;
+    statistics.dedicatedAllocationCount = m_dedicatedAllocationCount;
+    statistics.allocationCount = m_dedicatedAllocationCount;
+    statistics.reservedBytes = m_dedicatedBytes;
+    statistics.usedBytes = m_dedicatedBytes;
+    statistics.vkAllocateMemoryCount = m_vkAllocateMemoryCount;
+
+    for (auto& kindPools : m_pools)
+    {
+        for (auto& pool : kindPools)
+        {
+            for (const std::unique_ptr<MemoryBlock>& block : pool)
+            {
+                statistics.blockCount++;
+                statistics.allocationCount += block->GetAllocationCount();
+                statistics.reservedBytes += block->GetSize();
+                statistics.usedBytes += block->GetUsedBytes();
+            }
+        }
+    }
+
+    return statistics;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void MemoryAllocator::PrintStatistics()
+{
+    const Statistics statistics = GetStatistics();
+    const double k_mebibyte = 1024.0 * 1024.0;
+
+    std::cout << std::fixed << std::setprecision(2)
+        << "device memory: " << statistics.allocationCount << " allocations in "
+        << statistics.blockCount << " blocks + " << statistics.dedicatedAllocationCount << " dedicated, "
+        << statistics.usedBytes / k_mebibyte << " / " << statistics.reservedBytes / k_mebibyte << " MiB used, "
+        << statistics.vkAllocateMemoryCount << " vkAllocateMemory calls" << std::endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+uint32_t MemoryAllocator::FindMemoryType(uint32_t i_typeBits, VkMemoryPropertyFlags i_properties)
+{
+    for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; i++)
+    {
+        if ((i_typeBits & (1 << i)) && (m_memoryProperties.memoryTypes[i].propertyFlags & i_properties) == i_properties)
+        {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("failed to find suitable memory type!");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+VkDeviceSize MemoryAllocator::GetBlockSize(uint32_t i_memoryType)
+{
+    const uint32_t heapIndex = m_memoryProperties.memoryTypes[i_memoryType].heapIndex;
+    const VkDeviceSize heapSize = m_memoryProperties.memoryHeaps[heapIndex].size;
+    return heapSize <= k_smallHeapSize ? heapSize / k_smallHeapBlockDivisor : k_defaultBlockSize;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+VkDeviceMemory MemoryAllocator::AllocateDeviceMemory(uint32_t i_memoryType, VkDeviceSize i_size, void*& o_mappedData)
+{
+    if (m_deviceMemoryCount >= m_maxMemoryAllocationCount)
+    {
+        throw std::runtime_error("failed to allocate memory! maxMemoryAllocationCount reached!");
+    }
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = i_size;
+    allocInfo.memoryTypeIndex = i_memoryType;
+
+    VkDeviceMemory memory;
+    if (vkAllocateMemory(m_device, &allocInfo, m_allocator, &memory) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate memory!");
+    }
+    m_deviceMemoryCount++;
+    m_vkAllocateMemoryCount++;
+
+    // Host visible memory stays mapped for its whole lifetime, mapping is not free and only one map per memory is allowed
+    o_mappedData = nullptr;
+    if ((m_memoryProperties.memoryTypes[i_memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0)
+    {
+        if (vkMapMemory(m_device, memory, 0, VK_WHOLE_SIZE, 0, &o_mappedData) != VK_SUCCESS) {
+            vkFreeMemory(m_device, memory, m_allocator);
+            m_deviceMemoryCount--;
+            throw std::runtime_error("failed to map memory!");
+        }
+    }
+
+    return memory;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <mutex>
+
+namespace VulkanAPI
+{
+    class MemoryBlock;
+}
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+// A range of device memory handed out by MemoryAllocator, bind resources at memory + offset
+struct MemoryAllocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    // Persistently mapped pointer to offset, null unless the memory type is host visible
+    void* mappedData = nullptr;
+    uint32_t memoryType = 0;
+
+    // Block the range was carved from, null for dedicated allocations
+    MemoryBlock* block = nullptr;
+    uint32_t node = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Sub-allocates resources from large VkDeviceMemory blocks kept per memory type,
+// so creating a resource does not cost a vkAllocateMemory call or count towards maxMemoryAllocationCount
+class MemoryAllocator {
+///////////////////////////////////////////////////////////////////////////////
+public:
+    // Decides which pool a resource may share a block with, see bufferImageGranularity
+    enum class ResourceKind {
+        // Buffers and linear tiled images
+        Linear,
+        // Optimal tiled images
+        Optimal,
+    };
+
+    struct Statistics {
+        uint32_t blockCount = 0;
+        uint32_t dedicatedAllocationCount = 0;
+        uint32_t allocationCount = 0;
+        // Device memory owned through blocks and dedicated allocations
+        VkDeviceSize reservedBytes = 0;
+        // Bytes handed out, including alignment slack
+        VkDeviceSize usedBytes = 0;
+        uint64_t vkAllocateMemoryCount = 0;
+    };
+
+    MemoryAllocator(VkPhysicalDevice i_physicalDevice, VkDevice i_device, const VkAllocationCallbacks* i_allocator);
+    ~MemoryAllocator();
+
+    MemoryAllocation Allocate(const VkMemoryRequirements& i_requirements, VkMemoryPropertyFlags i_properties, ResourceKind i_kind);
+    void Free(MemoryAllocation& io_allocation);
+
+    // Allocate and bind in one go
+    MemoryAllocation AllocateForBuffer(VkBuffer i_buffer, VkMemoryPropertyFlags i_properties);
+    MemoryAllocation AllocateForImage(VkImage i_image, VkMemoryPropertyFlags i_properties, VkImageTiling i_tiling);
+
+    Statistics GetStatistics();
+    void PrintStatistics();
+
+private:
+    uint32_t FindMemoryType(uint32_t i_typeBits, VkMemoryPropertyFlags i_properties);
+    VkDeviceSize GetBlockSize(uint32_t i_memoryType);
+    VkDeviceMemory AllocateDeviceMemory(uint32_t i_memoryType, VkDeviceSize i_size, void*& o_mappedData);
+
+private:
+    static constexpr uint32_t k_resourceKindCount = 2;
+
+    VkDevice m_device;
+    const VkAllocationCallbacks* m_allocator;
+    VkPhysicalDeviceMemoryProperties m_memoryProperties;
+    VkDeviceSize m_bufferImageGranularity;
+    uint32_t m_maxMemoryAllocationCount;
+
+    std::mutex m_mutex;
+    // Linear and optimal resources get their own blocks whenever bufferImageGranularity is above 1,
+    // within a block neighbours are then always of the same kind and only need their own alignment
+    std::vector<std::unique_ptr<MemoryBlock>> m_pools[VK_MAX_MEMORY_TYPES][k_resourceKindCount];
+    uint32_t m_deviceMemoryCount;
+    uint32_t m_dedicatedAllocationCount;
+    VkDeviceSize m_dedicatedBytes;
+    uint64_t m_vkAllocateMemoryCount;
+};
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
@@ -0,0 +1,329 @@
+#include "stdafx.h"
+#include "MemoryBlock.h"
+
+#include <vulkan/vulkan.h>
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+    // Leftovers smaller than this stay attached to the allocation instead of becoming a free range
+    constexpr VkDeviceSize k_minFreeRangeSize = 256;
+
+    uint32_t HighestBit(uint64_t i_value)
+    {
+        assert(i_value != 0);
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse64(&index, i_value);
+        return static_cast<uint32_t>(index);
+#else
+        return 63 - static_cast<uint32_t>(__builtin_clzll(i_value));
+#endif
+    }
+
+    uint32_t LowestBit(uint64_t i_value)
+    {
+        assert(i_value != 0);
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, i_value);
+        return static_cast<uint32_t>(index);
+#else
+        return static_cast<uint32_t>(__builtin_ctzll(i_value));
+#endif
+    }
+
+    VkDeviceSize AlignUp(VkDeviceSize i_value, VkDeviceSize i_alignment)
+    {
+        return (i_value + i_alignment - 1) & ~(i_alignment - 1);
+    }
+}
+///////////////////////////////////////////////////////////////////////////////
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+
+MemoryBlock::MemoryBlock(VkDevice i_device, VkDeviceMemory i_memory, VkDeviceSize i_size, uint32_t i_memoryType, void* i_mappedData, const VkAllocationCallbacks* i_allocator)
+    : m_device(i_device)
+    , m_allocator(i_allocator)
+    , m_memory(i_memory)
+    , m_size(i_size)
+    , m_memoryType(i_memoryType)
+    , m_mappedData(i_mappedData)
+    , m_firstLevelBitmap(0)
+    , m_usedBytes(0)
+    , m_allocationCount(0)
+{
+    std::fill(std::begin(m_secondLevelBitmaps), std::end(m_secondLevelBitmaps), 0u);
+    for (auto& heads : m_freeHeads)
+    {
+        std::fill(std::begin(heads), std::end(heads), k_nullNode);
+    }
+
+    // The whole block starts as a single free range
+    uint32_t node = NewNode();
+    m_nodes[node].offset = 0;
+    m_nodes[node].size = m_size;
+    InsertFree(node);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+MemoryBlock::~MemoryBlock()
+{
+    assert(m_allocationCount == 0);
+    if (m_mappedData != nullptr)
+    {
+        vkUnmapMemory(m_device, m_memory);
+    }
+    vkFreeMemory(m_device, m_memory, m_allocator);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool MemoryBlock::Allocate(VkDeviceSize i_size, VkDeviceSize i_alignment, VkDeviceSize& o_offset, VkDeviceSize& o_size, uint32_t& o_node)
+{
+    assert(i_size > 0);
+    const VkDeviceSize alignment = i_alignment > 0 ? i_alignment : 1;
+    assert((alignment & (alignment - 1)) == 0);
+
+    // The padding a range needs is only known once it is picked, so try the plain size first and
+    // only fall back to reserving the worst case padding when that candidate does not fit
+    uint32_t node = FindFreeNode(i_size);
+    if (node == k_nullNode || AlignUp(m_nodes[node].offset, alignment) + i_size > m_nodes[node].offset + m_nodes[node].size)
+    {
+        node = FindFreeNode(i_size + alignment - 1);
+        if (node == k_nullNode)
+        {
+            return false;
+        }
+    }
+
+    RemoveFree(node);
+
+    const VkDeviceSize padding = AlignUp(m_nodes[node].offset, alignment) - m_nodes[node].offset;
+    if (padding > 0)
+    {
+        // Give the padding back as its own free range in front of the allocation
+        uint32_t front = NewNode();
+        m_nodes[front].offset = m_nodes[node].offset;
+        m_nodes[front].size = padding;
+        m_nodes[front].prevPhysical = m_nodes[node].prevPhysical;
+        m_nodes[front].nextPhysical = node;
+        if (m_nodes[node].prevPhysical != k_nullNode)
+        {
+            m_nodes[m_nodes[node].prevPhysical].nextPhysical = front;
+        }
+        m_nodes[node].prevPhysical = front;
+        m_nodes[node].offset += padding;
+        m_nodes[node].size -= padding;
+        InsertFree(front);
+    }
+
+    const VkDeviceSize remaining = m_nodes[node].size - i_size;
+    if (remaining >= k_minFreeRangeSize)
+    {
+        uint32_t back = NewNode();
+        m_nodes[back].offset = m_nodes[node].offset + i_size;
+        m_nodes[back].size = remaining;
+        m_nodes[back].prevPhysical = node;
+        m_nodes[back].nextPhysical = m_nodes[node].nextPhysical;
+        if (m_nodes[node].nextPhysical != k_nullNode)
+        {
+            m_nodes[m_nodes[node].nextPhysical].prevPhysical = back;
+        }
+        m_nodes[node].nextPhysical = back;
+        m_nodes[node].size = i_size;
+        InsertFree(back);
+    }
+
+    m_nodes[node].isFree = false;
+    m_usedBytes += m_nodes[node].size;
+    m_allocationCount++;
+
+    o_offset = m_nodes[node].offset;
+    o_size = m_nodes[node].size;
+    o_node = node;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void MemoryBlock::Free(uint32_t i_node)
+{
+    assert(i_node < m_nodes.size() && !m_nodes[i_node].isFree);
+
+    uint32_t node = i_node;
+    m_nodes[node].isFree = true;
+    m_usedBytes -= m_nodes[node].size;
+    m_allocationCount--;
+
+    // Coalesce with free neighbours so two free ranges are never adjacent
+    const uint32_t next = m_nodes[node].nextPhysical;
+    if (next != k_nullNode && m_nodes[next].isFree)
+    {
+        RemoveFree(next);
+        m_nodes[node].size += m_nodes[next].size;
+        m_nodes[node].nextPhysical = m_nodes[next].nextPhysical;
+        if (m_nodes[next].nextPhysical != k_nullNode)
+        {
+            m_nodes[m_nodes[next].nextPhysical].prevPhysical = node;
+        }
+        ReleaseNode(next);
+    }
+
+    const uint32_t prev = m_nodes[node].prevPhysical;
+    if (prev != k_nullNode && m_nodes[prev].isFree)
+    {
+        RemoveFree(prev);
+        m_nodes[prev].size += m_nodes[node].size;
+        m_nodes[prev].nextPhysical = m_nodes[node].nextPhysical;
+        if (m_nodes[node].nextPhysical != k_nullNode)
+        {
+            m_nodes[m_nodes[node].nextPhysical].prevPhysical = prev;
+        }
+        ReleaseNode(node);
+        node = prev;
+    }
+
+    InsertFree(node);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void MemoryBlock::Mapping(VkDeviceSize i_size, uint32_t& o_firstLevel, uint32_t& o_secondLevel)
+{
+    // First level is the power of two, second level splits it linearly into k_secondLevelCount bins
+    o_firstLevel = HighestBit(i_size);
+    if (o_firstLevel >= k_secondLevelLog2)
+    {
+        o_secondLevel = static_cast<uint32_t>(i_size >> (o_firstLevel - k_secondLevelLog2)) & (k_secondLevelCount - 1);
+    }
+    else
+    {
+        o_secondLevel = static_cast<uint32_t>(i_size << (k_secondLevelLog2 - o_firstLevel)) & (k_secondLevelCount - 1);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+uint32_t MemoryBlock::FindFreeNode(VkDeviceSize i_size)
+{
+    // Round up to the next bin boundary so any range in the bin found is large enough
+    VkDeviceSize size = i_size;
+    const uint32_t highestBit = HighestBit(size);
+    if (highestBit >= k_secondLevelLog2)
+    {
+        size += (VkDeviceSize(1) << (highestBit - k_secondLevelLog2)) - 1;
+    }
+
+    uint32_t firstLevel;
+    uint32_t secondLevel;
+    Mapping(size, firstLevel, secondLevel);
+
+    uint32_t secondLevelMap = m_secondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+    if (secondLevelMap == 0)
+    {
+        const uint64_t firstLevelMap = firstLevel + 1 < k_firstLevelCount ? m_firstLevelBitmap & (~uint64_t(0) << (firstLevel + 1)) : 0;
+        if (firstLevelMap == 0)
+        {
+            return k_nullNode;
+        }
+        firstLevel = LowestBit(firstLevelMap);
+        secondLevelMap = m_secondLevelBitmaps[firstLevel];
+    }
+    secondLevel = LowestBit(secondLevelMap);
+
+    return m_freeHeads[firstLevel][secondLevel];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void MemoryBlock::InsertFree(uint32_t i_node)
+{
+    uint32_t firstLevel;
+    uint32_t secondLevel;
+    Mapping(m_nodes[i_node].size, firstLevel, secondLevel);
+
+    const uint32_t head = m_freeHeads[firstLevel][secondLevel];
+    m_nodes[i_node].isFree = true;
+    m_nodes[i_node].prevFree = k_nullNode;
+    m_nodes[i_node].nextFree = head;
+    if (head != k_nullNode)
+    {
+        m_nodes[head].prevFree = i_node;
+    }
+    m_freeHeads[firstLevel][secondLevel] = i_node;
+
+    m_firstLevelBitmap |= uint64_t(1) << firstLevel;
+    m_secondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void MemoryBlock::RemoveFree(uint32_t i_node)
+{
+    uint32_t firstLevel;
+    uint32_t secondLevel;
+    Mapping(m_nodes[i_node].size, firstLevel, secondLevel);
+
+    const uint32_t prev = m_nodes[i_node].prevFree;
+    const uint32_t next = m_nodes[i_node].nextFree;
+    if (prev != k_nullNode)
+    {
+        m_nodes[prev].nextFree = next;
+    }
+    else
+    {
+        m_freeHeads[firstLevel][secondLevel] = next;
+    }
+    if (next != k_nullNode)
+    {
+        m_nodes[next].prevFree = prev;
+    }
+
+    if (m_freeHeads[firstLevel][secondLevel] == k_nullNode)
+    {
+        m_secondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+        if (m_secondLevelBitmaps[firstLevel] == 0)
+        {
+            m_firstLevelBitmap &= ~(uint64_t(1) << firstLevel);
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+uint32_t MemoryBlock::NewNode()
+{
+    uint32_t node;
+    if (!m_unusedNodes.empty())
+    {
+        node = m_unusedNodes.back();
+        m_unusedNodes.pop_back();
+    }
+    else
+    {
+        node = static_cast<uint32_t>(m_nodes.size());
+        m_nodes.emplace_back();
+    }
+
+    m_nodes[node] = { 0, 0, k_nullNode, k_nullNode, k_nullNode, k_nullNode, false };
+    return node;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void MemoryBlock::ReleaseNode(uint32_t i_node)
+{
+    m_unusedNodes.push_back(i_node);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
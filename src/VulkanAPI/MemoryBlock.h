@@ -0,0 +1,97 @@
+#pragma once
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+// One VkDeviceMemory carved into sub-allocations with a two level segregated fit (TLSF) allocator.
+// Allocate and Free are O(1): free ranges are binned by size and found through two bitmaps.
+class MemoryBlock {
+///////////////////////////////////////////////////////////////////////////////
+public:
+    static constexpr uint32_t k_nullNode = UINT32_MAX;
+
+    MemoryBlock(VkDevice i_device, VkDeviceMemory i_memory, VkDeviceSize i_size, uint32_t i_memoryType, void* i_mappedData, const VkAllocationCallbacks* i_allocator);
+    ~MemoryBlock();
+
+    // Returns false when no free range fits, o_node identifies the sub-allocation for Free
+    bool Allocate(VkDeviceSize i_size, VkDeviceSize i_alignment, VkDeviceSize& o_offset, VkDeviceSize& o_size, uint32_t& o_node);
+    void Free(uint32_t i_node);
+
+    VkDeviceMemory GetMemory()
+    {
+        return m_memory;
+    }
+
+    VkDeviceSize GetSize()
+    {
+        return m_size;
+    }
+
+    uint32_t GetMemoryType()
+    {
+        return m_memoryType;
+    }
+
+    // Start of the persistently mapped block, null unless the memory type is host visible
+    void* GetMappedData()
+    {
+        return m_mappedData;
+    }
+
+    VkDeviceSize GetUsedBytes()
+    {
+        return m_usedBytes;
+    }
+
+    uint32_t GetAllocationCount()
+    {
+        return m_allocationCount;
+    }
+
+    bool IsEmpty()
+    {
+        return m_allocationCount == 0;
+    }
+
+private:
+    // A physical range of the block, either free or handed out
+    struct Node {
+        VkDeviceSize offset;
+        VkDeviceSize size;
+        uint32_t prevPhysical;
+        uint32_t nextPhysical;
+        uint32_t prevFree;
+        uint32_t nextFree;
+        bool isFree;
+    };
+
+    static constexpr uint32_t k_secondLevelLog2 = 4;
+    static constexpr uint32_t k_secondLevelCount = 1 << k_secondLevelLog2;
+    static constexpr uint32_t k_firstLevelCount = 64;
+
+    static void Mapping(VkDeviceSize i_size, uint32_t& o_firstLevel, uint32_t& o_secondLevel);
+    uint32_t FindFreeNode(VkDeviceSize i_size);
+    void InsertFree(uint32_t i_node);
+    void RemoveFree(uint32_t i_node);
+    uint32_t NewNode();
+    void ReleaseNode(uint32_t i_node);
+
+private:
+    VkDevice m_device;
+    const VkAllocationCallbacks* m_allocator;
+    VkDeviceMemory m_memory;
+    VkDeviceSize m_size;
+    uint32_t m_memoryType;
+    void* m_mappedData;
+
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_unusedNodes;
+    uint64_t m_firstLevelBitmap;
+    uint32_t m_secondLevelBitmaps[k_firstLevelCount];
+    uint32_t m_freeHeads[k_firstLevelCount][k_secondLevelCount];
+
+    VkDeviceSize m_usedBytes;
+    uint32_t m_allocationCount;
+};
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
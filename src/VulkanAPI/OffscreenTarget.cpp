@@ -0,0 +1,161 @@
+#include "stdafx.h"
+#include "OffscreenTarget.h"
+
+#include <vulkan/vulkan.h>
+#include <cstring>
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+
+OffscreenTarget::OffscreenTarget(MemoryAllocator& i_memoryAllocator, VkDevice i_device, VkFormat i_format, VkExtent2D i_extent, uint32_t i_imageCount, const VkAllocationCallbacks* i_allocator)
+    : m_memoryAllocator(i_memoryAllocator)
+    , m_device(i_device)
+    , m_allocator(i_allocator)
+    , m_format(i_format)
+    , m_extent(i_extent)
+{
+    m_images.resize(i_imageCount, VK_NULL_HANDLE);
+    m_imageMemories.resize(i_imageCount);
+
+    for (uint32_t i = 0; i < i_imageCount; i++)
+    {
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = m_format;
+        imageInfo.extent = { m_extent.width, m_extent.height, 1 };
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        if (vkCreateImage(m_device, &imageInfo, m_allocator, &m_images[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create offscreen image!");
+        }
+
+        m_imageMemories[i] = m_memoryAllocator.AllocateForImage(m_images[i], VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, imageInfo.tiling);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+OffscreenTarget::~OffscreenTarget()
+{
+    for (size_t i = 0; i < m_images.size(); i++)
+    {
+        vkDestroyImage(m_device, m_images[i], m_allocator);
+        m_memoryAllocator.Free(m_imageMemories[i]);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+std::vector<uint8_t> OffscreenTarget::ReadPixels(uint32_t i_imageIndex, VkCommandPool i_commandPool, VkQueue i_queue)
+{
+    assert(i_imageIndex < m_images.size());
+    const VkDeviceSize bufferSize = static_cast<VkDeviceSize>(m_extent.width) * m_extent.height * 4;
+
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = bufferSize;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VkBuffer buffer;
+    if (vkCreateBuffer(m_device, &bufferInfo, m_allocator, &buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create readback buffer!");
+    }
+
+    MemoryAllocation bufferMemory = m_memoryAllocator.AllocateForBuffer(buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    VkCommandBufferAllocateInfo commandBufferInfo{};
+    commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    commandBufferInfo.commandPool = i_commandPool;
+    commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferInfo.commandBufferCount = 1;
+
+    VkCommandBuffer commandBuffer;
+    if (vkAllocateCommandBuffers(m_device, &commandBufferInfo, &commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate readback command buffer!");
+    }
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+    VkBufferImageCopy region{};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = { 0, 0, 0 };
+    region.imageExtent = { m_extent.width, m_extent.height, 1 };
+    vkCmdCopyImageToBuffer(commandBuffer, m_images[i_imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer, 1, &region);
+
+    // Make the transfer write visible to the host read below
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    vkEndCommandBuffer(commandBuffer);
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    if (vkQueueSubmit(i_queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit readback command buffer!");
+    }
+    vkQueueWaitIdle(i_queue);
+
+    const bool isBgra = m_format == VK_FORMAT_B8G8R8A8_SRGB || m_format == VK_FORMAT_B8G8R8A8_UNORM;
+    const uint8_t* source = static_cast<const uint8_t*>(bufferMemory.mappedData);
+    const size_t pixelCount = static_cast<size_t>(m_extent.width) * m_extent.height;
+    std::vector<uint8_t> pixels(pixelCount * 3);
+    for (size_t i = 0; i < pixelCount; i++)
+    {
+        pixels[i * 3 + 0] = source[i * 4 + (isBgra ? 2 : 0)];
+        pixels[i * 3 + 1] = source[i * 4 + 1];
+        pixels[i * 3 + 2] = source[i * 4 + (isBgra ? 0 : 2)];
+    }
+
+    vkFreeCommandBuffers(m_device, i_commandPool, 1, &commandBuffer);
+    vkDestroyBuffer(m_device, buffer, m_allocator);
+    m_memoryAllocator.Free(bufferMemory);
+
+    return pixels;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+VkFormat OffscreenTarget::ChooseFormat(VkPhysicalDevice i_physicalDevice)
+{
+    // Same preference as the swapchain surface format
+    const VkFormat candidates[] = { VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_R8G8B8A8_SRGB, VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_R8G8B8A8_UNORM };
+    const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_TRANSFER_SRC_BIT;
+
+    for (VkFormat format : candidates)
+    {
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(i_physicalDevice, format, &properties);
+        if ((properties.optimalTilingFeatures & required) == required)
+        {
+            return format;
+        }
+    }
+
+    throw std::runtime_error("failed to find a format for offscreen rendering!");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
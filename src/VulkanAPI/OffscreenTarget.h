@@ -0,0 +1,46 @@
+#pragma once
+
+#include "VulkanAPI/MemoryAllocator.h"
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+// Stand-in for a swapchain when rendering without any surface
+class OffscreenTarget {
+///////////////////////////////////////////////////////////////////////////////
+public:
+    OffscreenTarget(MemoryAllocator& i_memoryAllocator, VkDevice i_device, VkFormat i_format, VkExtent2D i_extent, uint32_t i_imageCount, const VkAllocationCallbacks* i_allocator);
+    ~OffscreenTarget();
+
+    const std::vector<VkImage>& GetImages()
+    {
+        return m_images;
+    }
+
+    VkFormat GetFormat()
+    {
+        return m_format;
+    }
+
+    VkExtent2D GetExtent()
+    {
+        return m_extent;
+    }
+
+    // Copies an image left in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL to tightly packed RGB8 pixels, blocks until done
+    std::vector<uint8_t> ReadPixels(uint32_t i_imageIndex, VkCommandPool i_commandPool, VkQueue i_queue);
+
+    // First 8 bit color format the device can render to and copy from
+    static VkFormat ChooseFormat(VkPhysicalDevice i_physicalDevice);
+
+private:
+    MemoryAllocator& m_memoryAllocator;
+    VkDevice m_device;
+    const VkAllocationCallbacks* m_allocator;
+    VkFormat m_format;
+    VkExtent2D m_extent;
+    std::vector<VkImage> m_images;
+    std::vector<MemoryAllocation> m_imageMemories;
+};
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
@@ -0,0 +1,168 @@
+#include "stdafx.h"
+#include "ParallelCommandRecorder.h"
+
+#include "JobSystem.h"
+
+#include <vulkan/vulkan.h>
+#include <algorithm>
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+
+ParallelCommandRecorder::ParallelCommandRecorder(JobSystem& i_jobSystem, VkDevice i_device, uint32_t i_queueFamilyIndex, uint32_t i_framesInFlight, const VkAllocationCallbacks* i_allocator)
+    : m_jobSystem(i_jobSystem)
+    , m_device(i_device)
+    , m_allocator(i_allocator)
+    , m_frameIndex(0)
+{
+    assert(i_framesInFlight > 0);
+
+    m_framePools.resize(m_jobSystem.GetThreadCount());
+    for (std::vector<FramePool>& threadPools : m_framePools)
+    {
+        threadPools.resize(i_framesInFlight);
+        for (FramePool& framePool : threadPools)
+        {
+            // Transient, every buffer is re-recorded after the whole pool is reset
+            VkCommandPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            poolInfo.queueFamilyIndex = i_queueFamilyIndex;
+
+            if (vkCreateCommandPool(m_device, &poolInfo, m_allocator, &framePool.pool) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create recording command pool!");
+            }
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+ParallelCommandRecorder::~ParallelCommandRecorder()
+{
+    for (std::vector<FramePool>& threadPools : m_framePools)
+    {
+        for (FramePool& framePool : threadPools)
+        {
+            vkDestroyCommandPool(m_device, framePool.pool, m_allocator);
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+uint32_t ParallelCommandRecorder::GetThreadCount()
+{
+    return m_jobSystem.GetThreadCount();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ParallelCommandRecorder::BeginFrame(uint32_t i_frameIndex)
+{
+    assert(i_frameIndex < m_framePools[0].size());
+    m_frameIndex = i_frameIndex;
+
+    // No recording is in flight between Record calls, the pools can be reset from here
+    for (std::vector<FramePool>& threadPools : m_framePools)
+    {
+        FramePool& framePool = threadPools[m_frameIndex];
+        vkResetCommandPool(m_device, framePool.pool, 0);
+        framePool.used = 0;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ParallelCommandRecorder::Record(VkCommandBuffer i_primary, const VkCommandBufferInheritanceInfo& i_inheritance, uint32_t i_itemCount, uint32_t i_chunkSize, const RecordFunction& i_record)
+{
+    assert(i_chunkSize > 0);
+    if (i_itemCount == 0)
+    {
+        return;
+    }
+
+    const uint32_t chunkCount = (i_itemCount + i_chunkSize - 1) / i_chunkSize;
+    m_chunkCommandBuffers.assign(chunkCount, VK_NULL_HANDLE);
+    m_error = nullptr;
+
+    // One job per chunk, the calling thread records too while it waits
+    m_jobSystem.ParallelFor(chunkCount, 1, [&](uint32_t i_first, uint32_t i_count) {
+        for (uint32_t chunk = i_first; chunk < i_first + i_count; chunk++)
+        {
+            try
+            {
+                RecordChunk(chunk, i_inheritance, i_itemCount, i_chunkSize, i_record);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(m_errorMutex);
+                if (!m_error)
+                {
+                    m_error = std::current_exception();
+                }
+            }
+        }
+    });
+
+    if (m_error)
+    {
+        std::rethrow_exception(m_error);
+    }
+
+    vkCmdExecuteCommands(i_primary, chunkCount, m_chunkCommandBuffers.data());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ParallelCommandRecorder::RecordChunk(uint32_t i_chunk, const VkCommandBufferInheritanceInfo& i_inheritance, uint32_t i_itemCount, uint32_t i_chunkSize, const RecordFunction& i_record)
+{
+    FramePool& framePool = m_framePools[m_jobSystem.GetCurrentThreadIndex()][m_frameIndex];
+    VkCommandBuffer commandBuffer = AcquireCommandBuffer(framePool);
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &i_inheritance;
+
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin recording secondary command buffer!");
+    }
+
+    const uint32_t first = i_chunk * i_chunkSize;
+    const uint32_t count = std::min(i_chunkSize, i_itemCount - first);
+    i_record(commandBuffer, first, count);
+
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record secondary command buffer!");
+    }
+
+    // Each chunk owns its slot, no two threads write the same element
+    m_chunkCommandBuffers[i_chunk] = commandBuffer;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+VkCommandBuffer ParallelCommandRecorder::AcquireCommandBuffer(FramePool& io_framePool)
+{
+    if (io_framePool.used == io_framePool.commandBuffers.size())
+    {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = io_framePool.pool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer;
+        if (vkAllocateCommandBuffers(m_device, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate secondary command buffer!");
+        }
+        io_framePool.commandBuffers.push_back(commandBuffer);
+    }
+
+    return io_framePool.commandBuffers[io_framePool.used++];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <exception>
+#include <functional>
+#include <mutex>
+
+class JobSystem;
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+// Records a draw list into secondary command buffers on the threads of a JobSystem.
+// Every job system thread owns one VkCommandPool per frame slot so recording never locks a pool.
+// The list is cut into chunks, threads pick chunks as they go and the primary executes the
+// secondaries in chunk order, so the result does not depend on which thread recorded what.
+class ParallelCommandRecorder {
+///////////////////////////////////////////////////////////////////////////////
+public:
+    // Records items [i_first, i_first + i_count) into i_commandBuffer, called concurrently from several threads.
+    // State is not inherited by secondaries, bind the pipeline and set dynamic state in every call.
+    using RecordFunction = std::function<void(VkCommandBuffer i_commandBuffer, uint32_t i_first, uint32_t i_count)>;
+
+    ParallelCommandRecorder(JobSystem& i_jobSystem, VkDevice i_device, uint32_t i_queueFamilyIndex, uint32_t i_framesInFlight, const VkAllocationCallbacks* i_allocator);
+    ~ParallelCommandRecorder();
+
+    // Call once the fence of i_frameIndex has signaled, recycles every secondary of that slot
+    void BeginFrame(uint32_t i_frameIndex);
+
+    // Records i_itemCount items in chunks of i_chunkSize and executes them in i_primary, which must be inside
+    // a render pass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, or dynamic rendering begun with
+    // VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT and a VkCommandBufferInheritanceRenderingInfo chained
+    // to i_inheritance. Blocks until every chunk is recorded, call it from a thread of the job system.
+    void Record(VkCommandBuffer i_primary, const VkCommandBufferInheritanceInfo& i_inheritance, uint32_t i_itemCount, uint32_t i_chunkSize, const RecordFunction& i_record);
+
+    uint32_t GetThreadCount();
+
+private:
+    // Pool of one thread for one frame slot, buffers are reused in order after a reset
+    struct FramePool {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> commandBuffers;
+        size_t used = 0;
+    };
+
+    void RecordChunk(uint32_t i_chunk, const VkCommandBufferInheritanceInfo& i_inheritance, uint32_t i_itemCount, uint32_t i_chunkSize, const RecordFunction& i_record);
+    VkCommandBuffer AcquireCommandBuffer(FramePool& io_framePool);
+
+private:
+    JobSystem& m_jobSystem;
+    VkDevice m_device;
+    const VkAllocationCallbacks* m_allocator;
+    uint32_t m_frameIndex;
+    // [job system thread][frame slot]
+    std::vector<std::vector<FramePool>> m_framePools;
+
+    std::vector<VkCommandBuffer> m_chunkCommandBuffers;
+    // Jobs must not throw, the first error of a Record is kept and rethrown on the calling thread
+    std::mutex m_errorMutex;
+    std::exception_ptr m_error;
+};
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "PhysicalDevice.h"
 
+#include "VulkanAPI/HostAllocator.h"
 #include "VulkanAPI/LogicalDevice.h"
 
 #include <vulkan/vulkan.h>
@@ -26,12 +27,23 @@ PhysicalDevice::~PhysicalDevice()
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void PhysicalDevice::CreateLogicalDevice(const std::vector<const char*>& i_validationLayers, const std::vector<const char*>& i_deviceExtensions)
+DeviceFeatures PhysicalDevice::QueryFeatures(uint32_t i_instanceApiVersion)
+{
+	return DeviceFeatures::Query(m_device, i_instanceApiVersion);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void PhysicalDevice::CreateLogicalDevice(const std::vector<const char*>& i_validationLayers, const std::vector<const char*>& i_deviceExtensions, const DeviceFeatures& i_features, HostAllocator& i_hostAllocator)
 {
 	assert(m_queueFamilyIndices.IsComplete());
 
 	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 	std::set<uint32_t> uniqueQueueFamilies = { m_queueFamilyIndices.optGraphicsFamily.value(), m_queueFamilyIndices.optPresentFamily.value() };
+	if (m_queueFamilyIndices.optTransferFamily.has_value())
+	{
+		uniqueQueueFamilies.insert(m_queueFamilyIndices.optTransferFamily.value());
+	}
 	float queuePriority = 1.0f;
 
 	for (uint32_t queueFamily : uniqueQueueFamilies)
@@ -45,14 +57,22 @@ void PhysicalDevice::CreateLogicalDevice(const std::vector<const char*>& i_valid
 		queueCreateInfos.push_back(queueCreateInfo);
 	}
 
-	VkPhysicalDeviceFeatures deviceFeatures{};
-
 	VkDeviceCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 	createInfo.pQueueCreateInfos = queueCreateInfos.data();
 	createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 
-	createInfo.pEnabledFeatures = &deviceFeatures;
+	// From 1.2 on the features go through the pNext chain, pEnabledFeatures must then stay null
+	DeviceFeatureChain featureChain(i_features.apiVersion);
+	featureChain.Enable(i_features);
+	if (i_features.apiVersion >= VK_API_VERSION_1_2)
+	{
+		createInfo.pNext = featureChain.Get();
+	}
+	else
+	{
+		createInfo.pEnabledFeatures = &featureChain.Get()->features;
+	}
 
 	createInfo.enabledExtensionCount = static_cast<uint32_t>(i_deviceExtensions.size());
 	createInfo.ppEnabledExtensionNames = i_deviceExtensions.data();
@@ -66,13 +86,14 @@ void PhysicalDevice::CreateLogicalDevice(const std::vector<const char*>& i_valid
 		createInfo.enabledLayerCount = static_cast<uint32_t>(i_validationLayers.size());
 		createInfo.ppEnabledLayerNames = i_validationLayers.data();
 	}
+	const VkAllocationCallbacks* allocator = i_hostAllocator.GetCallbacks("PhysicalDevice::CreateLogicalDevice");
 	VkDevice logicalDevice;
-	VkResult result = vkCreateDevice(m_device, &createInfo, nullptr, &logicalDevice);
+	VkResult result = vkCreateDevice(m_device, &createInfo, allocator, &logicalDevice);
 	if (result != VK_SUCCESS) {
 	    throw std::runtime_error("failed to create logical device!");
 	}
 
-	m_logicalDevice = std::make_unique<LogicalDevice>(logicalDevice, m_queueFamilyIndices);
+	m_logicalDevice = std::make_unique<LogicalDevice>(m_device, logicalDevice, m_queueFamilyIndices, i_features, allocator, i_hostAllocator);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
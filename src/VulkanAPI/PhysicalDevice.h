@@ -1,9 +1,11 @@
 #pragma once
 
+#include "VulkanAPI/DeviceFeatures.h"
 #include "VulkanAPI/QueueFamilyIndices.h"
 
 namespace VulkanAPI
 {
+    class HostAllocator;
     class LogicalDevice;
 }
 
@@ -16,7 +18,10 @@ public:
     PhysicalDevice(VkPhysicalDevice i_device, QueueFamilyIndices& i_queueFamilyIndices);
     ~PhysicalDevice();
 
-    void CreateLogicalDevice(const std::vector<const char*>& i_validationLayers, const std::vector<const char*>& i_deviceExtensions);
+    // i_features must be a subset of what QueryFeatures reported, i_hostAllocator must outlive the logical device
+    void CreateLogicalDevice(const std::vector<const char*>& i_validationLayers, const std::vector<const char*>& i_deviceExtensions, const DeviceFeatures& i_features, HostAllocator& i_hostAllocator);
+    // i_instanceApiVersion is the version the instance was created for, features above it are not reported
+    DeviceFeatures QueryFeatures(uint32_t i_instanceApiVersion);
     VkPhysicalDevice GetDevice()
     {
         return m_device;
@@ -0,0 +1,230 @@
+#include "stdafx.h"
+#include "PipelineCache.h"
+
+#include "FileSystem.h"
+
+#include <vulkan/vulkan.h>
+#include <cstring>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+    constexpr uint32_t k_fileMagic = 0x4350564C; // "LVPC"
+    constexpr uint32_t k_fileVersion = 1;
+
+    // Written in front of the driver blob, the driver only validates its own header
+    // so truncated or bit-flipped files are caught by the hash
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t dataSize;
+        uint64_t dataHash;
+        double coldCreateMilliseconds;
+    };
+
+    // Layout of VkPipelineCacheHeaderVersionOne, read field by field to stay independent of padding
+    constexpr size_t k_vulkanHeaderSize = 16 + VK_UUID_SIZE;
+
+    uint64_t HashBytes(const char* i_data, size_t i_size)
+    {
+        // FNV-1a
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < i_size; i++)
+        {
+            hash ^= static_cast<uint8_t>(i_data[i]);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    uint32_t ReadUInt32(const char* i_data)
+    {
+        uint32_t value;
+        memcpy(&value, i_data, sizeof(value));
+        return value;
+    }
+}
+///////////////////////////////////////////////////////////////////////////////
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+
+PipelineCache::PipelineCache(VkDevice i_device, const VkPhysicalDeviceProperties& i_properties, const VkAllocationCallbacks* i_allocator)
+    : m_device(i_device)
+    , m_allocator(i_allocator)
+    , m_properties(i_properties)
+    , m_cache(VK_NULL_HANDLE)
+    , m_isWarm(false)
+    , m_coldCreateMilliseconds(0.0)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+PipelineCache::~PipelineCache()
+{
+    if (m_cache != VK_NULL_HANDLE)
+    {
+        vkDestroyPipelineCache(m_device, m_cache, m_allocator);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void PipelineCache::Load(FileSystem& i_fileSystem, const std::string& i_fileName)
+{
+    assert(m_cache == VK_NULL_HANDLE);
+
+    MappedFile file;
+    size_t dataOffset = 0;
+    size_t dataSize = 0;
+
+    if (i_fileSystem.FileExists(i_fileName))
+    {
+        file = i_fileSystem.MapFile(i_fileName);
+        if (ValidateFile(file.GetData(), file.GetSize(), dataOffset, dataSize))
+        {
+            m_isWarm = true;
+        }
+        else
+        {
+            std::cerr << "pipeline cache: rejected " << i_fileName << ", starting cold" << std::endl;
+        }
+    }
+
+    VkPipelineCacheCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = m_isWarm ? dataSize : 0;
+    createInfo.pInitialData = m_isWarm ? file.GetData() + dataOffset : nullptr;
+
+    if (vkCreatePipelineCache(m_device, &createInfo, m_allocator, &m_cache) != VK_SUCCESS)
+    {
+        if (!m_isWarm)
+        {
+            throw std::runtime_error("failed to create pipeline cache!");
+        }
+
+        // The driver is still allowed to refuse a blob that passed our checks
+        std::cerr << "pipeline cache: driver rejected " << i_fileName << ", starting cold" << std::endl;
+        m_isWarm = false;
+        createInfo.initialDataSize = 0;
+        createInfo.pInitialData = nullptr;
+        if (vkCreatePipelineCache(m_device, &createInfo, m_allocator, &m_cache) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create pipeline cache!");
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void PipelineCache::Save(FileSystem& i_fileSystem, const std::string& i_fileName)
+{
+    if (m_cache == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    size_t dataSize = 0;
+    if (vkGetPipelineCacheData(m_device, m_cache, &dataSize, nullptr) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to query pipeline cache size!");
+    }
+
+    std::vector<char> file(sizeof(FileHeader) + dataSize);
+    char* data = file.data() + sizeof(FileHeader);
+    if (vkGetPipelineCacheData(m_device, m_cache, &dataSize, data) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to retrieve pipeline cache data!");
+    }
+    file.resize(sizeof(FileHeader) + dataSize);
+
+    FileHeader header{};
+    header.magic = k_fileMagic;
+    header.version = k_fileVersion;
+    header.dataSize = dataSize;
+    header.dataHash = HashBytes(file.data() + sizeof(FileHeader), dataSize);
+    header.coldCreateMilliseconds = m_coldCreateMilliseconds;
+    memcpy(file.data(), &header, sizeof(header));
+
+    i_fileSystem.WriteFile(i_fileName, file);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool PipelineCache::ValidateFile(const char* i_file, size_t i_fileSize, size_t& o_dataOffset, size_t& o_dataSize)
+{
+    if (i_fileSize < sizeof(FileHeader))
+    {
+        return false;
+    }
+
+    FileHeader header;
+    memcpy(&header, i_file, sizeof(header));
+
+    if (header.magic != k_fileMagic || header.version != k_fileVersion)
+    {
+        return false;
+    }
+
+    if (header.dataSize != i_fileSize - sizeof(FileHeader))
+    {
+        return false;
+    }
+
+    const char* data = i_file + sizeof(FileHeader);
+    const size_t dataSize = static_cast<size_t>(header.dataSize);
+    if (HashBytes(data, dataSize) != header.dataHash)
+    {
+        return false;
+    }
+
+    if (!ValidateVulkanHeader(data, dataSize))
+    {
+        return false;
+    }
+
+    m_coldCreateMilliseconds = header.coldCreateMilliseconds;
+    o_dataOffset = sizeof(FileHeader);
+    o_dataSize = dataSize;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool PipelineCache::ValidateVulkanHeader(const char* i_data, size_t i_size)
+{
+    if (i_size < k_vulkanHeaderSize)
+    {
+        return false;
+    }
+
+    const uint32_t headerSize = ReadUInt32(i_data);
+    const uint32_t headerVersion = ReadUInt32(i_data + 4);
+    const uint32_t vendorID = ReadUInt32(i_data + 8);
+    const uint32_t deviceID = ReadUInt32(i_data + 12);
+    const char* pipelineCacheUUID = i_data + 16;
+
+    if (headerSize < k_vulkanHeaderSize || headerSize > i_size)
+    {
+        return false;
+    }
+
+    if (headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+    {
+        return false;
+    }
+
+    // A blob from another GPU or another driver build is stale
+    if (vendorID != m_properties.vendorID || deviceID != m_properties.deviceID)
+    {
+        return false;
+    }
+
+    return memcmp(pipelineCacheUUID, m_properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
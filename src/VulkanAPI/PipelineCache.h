@@ -0,0 +1,53 @@
+#pragma once
+
+class FileSystem;
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+class PipelineCache {
+///////////////////////////////////////////////////////////////////////////////
+public:
+    PipelineCache(VkDevice i_device, const VkPhysicalDeviceProperties& i_properties, const VkAllocationCallbacks* i_allocator);
+    ~PipelineCache();
+
+    // Creates the VkPipelineCache, seeded from i_fileName when the blob on disk is valid for this device
+    void Load(FileSystem& i_fileSystem, const std::string& i_fileName);
+    void Save(FileSystem& i_fileSystem, const std::string& i_fileName);
+
+    VkPipelineCache GetCache()
+    {
+        return m_cache;
+    }
+
+    // True when Load found a blob that was accepted for this device
+    bool IsWarm()
+    {
+        return m_isWarm;
+    }
+
+    // Pipeline creation time measured the last time the cache started cold, 0 if unknown
+    double GetColdCreateMilliseconds()
+    {
+        return m_coldCreateMilliseconds;
+    }
+
+    void SetColdCreateMilliseconds(double i_milliseconds)
+    {
+        m_coldCreateMilliseconds = i_milliseconds;
+    }
+
+private:
+    bool ValidateFile(const char* i_file, size_t i_fileSize, size_t& o_dataOffset, size_t& o_dataSize);
+    bool ValidateVulkanHeader(const char* i_data, size_t i_size);
+
+private:
+    VkDevice m_device;
+    const VkAllocationCallbacks* m_allocator;
+    VkPhysicalDeviceProperties m_properties;
+    VkPipelineCache m_cache;
+    bool m_isWarm;
+    double m_coldCreateMilliseconds;
+};
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
@@ -0,0 +1,322 @@
+#include "stdafx.h"
+#include "PipelineCompiler.h"
+
+#include "CpuTrace.h"
+
+#include <vulkan/vulkan.h>
+#include <chrono>
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+
+PipelineHandle::PipelineHandle()
+    : m_state(nullptr)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool PipelineHandle::IsValid() const
+{
+    return m_state != nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool PipelineHandle::IsReady() const
+{
+    return GetStatus() == Status::Ready;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+PipelineHandle::Status PipelineHandle::GetStatus() const
+{
+    assert(IsValid());
+    return m_state->status.load(std::memory_order_acquire);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+VkPipeline PipelineHandle::Get(VkPipeline i_fallback) const
+{
+    if (!IsValid() || !IsReady())
+    {
+        return i_fallback;
+    }
+
+    // The acquire load in IsReady makes the worker's write to pipeline visible
+    return m_state->pipeline;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+VkPipeline PipelineHandle::Wait() const
+{
+    assert(IsValid());
+
+    std::unique_lock<std::mutex> lock(m_state->mutex);
+    m_state->finished.wait(lock, [this]() { return m_state->status.load() != Status::Pending; });
+
+    if (m_state->status.load() == Status::Failed)
+    {
+        throw std::runtime_error("failed to create graphics pipeline!");
+    }
+
+    return m_state->pipeline;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+double PipelineHandle::GetCompileMilliseconds() const
+{
+    if (!IsValid() || GetStatus() == Status::Pending)
+    {
+        return 0.0;
+    }
+
+    return m_state->compileMilliseconds;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+PipelineCompiler::PipelineCompiler(VkDevice i_device, VkPipelineCache i_pipelineCache, const VkAllocationCallbacks* i_allocator, uint32_t i_threadCount)
+    : m_device(i_device)
+    , m_pipelineCache(i_pipelineCache)
+    , m_allocator(i_allocator)
+    , m_activeJobs(0)
+    , m_exiting(false)
+{
+    uint32_t threadCount = i_threadCount;
+    if (threadCount == 0)
+    {
+        const uint32_t coreCount = std::thread::hardware_concurrency();
+        threadCount = coreCount > 1 ? coreCount - 1 : 1;
+    }
+
+    m_workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        m_workers.emplace_back(&PipelineCompiler::WorkerMain, this);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+PipelineCompiler::~PipelineCompiler()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_exiting = true;
+    }
+    m_jobAvailable.notify_all();
+
+    for (std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+PipelineHandle PipelineCompiler::Submit(const GraphicsPipelineDesc& i_desc, ReadyCallback i_onReady)
+{
+    PipelineHandle handle;
+    handle.m_state = std::make_shared<PipelineHandle::State>();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(Job{ i_desc, std::move(i_onReady), handle.m_state });
+    }
+    m_jobAvailable.notify_one();
+
+    return handle;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void PipelineCompiler::WaitIdle()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this]() { return m_jobs.empty() && m_activeJobs == 0; });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void PipelineCompiler::WorkerMain()
+{
+    for (;;)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_jobAvailable.wait(lock, [this]() { return m_exiting || !m_jobs.empty(); });
+
+            // Pending jobs are finished before exiting so no handle is left pending forever
+            if (m_jobs.empty())
+            {
+                return;
+            }
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+            m_activeJobs++;
+        }
+
+        const auto compileStart = std::chrono::steady_clock::now();
+
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        try
+        {
+            pipeline = CompileGraphicsPipeline(m_device, m_pipelineCache, m_allocator, job.desc);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "pipeline compiler: " << e.what() << std::endl;
+        }
+
+        const double compileMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - compileStart).count();
+
+        {
+            std::lock_guard<std::mutex> lock(job.state->mutex);
+            job.state->pipeline = pipeline;
+            job.state->compileMilliseconds = compileMilliseconds;
+            job.state->status.store(pipeline != VK_NULL_HANDLE ? PipelineHandle::Status::Ready : PipelineHandle::Status::Failed, std::memory_order_release);
+        }
+        job.state->finished.notify_all();
+
+        if (job.onReady)
+        {
+            job.onReady(pipeline, compileMilliseconds);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_activeJobs--;
+            if (m_jobs.empty() && m_activeJobs == 0)
+            {
+                m_idle.notify_all();
+            }
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+VkPipeline PipelineCompiler::CompileGraphicsPipeline(VkDevice i_device, VkPipelineCache i_pipelineCache, const VkAllocationCallbacks* i_allocator, const GraphicsPipelineDesc& i_desc)
+{
+    CPU_TRACE_ZONE("PipelineCompiler::CompileGraphicsPipeline");
+
+    std::vector<VkPipelineShaderStageCreateInfo> shaderStages(i_desc.shaderStages.size());
+    std::vector<VkSpecializationInfo> specializationInfos(i_desc.shaderStages.size());
+    for (size_t i = 0; i < i_desc.shaderStages.size(); i++)
+    {
+        const GraphicsPipelineDesc::ShaderStage& shaderStage = i_desc.shaderStages[i];
+        shaderStages[i].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shaderStages[i].stage = shaderStage.stage;
+        shaderStages[i].module = shaderStage.module;
+        shaderStages[i].pName = shaderStage.entryPoint.c_str();
+
+        if (!shaderStage.specializationEntries.empty())
+        {
+            specializationInfos[i].mapEntryCount = static_cast<uint32_t>(shaderStage.specializationEntries.size());
+            specializationInfos[i].pMapEntries = shaderStage.specializationEntries.data();
+            specializationInfos[i].dataSize = shaderStage.specializationData.size();
+            specializationInfos[i].pData = shaderStage.specializationData.data();
+            shaderStages[i].pSpecializationInfo = &specializationInfos[i];
+        }
+    }
+
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(i_desc.vertexBindings.size());
+    vertexInputInfo.pVertexBindingDescriptions = i_desc.vertexBindings.data();
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(i_desc.vertexAttributes.size());
+    vertexInputInfo.pVertexAttributeDescriptions = i_desc.vertexAttributes.data();
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = i_desc.topology;
+    inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+    VkPipelineDynamicStateCreateInfo dynamicState{};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = static_cast<uint32_t>(i_desc.dynamicStates.size());
+    dynamicState.pDynamicStates = i_desc.dynamicStates.data();
+
+    VkPipelineViewportStateCreateInfo viewportState{};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer{};
+    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.depthClampEnable = VK_FALSE;
+    rasterizer.rasterizerDiscardEnable = VK_FALSE;
+    rasterizer.polygonMode = i_desc.polygonMode;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = i_desc.cullMode;
+    rasterizer.frontFace = i_desc.frontFace;
+    rasterizer.depthBiasEnable = VK_FALSE;
+
+    VkPipelineMultisampleStateCreateInfo multisampling{};
+    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.sampleShadingEnable = VK_FALSE;
+    multisampling.rasterizationSamples = i_desc.rasterizationSamples;
+    multisampling.minSampleShading = 1.0f; // Optional
+
+    VkPipelineDepthStencilStateCreateInfo depthStencil{};
+    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable = i_desc.depthTestEnable ? VK_TRUE : VK_FALSE;
+    depthStencil.depthWriteEnable = i_desc.depthWriteEnable ? VK_TRUE : VK_FALSE;
+    depthStencil.depthCompareOp = i_desc.depthCompareOp;
+    depthStencil.depthBoundsTestEnable = VK_FALSE;
+    depthStencil.stencilTestEnable = VK_FALSE;
+
+    VkPipelineColorBlendStateCreateInfo colorBlending{};
+    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.logicOpEnable = VK_FALSE;
+    colorBlending.logicOp = VK_LOGIC_OP_COPY; // Optional
+    colorBlending.attachmentCount = static_cast<uint32_t>(i_desc.colorBlendAttachments.size());
+    colorBlending.pAttachments = i_desc.colorBlendAttachments.data();
+
+    // Without a render pass the attachment formats stand in for it (dynamic rendering)
+    VkPipelineRenderingCreateInfo renderingInfo{};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+    renderingInfo.colorAttachmentCount = static_cast<uint32_t>(i_desc.colorFormats.size());
+    renderingInfo.pColorAttachmentFormats = i_desc.colorFormats.data();
+    renderingInfo.depthAttachmentFormat = i_desc.depthFormat;
+    renderingInfo.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext = i_desc.renderPass == VK_NULL_HANDLE ? &renderingInfo : nullptr;
+    pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+    pipelineInfo.pStages = shaderStages.data();
+    pipelineInfo.pVertexInputState = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState = &multisampling;
+    // Only read when the render pass has a depth attachment
+    pipelineInfo.pDepthStencilState = i_desc.depthFormat != VK_FORMAT_UNDEFINED ? &depthStencil : nullptr;
+    pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.layout = i_desc.layout;
+    pipelineInfo.renderPass = i_desc.renderPass;
+    pipelineInfo.subpass = i_desc.subpass;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
+    pipelineInfo.basePipelineIndex = -1; // Optional
+
+    // The pipeline cache is internally synchronized, workers can share it
+    VkPipeline pipeline;
+    if (vkCreateGraphicsPipelines(i_device, i_pipelineCache, 1, &pipelineInfo, i_allocator, &pipeline) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create graphics pipeline!");
+    }
+
+    return pipeline;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
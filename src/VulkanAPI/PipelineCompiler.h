@@ -0,0 +1,108 @@
+#pragma once
+
+#include "VulkanAPI/GraphicsPipelineDesc.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+// Shared view of a pipeline that may still be compiling
+class PipelineHandle {
+///////////////////////////////////////////////////////////////////////////////
+public:
+    enum class Status
+    {
+        Pending,
+        Ready,
+        Failed,
+    };
+
+    PipelineHandle();
+
+    bool IsValid() const;
+    bool IsReady() const;
+    Status GetStatus() const;
+
+    // Never blocks, returns i_fallback until the pipeline is ready
+    VkPipeline Get(VkPipeline i_fallback = VK_NULL_HANDLE) const;
+    // Blocks until compilation finished, throws if it failed
+    VkPipeline Wait() const;
+
+    double GetCompileMilliseconds() const;
+
+private:
+    friend class PipelineCompiler;
+
+    struct State
+    {
+        std::atomic<Status> status{ Status::Pending };
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        double compileMilliseconds = 0.0;
+        mutable std::mutex mutex;
+        mutable std::condition_variable finished;
+    };
+
+    std::shared_ptr<State> m_state;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Compiles graphics pipelines on worker threads so the main loop never blocks on the driver
+class PipelineCompiler {
+///////////////////////////////////////////////////////////////////////////////
+public:
+    // Called on the worker thread once the pipeline is created, i_pipeline is VK_NULL_HANDLE on failure
+    using ReadyCallback = std::function<void(VkPipeline i_pipeline, double i_compileMilliseconds)>;
+
+    // i_threadCount of 0 uses one thread per core, leaving one for the main thread.
+    // i_allocator is used from the worker threads, it must be thread safe.
+    PipelineCompiler(VkDevice i_device, VkPipelineCache i_pipelineCache, const VkAllocationCallbacks* i_allocator, uint32_t i_threadCount = 0);
+    ~PipelineCompiler();
+
+    PipelineHandle Submit(const GraphicsPipelineDesc& i_desc, ReadyCallback i_onReady = nullptr);
+    // Blocks until every submitted pipeline has finished compiling
+    void WaitIdle();
+
+    uint32_t GetThreadCount()
+    {
+        return static_cast<uint32_t>(m_workers.size());
+    }
+
+    // Destroy the compiled pipelines with these
+    const VkAllocationCallbacks* GetAllocator()
+    {
+        return m_allocator;
+    }
+
+    static VkPipeline CompileGraphicsPipeline(VkDevice i_device, VkPipelineCache i_pipelineCache, const VkAllocationCallbacks* i_allocator, const GraphicsPipelineDesc& i_desc);
+
+private:
+    struct Job
+    {
+        GraphicsPipelineDesc desc;
+        ReadyCallback onReady;
+        std::shared_ptr<PipelineHandle::State> state;
+    };
+
+    void WorkerMain();
+
+private:
+    VkDevice m_device;
+    VkPipelineCache m_pipelineCache;
+    const VkAllocationCallbacks* m_allocator;
+
+    std::vector<std::thread> m_workers;
+    std::deque<Job> m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_jobAvailable;
+    std::condition_variable m_idle;
+    uint32_t m_activeJobs;
+    bool m_exiting;
+};
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
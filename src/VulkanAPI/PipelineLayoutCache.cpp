@@ -0,0 +1,255 @@
+#include "stdafx.h"
+#include "PipelineLayoutCache.h"
+
+#include "VulkanAPI/ShaderReflection.h"
+
+#include <vulkan/vulkan.h>
+#include <algorithm>
+#include <cstring>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+    void AppendHandle(std::vector<uint32_t>& io_key, uint64_t i_handle)
+    {
+        io_key.push_back(static_cast<uint32_t>(i_handle));
+        io_key.push_back(static_cast<uint32_t>(i_handle >> 32));
+    }
+
+    template<typename T>
+    uint64_t ToHandleBits(T i_handle)
+    {
+        // Non-dispatchable handles are pointers on 64-bit targets and uint64_t on 32-bit ones
+        uint64_t bits = 0;
+        memcpy(&bits, &i_handle, sizeof(i_handle));
+        return bits;
+    }
+}
+///////////////////////////////////////////////////////////////////////////////
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+
+size_t PipelineLayoutCache::KeyHash::operator()(const Key& i_key) const
+{
+    // FNV-1a over the words
+    uint64_t hash = 14695981039346656037ull;
+    for (uint32_t word : i_key)
+    {
+        hash ^= word;
+        hash *= 1099511628211ull;
+    }
+    return static_cast<size_t>(hash);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+PipelineLayoutCache::PipelineLayoutCache(VkDevice i_device, const VkAllocationCallbacks* i_allocator)
+    : m_device(i_device)
+    , m_allocator(i_allocator)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+PipelineLayoutCache::~PipelineLayoutCache()
+{
+    for (auto& entry : m_pipelineLayouts)
+    {
+        vkDestroyPipelineLayout(m_device, entry.second, m_allocator);
+    }
+    for (auto& entry : m_setLayouts)
+    {
+        vkDestroyDescriptorSetLayout(m_device, entry.second, m_allocator);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+VkPipelineLayout PipelineLayoutCache::GetPipelineLayout(const std::vector<const ShaderReflection*>& i_stages)
+{
+    // [set][binding], the stages of a pipeline see the same descriptor through one binding
+    std::map<uint32_t, std::map<uint32_t, VkDescriptorSetLayoutBinding>> sets;
+    std::vector<VkPushConstantRange> pushConstantRanges;
+
+    for (const ShaderReflection* stage : i_stages)
+    {
+        for (const ShaderReflection::DescriptorBinding& descriptor : stage->descriptorBindings)
+        {
+            if (descriptor.descriptorCount == 0)
+            {
+                throw std::runtime_error("failed to create pipeline layout, runtime sized descriptor arrays are not supported!");
+            }
+
+            auto inserted = sets[descriptor.set].emplace(descriptor.binding, VkDescriptorSetLayoutBinding{});
+            VkDescriptorSetLayoutBinding& binding = inserted.first->second;
+            if (inserted.second)
+            {
+                binding.binding = descriptor.binding;
+                binding.descriptorType = descriptor.descriptorType;
+                binding.descriptorCount = descriptor.descriptorCount;
+            }
+            else if (binding.descriptorType != descriptor.descriptorType || binding.descriptorCount != descriptor.descriptorCount)
+            {
+                throw std::runtime_error("failed to create pipeline layout, stages disagree on descriptor " + descriptor.name + "!");
+            }
+            binding.stageFlags |= stage->stage;
+        }
+
+        for (const VkPushConstantRange& range : stage->pushConstantRanges)
+        {
+            // Stages reading the same bytes share a range, keeps the signature independent of stage order
+            auto it = std::find_if(pushConstantRanges.begin(), pushConstantRanges.end(), [&range](const VkPushConstantRange& i_other) {
+                return i_other.offset == range.offset && i_other.size == range.size;
+            });
+            if (it != pushConstantRanges.end())
+            {
+                it->stageFlags |= range.stageFlags;
+            }
+            else
+            {
+                pushConstantRanges.push_back(range);
+            }
+        }
+    }
+
+    std::sort(pushConstantRanges.begin(), pushConstantRanges.end(), [](const VkPushConstantRange& i_a, const VkPushConstantRange& i_b) {
+        return i_a.offset != i_b.offset ? i_a.offset < i_b.offset : i_a.size < i_b.size;
+    });
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<VkDescriptorSetLayout> setLayouts;
+    if (!sets.empty())
+    {
+        setLayouts.resize(sets.rbegin()->first + 1, VK_NULL_HANDLE);
+    }
+    for (uint32_t set = 0; set < setLayouts.size(); set++)
+    {
+        std::vector<VkDescriptorSetLayoutBinding> bindings;
+        auto it = sets.find(set);
+        if (it != sets.end())
+        {
+            for (const auto& binding : it->second)
+            {
+                bindings.push_back(binding.second);
+            }
+        }
+        setLayouts[set] = GetDescriptorSetLayoutLocked(bindings);
+    }
+
+    return GetPipelineLayoutLocked(setLayouts, pushConstantRanges);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+VkPipelineLayout PipelineLayoutCache::GetPipelineLayout(const std::vector<VkDescriptorSetLayout>& i_setLayouts, const std::vector<VkPushConstantRange>& i_pushConstantRanges)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return GetPipelineLayoutLocked(i_setLayouts, i_pushConstantRanges);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+VkDescriptorSetLayout PipelineLayoutCache::GetDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& i_bindings)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return GetDescriptorSetLayoutLocked(i_bindings);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+std::vector<VkDescriptorSetLayout> PipelineLayoutCache::GetSetLayouts(VkPipelineLayout i_pipelineLayout)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_pipelineSetLayouts.find(i_pipelineLayout);
+    assert(it != m_pipelineSetLayouts.end());
+    return it->second;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+VkDescriptorSetLayout PipelineLayoutCache::GetDescriptorSetLayoutLocked(const std::vector<VkDescriptorSetLayoutBinding>& i_bindings)
+{
+    // Sorted so the same set declared in another order still hits
+    std::vector<VkDescriptorSetLayoutBinding> bindings = i_bindings;
+    std::sort(bindings.begin(), bindings.end(), [](const VkDescriptorSetLayoutBinding& i_a, const VkDescriptorSetLayoutBinding& i_b) {
+        return i_a.binding < i_b.binding;
+    });
+
+    Key key;
+    key.reserve(bindings.size() * 4);
+    for (const VkDescriptorSetLayoutBinding& binding : bindings)
+    {
+        assert(binding.pImmutableSamplers == nullptr);
+        key.push_back(binding.binding);
+        key.push_back(static_cast<uint32_t>(binding.descriptorType));
+        key.push_back(binding.descriptorCount);
+        key.push_back(binding.stageFlags);
+    }
+
+    auto it = m_setLayouts.find(key);
+    if (it != m_setLayouts.end())
+    {
+        return it->second;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+
+    VkDescriptorSetLayout setLayout;
+    if (vkCreateDescriptorSetLayout(m_device, &layoutInfo, m_allocator, &setLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor set layout!");
+    }
+
+    m_setLayouts.emplace(std::move(key), setLayout);
+    return setLayout;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+VkPipelineLayout PipelineLayoutCache::GetPipelineLayoutLocked(const std::vector<VkDescriptorSetLayout>& i_setLayouts, const std::vector<VkPushConstantRange>& i_pushConstantRanges)
+{
+    // Set layouts are deduplicated already, their handles stand for their content
+    Key key;
+    key.reserve(1 + i_setLayouts.size() * 2 + i_pushConstantRanges.size() * 3);
+    key.push_back(static_cast<uint32_t>(i_setLayouts.size()));
+    for (VkDescriptorSetLayout setLayout : i_setLayouts)
+    {
+        AppendHandle(key, ToHandleBits(setLayout));
+    }
+    for (const VkPushConstantRange& range : i_pushConstantRanges)
+    {
+        key.push_back(range.stageFlags);
+        key.push_back(range.offset);
+        key.push_back(range.size);
+    }
+
+    auto it = m_pipelineLayouts.find(key);
+    if (it != m_pipelineLayouts.end())
+    {
+        return it->second;
+    }
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(i_setLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = i_setLayouts.data();
+    pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(i_pushConstantRanges.size());
+    pipelineLayoutInfo.pPushConstantRanges = i_pushConstantRanges.data();
+
+    VkPipelineLayout pipelineLayout;
+    if (vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, m_allocator, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline layout!");
+    }
+
+    m_pipelineLayouts.emplace(std::move(key), pipelineLayout);
+    m_pipelineSetLayouts.emplace(pipelineLayout, i_setLayouts);
+    return pipelineLayout;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <mutex>
+#include <unordered_map>
+
+namespace VulkanAPI
+{
+    struct ShaderReflection;
+}
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+// Deduplicates descriptor set layouts and pipeline layouts by their signature.
+// Pipelines whose shaders declare the same interface share one layout, which keeps
+// descriptor sets bound across pipeline switches. Layouts live as long as the cache.
+class PipelineLayoutCache {
+///////////////////////////////////////////////////////////////////////////////
+public:
+    PipelineLayoutCache(VkDevice i_device, const VkAllocationCallbacks* i_allocator);
+    ~PipelineLayoutCache();
+
+    // Merges the interfaces of every stage of a pipeline, throws when they disagree on a binding
+    VkPipelineLayout GetPipelineLayout(const std::vector<const ShaderReflection*>& i_stages);
+    // i_setLayouts in set order, empty layouts fill the unused sets
+    VkPipelineLayout GetPipelineLayout(const std::vector<VkDescriptorSetLayout>& i_setLayouts, const std::vector<VkPushConstantRange>& i_pushConstantRanges);
+    // Bindings without immutable samplers, in any order
+    VkDescriptorSetLayout GetDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& i_bindings);
+
+    // Set layouts of a layout returned by GetPipelineLayout, to allocate its descriptor sets
+    std::vector<VkDescriptorSetLayout> GetSetLayouts(VkPipelineLayout i_pipelineLayout);
+
+private:
+    // Signatures flattened to words, compared in full so a hash collision can't alias two layouts
+    using Key = std::vector<uint32_t>;
+
+    struct KeyHash {
+        size_t operator()(const Key& i_key) const;
+    };
+
+    VkDescriptorSetLayout GetDescriptorSetLayoutLocked(const std::vector<VkDescriptorSetLayoutBinding>& i_bindings);
+    VkPipelineLayout GetPipelineLayoutLocked(const std::vector<VkDescriptorSetLayout>& i_setLayouts, const std::vector<VkPushConstantRange>& i_pushConstantRanges);
+
+private:
+    VkDevice m_device;
+    const VkAllocationCallbacks* m_allocator;
+    std::mutex m_mutex;
+    std::unordered_map<Key, VkDescriptorSetLayout, KeyHash> m_setLayouts;
+    std::unordered_map<Key, VkPipelineLayout, KeyHash> m_pipelineLayouts;
+    std::unordered_map<VkPipelineLayout, std::vector<VkDescriptorSetLayout>> m_pipelineSetLayouts;
+};
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
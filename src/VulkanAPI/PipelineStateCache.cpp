@@ -0,0 +1,146 @@
+#include "stdafx.h"
+#include "PipelineStateCache.h"
+
+#include "VulkanAPI/ShaderPermutation.h"
+
+#include <vulkan/vulkan.h>
+#include <iomanip>
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+
+PipelineStateCache::PipelineStateCache(VkDevice i_device, PipelineCompiler& i_compiler)
+    : m_device(i_device)
+    , m_compiler(i_compiler)
+    , m_allocator(i_compiler.GetAllocator())
+    , m_hitCount(0)
+    , m_missCount(0)
+    , m_failedCount(0)
+    , m_compileMicroseconds(0)
+{
+    static_assert(k_shardCount == 16, "GetShard takes the top 4 bits of the hash");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+PipelineStateCache::~PipelineStateCache()
+{
+    for (Shard& shard : m_shards)
+    {
+        for (auto& entry : shard.entries)
+        {
+            // Every compile has finished once the compiler is gone
+            vkDestroyPipeline(m_device, entry.second.pipeline.Get(), m_allocator);
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+PipelineHandle PipelineStateCache::GetPipeline(const GraphicsPipelineDesc& i_desc, PipelineCompiler::ReadyCallback i_onReady)
+{
+    const uint64_t hash = i_desc.Hash();
+    Shard& shard = GetShard(hash);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto range = shard.entries.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second.desc == i_desc)
+        {
+            m_hitCount.fetch_add(1, std::memory_order_relaxed);
+            return it->second.pipeline;
+        }
+    }
+
+    m_missCount.fetch_add(1, std::memory_order_relaxed);
+
+    // Submitted under the shard lock so a concurrent request for the same state can't compile it twice
+    PipelineHandle pipeline = m_compiler.Submit(i_desc, [this, onReady = std::move(i_onReady)](VkPipeline i_pipeline, double i_compileMilliseconds)
+    {
+        m_compileMicroseconds.fetch_add(static_cast<uint64_t>(i_compileMilliseconds * 1000.0), std::memory_order_relaxed);
+        if (i_pipeline == VK_NULL_HANDLE)
+        {
+            m_failedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (onReady)
+        {
+            onReady(i_pipeline, i_compileMilliseconds);
+        }
+    });
+
+    shard.entries.emplace(hash, Entry{ i_desc, pipeline });
+    return pipeline;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+PipelineHandle PipelineStateCache::GetPipeline(const GraphicsPipelineDesc& i_desc, uint32_t i_permutationMask, PipelineCompiler::ReadyCallback i_onReady)
+{
+    return GetPipeline(ShaderPermutation::Specialize(i_desc, i_permutationMask), std::move(i_onReady));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+PipelineHandle PipelineStateCache::Remove(const GraphicsPipelineDesc& i_desc)
+{
+    const uint64_t hash = i_desc.Hash();
+    Shard& shard = GetShard(hash);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto range = shard.entries.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second.desc == i_desc)
+        {
+            PipelineHandle pipeline = it->second.pipeline;
+            shard.entries.erase(it);
+            return pipeline;
+        }
+    }
+
+    return PipelineHandle();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+PipelineHandle PipelineStateCache::Remove(const GraphicsPipelineDesc& i_desc, uint32_t i_permutationMask)
+{
+    return Remove(ShaderPermutation::Specialize(i_desc, i_permutationMask));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+PipelineStateCache::Statistics PipelineStateCache::GetStatistics()
+{
+    Statistics statistics{};
+    statistics.hitCount = m_hitCount.load(std::memory_order_relaxed);
+    statistics.missCount = m_missCount.load(std::memory_order_relaxed);
+    statistics.failedCount = m_failedCount.load(std::memory_order_relaxed);
+    statistics.compileMilliseconds = m_compileMicroseconds.load(std::memory_order_relaxed) / 1000.0;
+
+    for (Shard& shard : m_shards)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        statistics.pipelineCount += shard.entries.size();
+    }
+
+    return statistics;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void PipelineStateCache::PrintStatistics()
+{
+    const Statistics statistics = GetStatistics();
+
+    std::cout << std::fixed << std::setprecision(2)
+        << "pipeline states: " << statistics.pipelineCount << " cached, "
+        << statistics.hitCount << " hits, " << statistics.missCount << " misses, "
+        << statistics.failedCount << " failed, "
+        << statistics.compileMilliseconds << " ms compiling" << std::endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "VulkanAPI/GraphicsPipelineDesc.h"
+#include "VulkanAPI/PipelineCompiler.h"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+// Deduplicates graphics pipelines by their full description. A request for a state that was
+// seen before returns the existing handle, compiled or still compiling, without touching the
+// driver. The table is split into shards with a lock each so threads requesting pipelines
+// rarely contend. The cache owns every pipeline it hands out.
+class PipelineStateCache {
+///////////////////////////////////////////////////////////////////////////////
+public:
+    struct Statistics {
+        uint64_t hitCount;
+        uint64_t missCount;
+        uint64_t failedCount;
+        // Summed over every finished compile
+        double compileMilliseconds;
+        size_t pipelineCount;
+    };
+
+    // Destroy the compiler before the cache, its workers report back into it
+    PipelineStateCache(VkDevice i_device, PipelineCompiler& i_compiler);
+    ~PipelineStateCache();
+
+    // i_onReady only runs when the state was not cached yet. A state that failed to compile stays
+    // failed, identical requests get the failed handle back.
+    PipelineHandle GetPipeline(const GraphicsPipelineDesc& i_desc, PipelineCompiler::ReadyCallback i_onReady = nullptr);
+    // The permutation i_permutationMask of i_desc, see ShaderPermutation. Every mask is a state of its own,
+    // so materials picking different feature switches of the same shaders get different pipelines.
+    PipelineHandle GetPipeline(const GraphicsPipelineDesc& i_desc, uint32_t i_permutationMask, PipelineCompiler::ReadyCallback i_onReady = nullptr);
+    // Forgets i_desc before one of its shader modules is destroyed, a new module could reuse the handle value.
+    // The caller takes over the pipeline, the returned handle is invalid if the state was not cached.
+    PipelineHandle Remove(const GraphicsPipelineDesc& i_desc);
+    PipelineHandle Remove(const GraphicsPipelineDesc& i_desc, uint32_t i_permutationMask);
+
+    Statistics GetStatistics();
+    void PrintStatistics();
+
+private:
+    static constexpr size_t k_shardCount = 16;
+
+    struct Entry {
+        GraphicsPipelineDesc desc;
+        PipelineHandle pipeline;
+    };
+
+    // Buckets are keyed by the hash, colliding descriptions sit in the same bucket and are told apart by comparison
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_multimap<uint64_t, Entry> entries;
+    };
+
+    Shard& GetShard(uint64_t i_hash)
+    {
+        // The map consumes the low bits, the shard takes the high ones
+        return m_shards[i_hash >> 60];
+    }
+
+private:
+    VkDevice m_device;
+    PipelineCompiler& m_compiler;
+    // Copied, the compiler is gone by the time the cache destroys its pipelines
+    const VkAllocationCallbacks* m_allocator;
+    Shard m_shards[k_shardCount];
+
+    std::atomic<uint64_t> m_hitCount;
+    std::atomic<uint64_t> m_missCount;
+    std::atomic<uint64_t> m_failedCount;
+    std::atomic<uint64_t> m_compileMicroseconds;
+};
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
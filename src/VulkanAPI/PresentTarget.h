@@ -0,0 +1,17 @@
+#pragma once
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+// Where rendered frames end up
+enum class PresentTarget
+{
+    // Swapchain on the GLFW window surface
+    Window,
+    // Swapchain on a VK_EXT_headless_surface, falls back to Offscreen when unsupported
+    HeadlessSurface,
+    // Plain VkImages, no surface and no swapchain, frames can be read back
+    Offscreen,
+};
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
@@ -7,11 +7,19 @@ struct QueueFamilyIndices
 {
 	std::optional<uint32_t> optGraphicsFamily;
 	std::optional<uint32_t> optPresentFamily;
+	// Transfer only family, typically the copy engine (DMA) that runs next to graphics
+	std::optional<uint32_t> optTransferFamily;
 
 	inline bool IsComplete()
 	{
 		return optGraphicsFamily.has_value() && optPresentFamily.has_value();
 	}
+
+	// Graphics queues support transfer too, they stand in when there is no dedicated family
+	inline uint32_t GetTransferFamily()
+	{
+		return optTransferFamily.value_or(optGraphicsFamily.value());
+	}
 };
 ///////////////////////////////////////////////////////////////////////////////
 } //namespace VulkanAPI
\ No newline at end of file
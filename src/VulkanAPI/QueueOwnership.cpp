@@ -0,0 +1,107 @@
+#include "stdafx.h"
+#include "QueueOwnership.h"
+
+#include <vulkan/vulkan.h>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+    VkBufferMemoryBarrier MakeBufferBarrier(VkBuffer i_buffer, VkDeviceSize i_offset, VkDeviceSize i_size, uint32_t i_srcFamily, uint32_t i_dstFamily)
+    {
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = i_srcFamily;
+        barrier.dstQueueFamilyIndex = i_dstFamily;
+        barrier.buffer = i_buffer;
+        barrier.offset = i_offset;
+        barrier.size = i_size;
+        return barrier;
+    }
+
+    VkImageMemoryBarrier MakeImageBarrier(VkImage i_image, const VkImageSubresourceRange& i_range, VkImageLayout i_oldLayout, VkImageLayout i_newLayout, uint32_t i_srcFamily, uint32_t i_dstFamily)
+    {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = i_oldLayout;
+        barrier.newLayout = i_newLayout;
+        barrier.srcQueueFamilyIndex = i_srcFamily;
+        barrier.dstQueueFamilyIndex = i_dstFamily;
+        barrier.image = i_image;
+        barrier.subresourceRange = i_range;
+        return barrier;
+    }
+}
+///////////////////////////////////////////////////////////////////////////////
+
+namespace VulkanAPI
+{
+namespace QueueOwnership
+{
+///////////////////////////////////////////////////////////////////////////////
+
+void ReleaseBuffer(VkCommandBuffer i_commandBuffer, VkBuffer i_buffer, VkDeviceSize i_offset, VkDeviceSize i_size,
+    uint32_t i_srcFamily, uint32_t i_dstFamily, VkPipelineStageFlags i_srcStage, VkAccessFlags i_srcAccess)
+{
+    if (i_srcFamily == i_dstFamily)
+    {
+        return;
+    }
+
+    // Destination access is ignored on the releasing queue, the semaphore carries the dependency
+    VkBufferMemoryBarrier barrier = MakeBufferBarrier(i_buffer, i_offset, i_size, i_srcFamily, i_dstFamily);
+    barrier.srcAccessMask = i_srcAccess;
+    barrier.dstAccessMask = 0;
+    vkCmdPipelineBarrier(i_commandBuffer, i_srcStage, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void AcquireBuffer(VkCommandBuffer i_commandBuffer, VkBuffer i_buffer, VkDeviceSize i_offset, VkDeviceSize i_size,
+    uint32_t i_srcFamily, uint32_t i_dstFamily, VkPipelineStageFlags i_dstStage, VkAccessFlags i_dstAccess)
+{
+    if (i_srcFamily == i_dstFamily)
+    {
+        return;
+    }
+
+    VkBufferMemoryBarrier barrier = MakeBufferBarrier(i_buffer, i_offset, i_size, i_srcFamily, i_dstFamily);
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = i_dstAccess;
+    vkCmdPipelineBarrier(i_commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, i_dstStage, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ReleaseImage(VkCommandBuffer i_commandBuffer, VkImage i_image, const VkImageSubresourceRange& i_range, VkImageLayout i_oldLayout, VkImageLayout i_newLayout,
+    uint32_t i_srcFamily, uint32_t i_dstFamily, VkPipelineStageFlags i_srcStage, VkAccessFlags i_srcAccess)
+{
+    if (i_srcFamily == i_dstFamily)
+    {
+        return;
+    }
+
+    VkImageMemoryBarrier barrier = MakeImageBarrier(i_image, i_range, i_oldLayout, i_newLayout, i_srcFamily, i_dstFamily);
+    barrier.srcAccessMask = i_srcAccess;
+    barrier.dstAccessMask = 0;
+    vkCmdPipelineBarrier(i_commandBuffer, i_srcStage, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void AcquireImage(VkCommandBuffer i_commandBuffer, VkImage i_image, const VkImageSubresourceRange& i_range, VkImageLayout i_oldLayout, VkImageLayout i_newLayout,
+    uint32_t i_srcFamily, uint32_t i_dstFamily, VkPipelineStageFlags i_dstStage, VkAccessFlags i_dstAccess)
+{
+    if (i_srcFamily == i_dstFamily)
+    {
+        return;
+    }
+
+    VkImageMemoryBarrier barrier = MakeImageBarrier(i_image, i_range, i_oldLayout, i_newLayout, i_srcFamily, i_dstFamily);
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = i_dstAccess;
+    vkCmdPipelineBarrier(i_commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, i_dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} //namespace QueueOwnership
+} //namespace VulkanAPI
@@ -0,0 +1,24 @@
+#pragma once
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+// Queue family ownership transfer of VK_SHARING_MODE_EXCLUSIVE resources.
+// A transfer is a matching pair of barriers: the release is recorded on a queue of the source family,
+// the acquire on a queue of the destination family, and a semaphore orders the two submissions.
+// Both sides must use the same families, range and layouts. Nothing is recorded when the families match.
+namespace QueueOwnership
+{
+    void ReleaseBuffer(VkCommandBuffer i_commandBuffer, VkBuffer i_buffer, VkDeviceSize i_offset, VkDeviceSize i_size,
+        uint32_t i_srcFamily, uint32_t i_dstFamily, VkPipelineStageFlags i_srcStage, VkAccessFlags i_srcAccess);
+    void AcquireBuffer(VkCommandBuffer i_commandBuffer, VkBuffer i_buffer, VkDeviceSize i_offset, VkDeviceSize i_size,
+        uint32_t i_srcFamily, uint32_t i_dstFamily, VkPipelineStageFlags i_dstStage, VkAccessFlags i_dstAccess);
+
+    // The layout transition happens once, as part of the pair
+    void ReleaseImage(VkCommandBuffer i_commandBuffer, VkImage i_image, const VkImageSubresourceRange& i_range, VkImageLayout i_oldLayout, VkImageLayout i_newLayout,
+        uint32_t i_srcFamily, uint32_t i_dstFamily, VkPipelineStageFlags i_srcStage, VkAccessFlags i_srcAccess);
+    void AcquireImage(VkCommandBuffer i_commandBuffer, VkImage i_image, const VkImageSubresourceRange& i_range, VkImageLayout i_oldLayout, VkImageLayout i_newLayout,
+        uint32_t i_srcFamily, uint32_t i_dstFamily, VkPipelineStageFlags i_dstStage, VkAccessFlags i_dstAccess);
+} //namespace QueueOwnership
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
@@ -6,7 +6,7 @@ namespace VulkanAPI
 struct RequiredInstanceExtensionsInfo
 {
     uint32_t Count = 0;
-    const char** Extensions;
+    const char** Extensions = nullptr;
 };
 ///////////////////////////////////////////////////////////////////////////////
 } //namespace VulkanAPI
\ No newline at end of file
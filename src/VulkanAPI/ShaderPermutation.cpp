@@ -0,0 +1,89 @@
+#include "stdafx.h"
+#include "ShaderPermutation.h"
+
+#include "VulkanAPI/ShaderReflection.h"
+
+#include <vulkan/vulkan.h>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+    bool IsFeatureSwitch(const VulkanAPI::ShaderReflection::SpecializationConstant& i_constant)
+    {
+        return i_constant.type == VulkanAPI::ShaderReflection::SpecializationConstant::Type::Bool
+            && i_constant.constantId < VulkanAPI::ShaderPermutation::k_maxFeatureBits;
+    }
+}
+///////////////////////////////////////////////////////////////////////////////
+
+namespace VulkanAPI
+{
+namespace ShaderPermutation
+{
+///////////////////////////////////////////////////////////////////////////////
+
+uint32_t GetFeatureBits(const ShaderReflection& i_reflection)
+{
+    uint32_t featureBits = 0;
+    for (const ShaderReflection::SpecializationConstant& constant : i_reflection.specializationConstants)
+    {
+        if (IsFeatureSwitch(constant))
+        {
+            featureBits |= 1u << constant.constantId;
+        }
+    }
+    return featureBits;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Specialize(uint32_t i_permutation, GraphicsPipelineDesc::ShaderStage& io_stage)
+{
+    io_stage.specializationEntries.clear();
+    io_stage.specializationData.clear();
+
+    // Every switch is written, even the ones left off, so the specialization data alone identifies the permutation
+    for (uint32_t constantId = 0; constantId < k_maxFeatureBits; constantId++)
+    {
+        if ((io_stage.featureBits & (1u << constantId)) == 0)
+        {
+            continue;
+        }
+
+        const VkBool32 value = (i_permutation & (1u << constantId)) != 0 ? VK_TRUE : VK_FALSE;
+
+        VkSpecializationMapEntry entry{};
+        entry.constantID = constantId;
+        entry.offset = static_cast<uint32_t>(io_stage.specializationData.size());
+        entry.size = sizeof(value);
+        io_stage.specializationEntries.push_back(entry);
+
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        io_stage.specializationData.insert(io_stage.specializationData.end(), bytes, bytes + sizeof(value));
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+GraphicsPipelineDesc Specialize(const GraphicsPipelineDesc& i_desc, uint32_t i_permutation)
+{
+    uint32_t featureBits = 0;
+    for (const GraphicsPipelineDesc::ShaderStage& shaderStage : i_desc.shaderStages)
+    {
+        featureBits |= shaderStage.featureBits;
+    }
+    if ((i_permutation & ~featureBits) != 0) {
+        throw std::runtime_error("failed to specialize shaders, the permutation sets a feature bit no shader declares!");
+    }
+
+    GraphicsPipelineDesc desc = i_desc;
+    for (GraphicsPipelineDesc::ShaderStage& shaderStage : desc.shaderStages)
+    {
+        Specialize(i_permutation, shaderStage);
+    }
+    return desc;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} //namespace ShaderPermutation
+} //namespace VulkanAPI
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "VulkanAPI/GraphicsPipelineDesc.h"
+
+namespace VulkanAPI
+{
+    struct ShaderReflection;
+}
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+// Feature switches are boolean specialization constants with an id below 32:
+//     layout(constant_id = 3) const bool k_useFog = false;
+// is switched on by bit 3 of a permutation. The driver folds the constant, so branches on
+// a switched off feature are stripped when the pipeline compiles instead of taken at runtime.
+namespace ShaderPermutation
+{
+    constexpr uint32_t k_maxFeatureBits = 32;
+
+    // Bits of the switches a stage declares
+    uint32_t GetFeatureBits(const ShaderReflection& i_reflection);
+
+    // Sets every switch in io_stage.featureBits from i_permutation, other specialization constants keep their defaults
+    void Specialize(uint32_t i_permutation, GraphicsPipelineDesc::ShaderStage& io_stage);
+
+    // i_desc with every stage specialized for i_permutation, the featureBits of its stages must be set.
+    // Throws when i_permutation sets a bit no stage declares, it would silently give the unspecialized pipeline.
+    GraphicsPipelineDesc Specialize(const GraphicsPipelineDesc& i_desc, uint32_t i_permutation);
+} //namespace ShaderPermutation
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
@@ -0,0 +1,710 @@
+#include "stdafx.h"
+#include "ShaderReflection.h"
+
+#include <vulkan/vulkan.h>
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+    constexpr uint32_t k_spirvMagic = 0x07230203;
+    constexpr uint32_t k_headerWordCount = 5;
+    // Nested types deeper than this are treated as malformed, it keeps a cyclic module from recursing forever
+    constexpr uint32_t k_maxTypeDepth = 32;
+
+    // Opcodes, decorations and enumerants from the SPIR-V specification, only the ones reflection reads
+    enum Op : uint32_t
+    {
+        OpName = 5,
+        OpEntryPoint = 15,
+        OpTypeBool = 20,
+        OpTypeInt = 21,
+        OpTypeFloat = 22,
+        OpTypeVector = 23,
+        OpTypeMatrix = 24,
+        OpTypeImage = 25,
+        OpTypeSampler = 26,
+        OpTypeSampledImage = 27,
+        OpTypeArray = 28,
+        OpTypeRuntimeArray = 29,
+        OpTypeStruct = 30,
+        OpTypePointer = 32,
+        OpConstant = 43,
+        OpSpecConstantTrue = 48,
+        OpSpecConstantFalse = 49,
+        OpSpecConstant = 50,
+        OpVariable = 59,
+        OpDecorate = 71,
+        OpMemberDecorate = 72,
+    };
+
+    enum Decoration : uint32_t
+    {
+        DecorationSpecId = 1,
+        DecorationBlock = 2,
+        DecorationBufferBlock = 3,
+        DecorationArrayStride = 6,
+        DecorationMatrixStride = 7,
+        DecorationBuiltIn = 11,
+        DecorationLocation = 30,
+        DecorationBinding = 33,
+        DecorationDescriptorSet = 34,
+        DecorationOffset = 35,
+    };
+
+    enum StorageClass : uint32_t
+    {
+        StorageClassUniformConstant = 0,
+        StorageClassInput = 1,
+        StorageClassUniform = 2,
+        StorageClassPushConstant = 9,
+        StorageClassStorageBuffer = 12,
+    };
+
+    enum Dim : uint32_t
+    {
+        DimBuffer = 5,
+        DimSubpassData = 6,
+    };
+
+    constexpr uint32_t k_noValue = ~0u;
+
+    struct Decorations
+    {
+        uint32_t set = k_noValue;
+        uint32_t binding = k_noValue;
+        uint32_t location = k_noValue;
+        uint32_t specId = k_noValue;
+        uint32_t arrayStride = 0;
+        bool block = false;
+        bool bufferBlock = false;
+        bool builtIn = false;
+    };
+
+    struct MemberDecorations
+    {
+        uint32_t offset = 0;
+        uint32_t matrixStride = 0;
+    };
+
+    // Where an id is defined, operands start after the result id
+    struct Definition
+    {
+        uint32_t opcode = 0;
+        const uint32_t* operands = nullptr;
+        uint32_t operandCount = 0;
+    };
+
+    struct Variable
+    {
+        uint32_t id;
+        uint32_t pointerType;
+        uint32_t storageClass;
+    };
+
+    struct Module
+    {
+        std::vector<Definition> definitions;
+        std::vector<Decorations> decorations;
+        std::map<std::pair<uint32_t, uint32_t>, MemberDecorations> memberDecorations;
+        std::map<uint32_t, std::string> names;
+        std::vector<Variable> variables;
+        std::vector<uint32_t> specConstants;
+    };
+
+    void Fail(const char* i_reason)
+    {
+        throw std::runtime_error(std::string("failed to reflect shader, ") + i_reason + "!");
+    }
+
+    // Literal strings are nul terminated and padded to whole words
+    std::string ReadString(const uint32_t* i_words, uint32_t i_wordCount, uint32_t& o_usedWords)
+    {
+        const char* characters = reinterpret_cast<const char*>(i_words);
+        const size_t maxLength = static_cast<size_t>(i_wordCount) * sizeof(uint32_t);
+        const size_t length = std::find(characters, characters + maxLength, '\0') - characters;
+        if (length == maxLength)
+        {
+            Fail("unterminated string");
+        }
+        o_usedWords = static_cast<uint32_t>(length / sizeof(uint32_t) + 1);
+        return std::string(characters, length);
+    }
+
+    const Definition& GetDefinition(const Module& i_module, uint32_t i_id)
+    {
+        if (i_id >= i_module.definitions.size() || i_module.definitions[i_id].opcode == 0)
+        {
+            Fail("undefined id");
+        }
+        return i_module.definitions[i_id];
+    }
+
+    // i_definition must have at least i_count operands
+    const Definition& Require(const Definition& i_definition, uint32_t i_count)
+    {
+        if (i_definition.operandCount < i_count)
+        {
+            Fail("truncated definition");
+        }
+        return i_definition;
+    }
+
+    uint32_t GetConstantValue(const Module& i_module, uint32_t i_id)
+    {
+        // Result type precedes the result id for constants, the value is the first word after it
+        const Definition& constant = GetDefinition(i_module, i_id);
+        if (constant.opcode != OpConstant || constant.operandCount < 1)
+        {
+            Fail("array length is not a constant");
+        }
+        return constant.operands[0];
+    }
+
+    uint32_t GetTypeSize(const Module& i_module, uint32_t i_typeId, uint32_t i_matrixStride, uint32_t i_depth)
+    {
+        if (i_depth > k_maxTypeDepth)
+        {
+            Fail("types nested too deep");
+        }
+
+        const Definition& type = GetDefinition(i_module, i_typeId);
+        switch (type.opcode)
+        {
+        case OpTypeBool:
+            return sizeof(uint32_t);
+        case OpTypeInt:
+        case OpTypeFloat:
+            return Require(type, 1).operands[0] / 8;
+        case OpTypeVector:
+            Require(type, 2);
+            return type.operands[1] * GetTypeSize(i_module, type.operands[0], 0, i_depth + 1);
+        case OpTypeMatrix:
+            Require(type, 2);
+            return type.operands[1] * (i_matrixStride != 0 ? i_matrixStride : GetTypeSize(i_module, type.operands[0], 0, i_depth + 1));
+        case OpTypeArray:
+        {
+            Require(type, 2);
+            const uint32_t stride = i_module.decorations[i_typeId].arrayStride;
+            const uint32_t length = GetConstantValue(i_module, type.operands[1]);
+            return length * (stride != 0 ? stride : GetTypeSize(i_module, type.operands[0], i_matrixStride, i_depth + 1));
+        }
+        case OpTypeStruct:
+        {
+            // Members carry explicit offsets, the struct ends where its furthest member ends
+            uint32_t size = 0;
+            for (uint32_t member = 0; member < type.operandCount; member++)
+            {
+                MemberDecorations memberDecorations;
+                auto it = i_module.memberDecorations.find({ i_typeId, member });
+                if (it != i_module.memberDecorations.end())
+                {
+                    memberDecorations = it->second;
+                }
+                const uint32_t memberSize = GetTypeSize(i_module, type.operands[member], memberDecorations.matrixStride, i_depth + 1);
+                size = std::max(size, memberDecorations.offset + memberSize);
+            }
+            return size;
+        }
+        default:
+            Fail("unsized type in a block");
+            return 0;
+        }
+    }
+
+    VkShaderStageFlagBits ToShaderStage(uint32_t i_executionModel)
+    {
+        switch (i_executionModel)
+        {
+        case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+        case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+        case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+        case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+        case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+        case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+        default:
+            Fail("unsupported execution model");
+            return VK_SHADER_STAGE_ALL;
+        }
+    }
+
+    VkDescriptorType ToDescriptorType(const Module& i_module, uint32_t i_storageClass, uint32_t i_typeId)
+    {
+        const Definition& type = GetDefinition(i_module, i_typeId);
+
+        if (i_storageClass == StorageClassStorageBuffer)
+        {
+            return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        }
+        if (i_storageClass == StorageClassUniform)
+        {
+            // Before SPIR-V 1.3 storage buffers were Uniform blocks decorated BufferBlock
+            return i_module.decorations[i_typeId].bufferBlock ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        }
+
+        switch (type.opcode)
+        {
+        case OpTypeSampler:
+            return VK_DESCRIPTOR_TYPE_SAMPLER;
+        case OpTypeSampledImage:
+            return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        case OpTypeImage:
+        {
+            // Sampled type, dim, depth, arrayed, multisampled, sampled
+            Require(type, 6);
+            const uint32_t dim = type.operands[1];
+            const bool storage = type.operands[5] == 2;
+            if (dim == DimBuffer)
+            {
+                return storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+            }
+            if (dim == DimSubpassData)
+            {
+                return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+            }
+            return storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        }
+        default:
+            Fail("unsupported descriptor type");
+            return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+        }
+    }
+
+    VkFormat ToVertexFormat(const Module& i_module, uint32_t i_typeId)
+    {
+        const Definition* type = &GetDefinition(i_module, i_typeId);
+        uint32_t componentCount = 1;
+        if (type->opcode == OpTypeVector)
+        {
+            Require(*type, 2);
+            componentCount = type->operands[1];
+            type = &GetDefinition(i_module, type->operands[0]);
+        }
+
+        Require(*type, 1);
+        const uint32_t width = type->operands[0];
+        if (componentCount < 1 || componentCount > 4 || width != 32)
+        {
+            Fail("unsupported vertex input type");
+        }
+
+        static const VkFormat k_floatFormats[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+        static const VkFormat k_intFormats[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+        static const VkFormat k_uintFormats[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+        if (type->opcode == OpTypeFloat)
+        {
+            return k_floatFormats[componentCount - 1];
+        }
+        if (type->opcode == OpTypeInt)
+        {
+            // Operands are the width and then the signedness, 1 for signed
+            return Require(*type, 2).operands[1] != 0 ? k_intFormats[componentCount - 1] : k_uintFormats[componentCount - 1];
+        }
+        Fail("unsupported vertex input type");
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    uint32_t GetFormatSize(VkFormat i_format)
+    {
+        switch (i_format)
+        {
+        case VK_FORMAT_R32_SFLOAT: case VK_FORMAT_R32_SINT: case VK_FORMAT_R32_UINT:
+            return 4;
+        case VK_FORMAT_R32G32_SFLOAT: case VK_FORMAT_R32G32_SINT: case VK_FORMAT_R32G32_UINT:
+            return 8;
+        case VK_FORMAT_R32G32B32_SFLOAT: case VK_FORMAT_R32G32B32_SINT: case VK_FORMAT_R32G32B32_UINT:
+            return 12;
+        default:
+            return 16;
+        }
+    }
+
+    std::string GetName(const Module& i_module, uint32_t i_id)
+    {
+        auto it = i_module.names.find(i_id);
+        return it != i_module.names.end() ? it->second : std::string();
+    }
+}
+///////////////////////////////////////////////////////////////////////////////
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+
+ShaderReflection ShaderReflection::Reflect(const uint32_t* i_code, size_t i_codeSize)
+{
+    if (i_codeSize < k_headerWordCount * sizeof(uint32_t) || i_codeSize % sizeof(uint32_t) != 0 || i_code[0] != k_spirvMagic)
+    {
+        Fail("not SPIR-V");
+    }
+
+    const uint32_t wordCount = static_cast<uint32_t>(i_codeSize / sizeof(uint32_t));
+    const uint32_t idBound = i_code[3];
+    // Every id is the result of an instruction of at least two words, a larger bound is corrupt
+    // and must not size the tables below
+    if (idBound > wordCount)
+    {
+        Fail("id bound larger than the module");
+    }
+
+    Module module;
+    module.definitions.resize(idBound);
+    module.decorations.resize(idBound);
+
+    ShaderReflection reflection;
+    bool hasEntryPoint = false;
+
+    auto checkId = [idBound](uint32_t i_id) {
+        if (i_id >= idBound)
+        {
+            Fail("id out of bounds");
+        }
+        return i_id;
+    };
+
+    for (uint32_t offset = k_headerWordCount; offset < wordCount; )
+    {
+        const uint32_t instructionWordCount = i_code[offset] >> 16;
+        const uint32_t opcode = i_code[offset] & 0xFFFF;
+        if (instructionWordCount == 0 || instructionWordCount > wordCount - offset)
+        {
+            Fail("truncated instruction");
+        }
+
+        const uint32_t* operands = i_code + offset + 1;
+        const uint32_t operandCount = instructionWordCount - 1;
+        offset += instructionWordCount;
+
+        switch (opcode)
+        {
+        case OpEntryPoint:
+        {
+            if (operandCount < 3)
+            {
+                Fail("truncated entry point");
+            }
+            if (hasEntryPoint)
+            {
+                Fail("more than one entry point");
+            }
+            hasEntryPoint = true;
+
+            uint32_t usedWords = 0;
+            reflection.stage = ToShaderStage(operands[0]);
+            reflection.entryPoint = ReadString(operands + 2, operandCount - 2, usedWords);
+            break;
+        }
+        case OpName:
+            if (operandCount >= 2)
+            {
+                uint32_t usedWords = 0;
+                module.names[checkId(operands[0])] = ReadString(operands + 1, operandCount - 1, usedWords);
+            }
+            break;
+        case OpDecorate:
+        {
+            if (operandCount < 2)
+            {
+                Fail("truncated decoration");
+            }
+            Decorations& decorations = module.decorations[checkId(operands[0])];
+            const uint32_t value = operandCount >= 3 ? operands[2] : 0;
+            switch (operands[1])
+            {
+            case DecorationSpecId: decorations.specId = value; break;
+            case DecorationBlock: decorations.block = true; break;
+            case DecorationBufferBlock: decorations.bufferBlock = true; break;
+            case DecorationArrayStride: decorations.arrayStride = value; break;
+            case DecorationBuiltIn: decorations.builtIn = true; break;
+            case DecorationLocation: decorations.location = value; break;
+            case DecorationBinding: decorations.binding = value; break;
+            case DecorationDescriptorSet: decorations.set = value; break;
+            default: break;
+            }
+            break;
+        }
+        case OpMemberDecorate:
+        {
+            if (operandCount < 3)
+            {
+                Fail("truncated member decoration");
+            }
+            const uint32_t value = operandCount >= 4 ? operands[3] : 0;
+            if (operands[2] == DecorationOffset)
+            {
+                module.memberDecorations[{ checkId(operands[0]), operands[1] }].offset = value;
+            }
+            else if (operands[2] == DecorationMatrixStride)
+            {
+                module.memberDecorations[{ checkId(operands[0]), operands[1] }].matrixStride = value;
+            }
+            break;
+        }
+        case OpTypeBool:
+        case OpTypeInt:
+        case OpTypeFloat:
+        case OpTypeVector:
+        case OpTypeMatrix:
+        case OpTypeImage:
+        case OpTypeSampler:
+        case OpTypeSampledImage:
+        case OpTypeArray:
+        case OpTypeRuntimeArray:
+        case OpTypeStruct:
+        case OpTypePointer:
+            if (operandCount < 1)
+            {
+                Fail("truncated type");
+            }
+            module.definitions[checkId(operands[0])] = { opcode, operands + 1, operandCount - 1 };
+            break;
+        case OpConstant:
+        case OpSpecConstantTrue:
+        case OpSpecConstantFalse:
+        case OpSpecConstant:
+            // Result type, result id, value words
+            if (operandCount < 2)
+            {
+                Fail("truncated constant");
+            }
+            if (opcode == OpConstant)
+            {
+                module.definitions[checkId(operands[1])] = { opcode, operands + 2, operandCount - 2 };
+            }
+            else
+            {
+                // The value words are typed by the result type, keep it with them
+                module.definitions[checkId(operands[1])] = { opcode, operands, operandCount };
+                module.specConstants.push_back(operands[1]);
+            }
+            break;
+        case OpVariable:
+            if (operandCount < 3)
+            {
+                Fail("truncated variable");
+            }
+            module.variables.push_back({ checkId(operands[1]), checkId(operands[0]), operands[2] });
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (!hasEntryPoint)
+    {
+        Fail("no entry point");
+    }
+
+    for (const Variable& variable : module.variables)
+    {
+        const Definition& pointer = Require(GetDefinition(module, variable.pointerType), 2);
+        if (pointer.opcode != OpTypePointer)
+        {
+            Fail("variable is not a pointer");
+        }
+        uint32_t typeId = pointer.operands[1];
+        const Decorations& decorations = module.decorations[variable.id];
+
+        switch (variable.storageClass)
+        {
+        case StorageClassUniformConstant:
+        case StorageClassUniform:
+        case StorageClassStorageBuffer:
+        {
+            if (decorations.set == k_noValue || decorations.binding == k_noValue)
+            {
+                break;
+            }
+
+            DescriptorBinding binding;
+            binding.set = decorations.set;
+            binding.binding = decorations.binding;
+            binding.descriptorCount = 1;
+            binding.name = GetName(module, variable.id);
+
+            // Arrays of descriptors, the element type decides the descriptor type
+            for (uint32_t depth = 0; ; depth++)
+            {
+                const Definition& type = GetDefinition(module, typeId);
+                if (depth > k_maxTypeDepth)
+                {
+                    Fail("types nested too deep");
+                }
+                if (type.opcode == OpTypeArray)
+                {
+                    binding.descriptorCount *= GetConstantValue(module, Require(type, 2).operands[1]);
+                    typeId = type.operands[0];
+                }
+                else if (type.opcode == OpTypeRuntimeArray)
+                {
+                    binding.descriptorCount = 0;
+                    typeId = Require(type, 1).operands[0];
+                }
+                else
+                {
+                    break;
+                }
+            }
+
+            binding.descriptorType = ToDescriptorType(module, variable.storageClass, typeId);
+            reflection.descriptorBindings.push_back(binding);
+            break;
+        }
+        case StorageClassPushConstant:
+        {
+            const Definition& block = GetDefinition(module, typeId);
+            if (block.opcode != OpTypeStruct)
+            {
+                Fail("push constant is not a block");
+            }
+
+            // Blocks can start past 0 when stages share one push constant range layout
+            uint32_t begin = UINT32_MAX;
+            for (uint32_t member = 0; member < block.operandCount; member++)
+            {
+                auto it = module.memberDecorations.find({ typeId, member });
+                begin = std::min(begin, it != module.memberDecorations.end() ? it->second.offset : 0u);
+            }
+            const uint32_t end = GetTypeSize(module, typeId, 0, 0);
+            if (block.operandCount == 0 || end <= begin)
+            {
+                break;
+            }
+
+            VkPushConstantRange range{};
+            range.stageFlags = reflection.stage;
+            range.offset = begin;
+            range.size = end - begin;
+            reflection.pushConstantRanges.push_back(range);
+            break;
+        }
+        case StorageClassInput:
+        {
+            if (reflection.stage != VK_SHADER_STAGE_VERTEX_BIT || decorations.builtIn || decorations.location == k_noValue)
+            {
+                break;
+            }
+
+            // Matrices take one location per column
+            const Definition& type = GetDefinition(module, typeId);
+            const bool isMatrix = type.opcode == OpTypeMatrix;
+            const uint32_t columnCount = isMatrix ? Require(type, 2).operands[1] : 1;
+            const uint32_t columnType = isMatrix ? type.operands[0] : typeId;
+            for (uint32_t column = 0; column < columnCount; column++)
+            {
+                VertexInput input;
+                input.location = decorations.location + column;
+                input.format = ToVertexFormat(module, columnType);
+                input.name = GetName(module, variable.id);
+                reflection.vertexInputs.push_back(input);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    for (uint32_t id : module.specConstants)
+    {
+        const Decorations& decorations = module.decorations[id];
+        if (decorations.specId == k_noValue)
+        {
+            // Composites of other spec constants have no id of their own
+            continue;
+        }
+
+        // Full operands: result type, result id, value words
+        const Definition& constant = module.definitions[id];
+        const Definition& type = GetDefinition(module, constant.operands[0]);
+
+        SpecializationConstant specializationConstant;
+        specializationConstant.constantId = decorations.specId;
+        specializationConstant.name = GetName(module, id);
+        specializationConstant.defaultValue = 0;
+
+        if (constant.opcode == OpSpecConstantTrue || constant.opcode == OpSpecConstantFalse)
+        {
+            specializationConstant.type = SpecializationConstant::Type::Bool;
+            specializationConstant.size = sizeof(VkBool32);
+            specializationConstant.defaultValue = constant.opcode == OpSpecConstantTrue ? VK_TRUE : VK_FALSE;
+        }
+        else
+        {
+            Require(type, 1);
+            const uint32_t width = type.operands[0];
+            if (type.opcode == OpTypeFloat)
+            {
+                specializationConstant.type = SpecializationConstant::Type::Float;
+            }
+            else if (type.opcode == OpTypeInt)
+            {
+                specializationConstant.type = Require(type, 2).operands[1] != 0 ? SpecializationConstant::Type::Int : SpecializationConstant::Type::UInt;
+            }
+            else
+            {
+                Fail("unsupported specialization constant type");
+            }
+
+            specializationConstant.size = width / 8;
+            const uint32_t valueWordCount = width > 32 ? 2 : 1;
+            if (constant.operandCount < 2 + valueWordCount)
+            {
+                Fail("truncated specialization constant");
+            }
+            specializationConstant.defaultValue = constant.operands[2];
+            if (valueWordCount == 2)
+            {
+                specializationConstant.defaultValue |= static_cast<uint64_t>(constant.operands[3]) << 32;
+            }
+        }
+
+        reflection.specializationConstants.push_back(specializationConstant);
+    }
+
+    std::sort(reflection.descriptorBindings.begin(), reflection.descriptorBindings.end(), [](const DescriptorBinding& i_a, const DescriptorBinding& i_b) {
+        return i_a.set != i_b.set ? i_a.set < i_b.set : i_a.binding < i_b.binding;
+    });
+    std::sort(reflection.vertexInputs.begin(), reflection.vertexInputs.end(), [](const VertexInput& i_a, const VertexInput& i_b) {
+        return i_a.location < i_b.location;
+    });
+    std::sort(reflection.specializationConstants.begin(), reflection.specializationConstants.end(), [](const SpecializationConstant& i_a, const SpecializationConstant& i_b) {
+        return i_a.constantId < i_b.constantId;
+    });
+
+    return reflection;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ShaderReflection::BuildVertexInput(uint32_t i_binding, std::vector<VkVertexInputBindingDescription>& o_bindings, std::vector<VkVertexInputAttributeDescription>& o_attributes) const
+{
+    o_bindings.clear();
+    o_attributes.clear();
+    if (vertexInputs.empty())
+    {
+        return;
+    }
+
+    uint32_t offset = 0;
+    for (const VertexInput& input : vertexInputs)
+    {
+        VkVertexInputAttributeDescription attribute{};
+        attribute.location = input.location;
+        attribute.binding = i_binding;
+        attribute.format = input.format;
+        attribute.offset = offset;
+        o_attributes.push_back(attribute);
+        offset += GetFormatSize(input.format);
+    }
+
+    VkVertexInputBindingDescription binding{};
+    binding.binding = i_binding;
+    binding.stride = offset;
+    binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    o_bindings.push_back(binding);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
@@ -0,0 +1,64 @@
+#pragma once
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+// Interface of one SPIR-V module, parsed straight from the binary.
+// Covers what pipeline creation needs: descriptors, push constants, vertex inputs and specialization constants.
+struct ShaderReflection
+{
+    struct DescriptorBinding
+    {
+        uint32_t set;
+        uint32_t binding;
+        VkDescriptorType descriptorType;
+        // Product of the array dimensions, 0 for a runtime sized array
+        uint32_t descriptorCount;
+        std::string name;
+    };
+
+    struct VertexInput
+    {
+        uint32_t location;
+        VkFormat format;
+        std::string name;
+    };
+
+    struct SpecializationConstant
+    {
+        enum class Type
+        {
+            Bool,
+            Int,
+            UInt,
+            Float,
+        };
+
+        uint32_t constantId;
+        Type type;
+        // Bytes in VkSpecializationMapEntry, booleans are VkBool32
+        uint32_t size;
+        // Raw bits of the default value
+        uint64_t defaultValue;
+        std::string name;
+    };
+
+    VkShaderStageFlagBits stage = VK_SHADER_STAGE_VERTEX_BIT;
+    std::string entryPoint;
+    // Sorted by set, then binding
+    std::vector<DescriptorBinding> descriptorBindings;
+    // At most one, covering the push constant block members this stage declares
+    std::vector<VkPushConstantRange> pushConstantRanges;
+    // Vertex stage only, sorted by location
+    std::vector<VertexInput> vertexInputs;
+    // Sorted by constant id
+    std::vector<SpecializationConstant> specializationConstants;
+
+    // Throws when the code is not valid SPIR-V or uses something reflection does not understand
+    static ShaderReflection Reflect(const uint32_t* i_code, size_t i_codeSize);
+
+    // One tightly packed binding with the inputs in location order
+    void BuildVertexInput(uint32_t i_binding, std::vector<VkVertexInputBindingDescription>& o_bindings, std::vector<VkVertexInputAttributeDescription>& o_attributes) const;
+};
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
@@ -0,0 +1,32 @@
+#include "stdafx.h"
+#include "ShaderRegistry.h"
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+#include "EmbeddedShaders.inl"
+}
+///////////////////////////////////////////////////////////////////////////////
+
+namespace ShaderRegistry
+{
+///////////////////////////////////////////////////////////////////////////////
+
+const EmbeddedShader* Find(const std::string& i_name)
+{
+    // A handful of shaders, a scan beats keeping the generated table sorted
+    for (const EmbeddedShader& shader : k_embeddedShaders)
+    {
+        if (i_name == shader.name)
+        {
+            return &shader;
+        }
+    }
+    return nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} //namespace ShaderRegistry
+} //namespace VulkanAPI
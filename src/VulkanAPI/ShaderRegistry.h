@@ -0,0 +1,22 @@
+#pragma once
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+// SPIR-V compiled into the executable, generated from shaders/*.spv by "premake5 embed-shaders"
+struct EmbeddedShader
+{
+    // File name without the .spv extension
+    const char* name;
+    const uint32_t* code;
+    size_t codeSize;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ShaderRegistry
+{
+    // nullptr when no shader of that name was embedded
+    const EmbeddedShader* Find(const std::string& i_name);
+}
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
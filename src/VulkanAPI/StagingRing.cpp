@@ -0,0 +1,447 @@
+#include "stdafx.h"
+#include "StagingRing.h"
+#include "VulkanAPI/QueueOwnership.h"
+
+#include <vulkan/vulkan.h>
+#include <algorithm>
+#include <cstring>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+    // Every stage a freshly uploaded buffer or image may be consumed by
+    constexpr VkPipelineStageFlags k_consumerStages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    constexpr VkAccessFlags k_consumerAccess = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+    VkDeviceSize AlignUp(VkDeviceSize i_value, VkDeviceSize i_alignment)
+    {
+        return (i_value + i_alignment - 1) & ~(i_alignment - 1);
+    }
+
+    // The whole mip level a copy writes
+    VkImageSubresourceRange MipLevelRange(const VkImageSubresourceLayers& i_subresource)
+    {
+        VkImageSubresourceRange range{};
+        range.aspectMask = i_subresource.aspectMask;
+        range.baseMipLevel = i_subresource.mipLevel;
+        range.levelCount = 1;
+        range.baseArrayLayer = i_subresource.baseArrayLayer;
+        range.layerCount = i_subresource.layerCount;
+        return range;
+    }
+
+    // Counts the reallocations, the kept copy lists should stop growing after the first frames
+    template<typename T>
+    void PushBack(std::vector<T>& io_vector, const T& i_value, uint64_t& io_allocationCount)
+    {
+        if (io_vector.size() == io_vector.capacity())
+        {
+            io_allocationCount++;
+        }
+        io_vector.push_back(i_value);
+    }
+
+    void BeginCommandBuffer(VkCommandBuffer i_commandBuffer)
+    {
+        vkResetCommandBuffer(i_commandBuffer, 0);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        if (vkBeginCommandBuffer(i_commandBuffer, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("failed to begin recording staging command buffer!");
+        }
+    }
+
+    void EndCommandBuffer(VkCommandBuffer i_commandBuffer)
+    {
+        if (vkEndCommandBuffer(i_commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to record staging command buffer!");
+        }
+    }
+}
+///////////////////////////////////////////////////////////////////////////////
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+
+StagingRing::StagingRing(MemoryAllocator& i_memoryAllocator, VkDevice i_device, VkCommandPool i_commandPool, uint32_t i_graphicsFamily,
+    uint32_t i_transferFamily, VkQueue i_transferQueue, VkDeviceSize i_bytesPerFrame, uint32_t i_framesInFlight, const VkAllocationCallbacks* i_allocator)
+    : m_memoryAllocator(i_memoryAllocator)
+    , m_device(i_device)
+    , m_allocator(i_allocator)
+    , m_bytesPerFrame(i_bytesPerFrame)
+    , m_buffer(VK_NULL_HANDLE)
+    , m_graphicsFamily(i_graphicsFamily)
+    , m_transferFamily(i_transferFamily)
+    , m_transferQueue(i_transferQueue)
+    , m_transferCommandPool(VK_NULL_HANDLE)
+    , m_frameIndex(0)
+    , m_head(0)
+    , m_recording(false)
+{
+    assert(i_framesInFlight > 0);
+
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = m_bytesPerFrame * i_framesInFlight;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(m_device, &bufferInfo, m_allocator, &m_buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create staging buffer!");
+    }
+
+    // Coherent so writes need no flush before the submit
+    m_memory = m_memoryAllocator.AllocateForBuffer(m_buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    assert(m_memory.mappedData != nullptr);
+
+    m_commandBuffers.resize(i_framesInFlight);
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = i_commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = i_framesInFlight;
+
+    if (vkAllocateCommandBuffers(m_device, &allocInfo, m_commandBuffers.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate staging command buffers!");
+    }
+
+    if (!IsDedicatedTransfer())
+    {
+        return;
+    }
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = m_transferFamily;
+
+    if (vkCreateCommandPool(m_device, &poolInfo, m_allocator, &m_transferCommandPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create staging command pool!");
+    }
+
+    m_transferCommandBuffers.resize(i_framesInFlight);
+    allocInfo.commandPool = m_transferCommandPool;
+
+    if (vkAllocateCommandBuffers(m_device, &allocInfo, m_transferCommandBuffers.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate staging command buffers!");
+    }
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    m_transferSemaphores.resize(i_framesInFlight, VK_NULL_HANDLE);
+    for (VkSemaphore& semaphore : m_transferSemaphores)
+    {
+        if (vkCreateSemaphore(m_device, &semaphoreInfo, m_allocator, &semaphore) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create staging semaphore!");
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+StagingRing::~StagingRing()
+{
+    // The command buffers go with their pools
+    for (VkSemaphore semaphore : m_transferSemaphores)
+    {
+        vkDestroySemaphore(m_device, semaphore, m_allocator);
+    }
+    vkDestroyCommandPool(m_device, m_transferCommandPool, m_allocator);
+    vkDestroyBuffer(m_device, m_buffer, m_allocator);
+    m_memoryAllocator.Free(m_memory);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void StagingRing::BeginFrame(uint32_t i_frameIndex)
+{
+    assert(i_frameIndex < m_commandBuffers.size());
+
+    // The frame was abandoned before its submit (e.g. swapchain out of date), keep what was queued
+    if (m_recording && i_frameIndex == m_frameIndex)
+    {
+        return;
+    }
+
+    m_frameIndex = i_frameIndex;
+    m_head = 0;
+    m_recording = true;
+    m_bufferCopies.clear();
+    m_imageCopies.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+StagingRing::Region StagingRing::Allocate(VkDeviceSize i_size, VkDeviceSize i_alignment)
+{
+    assert(m_recording);
+    assert(i_alignment > 0 && (i_alignment & (i_alignment - 1)) == 0);
+
+    Region region;
+    const VkDeviceSize offset = AlignUp(m_head, i_alignment);
+    if (offset + i_size > m_bytesPerFrame)
+    {
+        return region;
+    }
+    m_head = offset + i_size;
+
+    const VkDeviceSize bufferOffset = static_cast<VkDeviceSize>(m_frameIndex) * m_bytesPerFrame + offset;
+    region.data = static_cast<char*>(m_memory.mappedData) + bufferOffset;
+    region.buffer = m_buffer;
+    region.offset = bufferOffset;
+    region.size = i_size;
+    return region;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void StagingRing::CopyToBuffer(const Region& i_source, VkBuffer i_destination, VkDeviceSize i_destinationOffset)
+{
+    assert(m_recording && i_source.data != nullptr);
+
+    BufferCopy copy;
+    copy.destination = i_destination;
+    copy.region.srcOffset = i_source.offset;
+    copy.region.dstOffset = i_destinationOffset;
+    copy.region.size = i_source.size;
+    PushBack(m_bufferCopies, copy, m_statistics.allocationCount);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void StagingRing::CopyToImage(const Region& i_source, VkImage i_destination, const VkImageSubresourceLayers& i_subresource, VkExtent3D i_extent, VkImageLayout i_finalLayout)
+{
+    assert(m_recording && i_source.data != nullptr);
+    assert(i_source.offset % 4 == 0);
+
+    ImageCopy copy;
+    copy.destination = i_destination;
+    copy.region = {};
+    copy.region.bufferOffset = i_source.offset;
+    copy.region.imageSubresource = i_subresource;
+    copy.region.imageOffset = { 0, 0, 0 };
+    copy.region.imageExtent = i_extent;
+    copy.finalLayout = i_finalLayout;
+    PushBack(m_imageCopies, copy, m_statistics.allocationCount);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool StagingRing::UploadToBuffer(const void* i_data, VkDeviceSize i_size, VkBuffer i_destination, VkDeviceSize i_destinationOffset)
+{
+    Region region = Allocate(i_size);
+    if (region.data == nullptr)
+    {
+        return false;
+    }
+
+    memcpy(region.data, i_data, static_cast<size_t>(i_size));
+    CopyToBuffer(region, i_destination, i_destinationOffset);
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+StagingRing::Submission StagingRing::EndFrame()
+{
+    assert(m_recording);
+    m_recording = false;
+
+    Submission submission;
+    if (m_bufferCopies.empty() && m_imageCopies.empty())
+    {
+        return submission;
+    }
+
+    VkCommandBuffer commandBuffer = m_commandBuffers[m_frameIndex];
+
+    if (!IsDedicatedTransfer())
+    {
+        BeginCommandBuffer(commandBuffer);
+        RecordCopies(commandBuffer);
+
+        // No ownership to hand over, the images still leave the transfer layout here
+        for (size_t i = 0; i < m_imageCopies.size(); i++)
+        {
+            VkImageMemoryBarrier& barrier = m_imageBarriers[i];
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = k_consumerAccess;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = m_imageCopies[i].finalLayout;
+        }
+
+        // Make every copy visible to the frame's command buffer submitted right after this one
+        VkMemoryBarrier memoryBarrier{};
+        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        memoryBarrier.dstAccessMask = k_consumerAccess;
+        const uint32_t imageBarrierCount = m_imageCopies.empty() ? 0 : static_cast<uint32_t>(m_imageBarriers.size());
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, k_consumerStages, 0, 1, &memoryBarrier, 0, nullptr, imageBarrierCount, m_imageBarriers.data());
+
+        EndCommandBuffer(commandBuffer);
+        submission.commandBuffer = commandBuffer;
+        return submission;
+    }
+
+    // The copy engine runs the copies while graphics is still busy with earlier frames
+    VkCommandBuffer transferCommandBuffer = m_transferCommandBuffers[m_frameIndex];
+    BeginCommandBuffer(transferCommandBuffer);
+    RecordCopies(transferCommandBuffer);
+    RecordOwnershipRelease(transferCommandBuffer);
+    EndCommandBuffer(transferCommandBuffer);
+
+    VkSemaphore semaphore = m_transferSemaphores[m_frameIndex];
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &transferCommandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &semaphore;
+
+    // No fence, the frame's submit waits on the semaphore and its fence retires both
+    if (vkQueueSubmit(m_transferQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit staging command buffer!");
+    }
+    m_statistics.transferSubmitCount++;
+
+    BeginCommandBuffer(commandBuffer);
+    RecordOwnershipAcquire(commandBuffer);
+    EndCommandBuffer(commandBuffer);
+
+    // The acquires wait for nothing on their own, the semaphore holds back the stages they make the copies visible to
+    submission.commandBuffer = commandBuffer;
+    submission.waitSemaphore = semaphore;
+    submission.waitStage = k_consumerStages;
+    return submission;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void StagingRing::RecordCopies(VkCommandBuffer i_commandBuffer)
+{
+    // One vkCmdCopyBuffer per destination instead of one per upload
+    if (!m_bufferCopies.empty())
+    {
+        std::sort(m_bufferCopies.begin(), m_bufferCopies.end(), [](const BufferCopy& i_a, const BufferCopy& i_b) {
+            // Staging offsets only grow within a frame, they keep the upload order per destination
+            return i_a.destination != i_b.destination ? i_a.destination < i_b.destination : i_a.region.srcOffset < i_b.region.srcOffset;
+        });
+
+        size_t first = 0;
+        while (first < m_bufferCopies.size())
+        {
+            size_t last = first;
+            while (last < m_bufferCopies.size() && m_bufferCopies[last].destination == m_bufferCopies[first].destination)
+            {
+                last++;
+            }
+
+            m_copyRegions.clear();
+            for (size_t i = first; i < last; i++)
+            {
+                PushBack(m_copyRegions, m_bufferCopies[i].region, m_statistics.allocationCount);
+            }
+            vkCmdCopyBuffer(i_commandBuffer, m_buffer, m_bufferCopies[first].destination, static_cast<uint32_t>(m_copyRegions.size()), m_copyRegions.data());
+
+            first = last;
+        }
+    }
+
+    if (!m_imageCopies.empty())
+    {
+        m_imageBarriers.clear();
+        for (const ImageCopy& copy : m_imageCopies)
+        {
+            VkImageMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = copy.destination;
+            barrier.subresourceRange = MipLevelRange(copy.region.imageSubresource);
+            PushBack(m_imageBarriers, barrier, m_statistics.allocationCount);
+        }
+        vkCmdPipelineBarrier(i_commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(m_imageBarriers.size()), m_imageBarriers.data());
+
+        for (const ImageCopy& copy : m_imageCopies)
+        {
+            vkCmdCopyBufferToImage(i_commandBuffer, m_buffer, copy.destination, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy.region);
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+size_t StagingRing::NextWrittenRange(size_t i_first, VkDeviceSize& o_offset, VkDeviceSize& o_size)
+{
+    // Sorted by RecordCopies, back to back copies into one destination change hands in a single barrier
+    const BufferCopy& first = m_bufferCopies[i_first];
+    o_offset = first.region.dstOffset;
+    o_size = first.region.size;
+
+    size_t last = i_first + 1;
+    while (last < m_bufferCopies.size() && m_bufferCopies[last].destination == first.destination && m_bufferCopies[last].region.dstOffset == o_offset + o_size)
+    {
+        o_size += m_bufferCopies[last].region.size;
+        last++;
+    }
+    return last;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void StagingRing::RecordOwnershipRelease(VkCommandBuffer i_commandBuffer)
+{
+    // Only the written ranges change hands, graphics keeps the rest of each destination
+    size_t first = 0;
+    while (first < m_bufferCopies.size())
+    {
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        const size_t last = NextWrittenRange(first, offset, size);
+        QueueOwnership::ReleaseBuffer(i_commandBuffer, m_bufferCopies[first].destination, offset, size,
+            m_transferFamily, m_graphicsFamily, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+        first = last;
+    }
+
+    for (const ImageCopy& copy : m_imageCopies)
+    {
+        QueueOwnership::ReleaseImage(i_commandBuffer, copy.destination, MipLevelRange(copy.region.imageSubresource), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, copy.finalLayout,
+            m_transferFamily, m_graphicsFamily, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void StagingRing::RecordOwnershipAcquire(VkCommandBuffer i_commandBuffer)
+{
+    // Must mirror RecordOwnershipRelease barrier for barrier
+    size_t first = 0;
+    while (first < m_bufferCopies.size())
+    {
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        const size_t last = NextWrittenRange(first, offset, size);
+        QueueOwnership::AcquireBuffer(i_commandBuffer, m_bufferCopies[first].destination, offset, size,
+            m_transferFamily, m_graphicsFamily, k_consumerStages, k_consumerAccess);
+        first = last;
+    }
+
+    for (const ImageCopy& copy : m_imageCopies)
+    {
+        QueueOwnership::AcquireImage(i_commandBuffer, copy.destination, MipLevelRange(copy.region.imageSubresource), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, copy.finalLayout,
+            m_transferFamily, m_graphicsFamily, k_consumerStages, k_consumerAccess);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "VulkanAPI/MemoryAllocator.h"
+
+namespace VulkanAPI
+{
+///////////////////////////////////////////////////////////////////////////////
+// Persistently mapped upload buffer split into one partition per frame in flight.
+// Callers write straight into the partition of the frame being recorded, the copies they queue
+// are recorded into a single command buffer per frame. With a dedicated transfer family it runs on the
+// transfer queue and hands the destinations over to graphics, otherwise it rides along with the frame's submit.
+// A partition is reused once the frame's fence has signaled, so uploads never allocate.
+// Not thread safe, only the render thread may use it.
+class StagingRing {
+///////////////////////////////////////////////////////////////////////////////
+public:
+    struct Region {
+        // Null when the frame's partition is full
+        void* data = nullptr;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+    };
+
+    // What the frame's graphics submit has to include for the uploads
+    struct Submission {
+        // Goes ahead of the frame's own command buffer, VK_NULL_HANDLE when nothing was queued
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        // Signaled by the transfer queue once the copies are done, VK_NULL_HANDLE when they run on the graphics queue
+        VkSemaphore waitSemaphore = VK_NULL_HANDLE;
+        VkPipelineStageFlags waitStage = 0;
+    };
+
+    struct Statistics {
+        // Zero when the copies ride along with the frame's submit
+        uint64_t transferSubmitCount = 0;
+        // Times a copy list outgrew its kept capacity, stays flat once the per frame peak was reached
+        uint64_t allocationCount = 0;
+    };
+
+    // i_commandPool belongs to i_graphicsFamily, the transfer family gets a pool of its own when it differs
+    StagingRing(MemoryAllocator& i_memoryAllocator, VkDevice i_device, VkCommandPool i_commandPool, uint32_t i_graphicsFamily,
+        uint32_t i_transferFamily, VkQueue i_transferQueue, VkDeviceSize i_bytesPerFrame, uint32_t i_framesInFlight, const VkAllocationCallbacks* i_allocator);
+    ~StagingRing();
+
+    // Call once the fence of i_frameIndex has signaled, rewinds that frame's partition
+    void BeginFrame(uint32_t i_frameIndex);
+
+    Region Allocate(VkDeviceSize i_size, VkDeviceSize i_alignment = 16);
+
+    // Destination ranges queued for the same buffer within a frame must not overlap
+    void CopyToBuffer(const Region& i_source, VkBuffer i_destination, VkDeviceSize i_destinationOffset);
+    // Transitions the whole mip level from undefined to i_finalLayout around the copy
+    void CopyToImage(const Region& i_source, VkImage i_destination, const VkImageSubresourceLayers& i_subresource, VkExtent3D i_extent, VkImageLayout i_finalLayout);
+
+    // Allocate, memcpy and CopyToBuffer in one call, returns false when the partition is full
+    bool UploadToBuffer(const void* i_data, VkDeviceSize i_size, VkBuffer i_destination, VkDeviceSize i_destinationOffset);
+
+    // Records the queued copies. On a dedicated transfer family they are submitted to its queue right away
+    // and the returned command buffer only acquires the destinations, otherwise it holds the copies.
+    // Submit it ahead of the frame's own command buffer, in the same vkQueueSubmit that waits on waitSemaphore.
+    Submission EndFrame();
+
+    VkDeviceSize GetBytesPerFrame()
+    {
+        return m_bytesPerFrame;
+    }
+
+    Statistics GetStatistics()
+    {
+        return m_statistics;
+    }
+
+private:
+    struct BufferCopy {
+        VkBuffer destination;
+        VkBufferCopy region;
+    };
+
+    struct ImageCopy {
+        VkImage destination;
+        VkBufferImageCopy region;
+        VkImageLayout finalLayout;
+    };
+
+    bool IsDedicatedTransfer()
+    {
+        return m_transferFamily != m_graphicsFamily;
+    }
+
+    void RecordCopies(VkCommandBuffer i_commandBuffer);
+    // Merges the buffer copies from i_first on that write one contiguous range, returns the index past them
+    size_t NextWrittenRange(size_t i_first, VkDeviceSize& o_offset, VkDeviceSize& o_size);
+    void RecordOwnershipRelease(VkCommandBuffer i_commandBuffer);
+    void RecordOwnershipAcquire(VkCommandBuffer i_commandBuffer);
+
+private:
+    MemoryAllocator& m_memoryAllocator;
+    VkDevice m_device;
+    const VkAllocationCallbacks* m_allocator;
+    VkDeviceSize m_bytesPerFrame;
+
+    VkBuffer m_buffer;
+    MemoryAllocation m_memory;
+    // Graphics family, the copies themselves or only the acquires on a dedicated transfer family
+    std::vector<VkCommandBuffer> m_commandBuffers;
+
+    uint32_t m_graphicsFamily;
+    uint32_t m_transferFamily;
+    VkQueue m_transferQueue;
+    // Only created on a dedicated transfer family
+    VkCommandPool m_transferCommandPool;
+    std::vector<VkCommandBuffer> m_transferCommandBuffers;
+    std::vector<VkSemaphore> m_transferSemaphores;
+
+    uint32_t m_frameIndex;
+    VkDeviceSize m_head;
+    bool m_recording;
+
+    // Kept across frames so queuing copies does not allocate once capacity is reached
+    std::vector<BufferCopy> m_bufferCopies;
+    std::vector<ImageCopy> m_imageCopies;
+    std::vector<VkBufferCopy> m_copyRegions;
+    std::vector<VkImageMemoryBarrier> m_imageBarriers;
+    Statistics m_statistics;
+};
+///////////////////////////////////////////////////////////////////////////////
+} //namespace VulkanAPI
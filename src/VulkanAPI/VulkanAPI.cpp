@@ -27,9 +27,9 @@ VulkanAPI::~VulkanAPI()
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void VulkanAPI::CreateInstance(const std::vector<const char*>& i_validationLayers, RequiredInstanceExtensionsInfo& i_requiredInstanceExtensionsInfo, std::unique_ptr<Window>& i_window, std::unique_ptr<FileSystem>& i_fileSystem)
+void VulkanAPI::CreateInstance(const std::vector<const char*>& i_validationLayers, RequiredInstanceExtensionsInfo& i_requiredInstanceExtensionsInfo, std::unique_ptr<Window>& i_window, std::unique_ptr<FileSystem>& i_fileSystem, PresentTarget i_presentTarget, HostAllocationMode i_hostAllocationMode)
 {
-    m_instance = std::make_unique<Instance>(i_validationLayers, i_requiredInstanceExtensionsInfo, i_window, i_fileSystem);
+    m_instance = std::make_unique<Instance>(i_validationLayers, i_requiredInstanceExtensionsInfo, i_window, i_fileSystem, i_presentTarget, i_hostAllocationMode);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -55,9 +55,9 @@ void VulkanAPI::PickPhysicalDevice()
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void VulkanAPI::CreateLogicalDevice()
+void VulkanAPI::CreateLogicalDevice(bool i_preferDynamicRendering)
 {
-    m_instance->CreateLogicalDevice();
+    m_instance->CreateLogicalDevice(i_preferDynamicRendering);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -83,9 +83,114 @@ void VulkanAPI::CreateRenderPass()
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void VulkanAPI::CreateGraphicsPipeline()
+void VulkanAPI::CreateGraphicsPipeline(const std::string& i_shaderOverrideDirectory, uint32_t i_shaderPermutation)
 {
-    m_instance->CreateGraphicsPipeline();
+    m_instance->CreateGraphicsPipeline(i_shaderOverrideDirectory, i_shaderPermutation);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void VulkanAPI::CreateFramebuffers()
+{
+    m_instance->CreateFramebuffers();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void VulkanAPI::CreateCommandPool()
+{
+    m_instance->CreateCommandPool();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void VulkanAPI::CreateCommandBuffers(uint32_t i_framesInFlight, bool i_gpuCounters)
+{
+    m_instance->CreateCommandBuffers(i_framesInFlight, i_gpuCounters);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void VulkanAPI::CreateSyncObjects()
+{
+    m_instance->CreateSyncObjects();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void VulkanAPI::DrawFrame()
+{
+    m_instance->DrawFrame();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void VulkanAPI::WaitIdle()
+{
+    m_instance->WaitIdle();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void VulkanAPI::WaitForPipelines()
+{
+    m_instance->WaitForPipelines();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void VulkanAPI::SavePipelineCache()
+{
+    m_instance->SavePipelineCache();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void VulkanAPI::PrintMemoryStatistics()
+{
+    m_instance->PrintMemoryStatistics();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void VulkanAPI::PrintPipelineStatistics()
+{
+    m_instance->PrintPipelineStatistics();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void VulkanAPI::PrintGpuStatistics()
+{
+    m_instance->PrintGpuStatistics();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void VulkanAPI::PrintHostAllocationStatistics()
+{
+    m_instance->PrintHostAllocationStatistics();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void VulkanAPI::BenchmarkCommandRecording(uint32_t i_drawCount)
+{
+    m_instance->BenchmarkCommandRecording(i_drawCount);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void VulkanAPI::BenchmarkUploads(uint32_t i_uploadCount)
+{
+    m_instance->BenchmarkUploads(i_uploadCount);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void VulkanAPI::CaptureFrame(const std::string& i_fileName)
+{
+    m_instance->CaptureFrame(i_fileName);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
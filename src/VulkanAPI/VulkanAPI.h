@@ -7,6 +7,8 @@ namespace VulkanAPI
 {
 class Instance;
 struct RequiredInstanceExtensionsInfo;
+enum class PresentTarget;
+enum class HostAllocationMode;
 }
 
 namespace VulkanAPI
@@ -18,15 +20,31 @@ public:
     VulkanAPI();
     ~VulkanAPI();
 
-    void CreateInstance(const std::vector<const char*>& i_validationLayers, RequiredInstanceExtensionsInfo& i_requiredInstanceExtensionsInfo, std::unique_ptr<Window>& i_window, std::unique_ptr<FileSystem>& i_fileSystem);
+    void CreateInstance(const std::vector<const char*>& i_validationLayers, RequiredInstanceExtensionsInfo& i_requiredInstanceExtensionsInfo, std::unique_ptr<Window>& i_window, std::unique_ptr<FileSystem>& i_fileSystem, PresentTarget i_presentTarget, HostAllocationMode i_hostAllocationMode);
     void SetupDebugMessenger();
     void CreateSurface();
     void PickPhysicalDevice();
-    void CreateLogicalDevice();
+    void CreateLogicalDevice(bool i_preferDynamicRendering);
     void CreateSwapChain();
     void CreateImageViews();
     void CreateRenderPass();
-    void CreateGraphicsPipeline();
+    void CreateGraphicsPipeline(const std::string& i_shaderOverrideDirectory, uint32_t i_shaderPermutation);
+    void CreateFramebuffers();
+    void CreateCommandPool();
+    void CreateCommandBuffers(uint32_t i_framesInFlight, bool i_gpuCounters);
+    void CreateSyncObjects();
+
+    void DrawFrame();
+    void WaitIdle();
+    void WaitForPipelines();
+    void SavePipelineCache();
+    void PrintMemoryStatistics();
+    void PrintPipelineStatistics();
+    void PrintGpuStatistics();
+    void PrintHostAllocationStatistics();
+    void BenchmarkCommandRecording(uint32_t i_drawCount);
+    void BenchmarkUploads(uint32_t i_uploadCount);
+    void CaptureFrame(const std::string& i_fileName);
 
     void PrintAvailableExtensions();
 
@@ -7,9 +7,10 @@ namespace VulkanAPI
 {
 ///////////////////////////////////////////////////////////////////////////////
 
-WindowSurface::WindowSurface(VkInstance i_instance, VkSurfaceKHR i_surface)
+WindowSurface::WindowSurface(VkInstance i_instance, VkSurfaceKHR i_surface, const VkAllocationCallbacks* i_allocator)
     : m_instance(i_instance)
     ,m_surface(i_surface)
+    ,m_allocator(i_allocator)
 {
 
 }
@@ -18,7 +19,7 @@ WindowSurface::WindowSurface(VkInstance i_instance, VkSurfaceKHR i_surface)
 
 WindowSurface::~WindowSurface()
 {
-    vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+    vkDestroySurfaceKHR(m_instance, m_surface, m_allocator);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
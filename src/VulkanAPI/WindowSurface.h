@@ -6,7 +6,8 @@ namespace VulkanAPI
 class WindowSurface {
 ///////////////////////////////////////////////////////////////////////////////
 public:
-    WindowSurface(VkInstance i_instance, VkSurfaceKHR i_surface);
+    // i_allocator must be compatible with the one i_surface was created with
+    WindowSurface(VkInstance i_instance, VkSurfaceKHR i_surface, const VkAllocationCallbacks* i_allocator);
     ~WindowSurface();
 
     VkSurfaceKHR GetSurface();
@@ -14,6 +15,7 @@ public:
 private:
     VkInstance m_instance;
     VkSurfaceKHR m_surface;
+    const VkAllocationCallbacks* m_allocator;
 };
 ///////////////////////////////////////////////////////////////////////////////
 } //namespace Instance
\ No newline at end of file
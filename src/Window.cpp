@@ -6,10 +6,14 @@
 #include <vulkan/vulkan.h>
 
 #define GLFW_INCLUDE_NONE
+#if defined(_WIN32)
 #define VK_USE_PLATFORM_WIN32_KHR
+#endif
 #include <GLFW/glfw3.h>
+#if defined(_WIN32)
 #define GLFW_EXPOSE_NATIVE_WIN32
 #include <GLFW/glfw3native.h>
+#endif
 
 ///////////////////////////////////////////////////////////////////////////////
 namespace
@@ -20,13 +24,17 @@ namespace
 ///////////////////////////////////////////////////////////////////////////////
 
 Window::Window()
+	: m_window(nullptr)
+	, m_framebufferResized(false)
 {
 	glfwInit();
 
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API); // to not create opengl context
-	glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+	glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
-	m_window = glfwCreateWindow(k_WIDTH, k_WIDTH, "Vulkan", nullptr, nullptr);
+	m_window = glfwCreateWindow(k_WIDTH, k_HEIGHT, "Vulkan", nullptr, nullptr);
+	glfwSetWindowUserPointer(m_window, this);
+	glfwSetFramebufferSizeCallback(m_window, FramebufferResizeCallback);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -54,6 +62,38 @@ void Window::Update()
 
 ///////////////////////////////////////////////////////////////////////////////
 
+void Window::WaitEvents()
+{
+	glfwWaitEvents();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool Window::IsMinimized()
+{
+	Size size = GetFramebufferSize();
+	return size.width == 0 || size.height == 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool Window::ConsumeResized()
+{
+	bool resized = m_framebufferResized;
+	m_framebufferResized = false;
+	return resized;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Window::FramebufferResizeCallback(GLFWwindow* i_window, int /*i_width*/, int /*i_height*/)
+{
+	Window* window = static_cast<Window*>(glfwGetWindowUserPointer(i_window));
+	window->m_framebufferResized = true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 VulkanAPI::RequiredInstanceExtensionsInfo Window::GetRequiredInstanceExtensionsInfo()
 {
 	VulkanAPI::RequiredInstanceExtensionsInfo info;
@@ -64,10 +104,10 @@ VulkanAPI::RequiredInstanceExtensionsInfo Window::GetRequiredInstanceExtensionsI
 
 ///////////////////////////////////////////////////////////////////////////////
 
-VkSurfaceKHR Window::CreateVulkanSurface(VkInstance i_instance)
+VkSurfaceKHR Window::CreateVulkanSurface(VkInstance i_instance, const VkAllocationCallbacks* i_allocator)
 {
 	VkSurfaceKHR surface;
-	if (glfwCreateWindowSurface(i_instance, m_window, nullptr, &surface) != VK_SUCCESS) {
+	if (glfwCreateWindowSurface(i_instance, m_window, i_allocator, &surface) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create window surface!");
 	}
 
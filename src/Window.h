@@ -22,14 +22,24 @@ public:
 
     bool IsExiting();
     void Update();
+    // Blocks until at least one event arrives, used while there is nothing to render
+    void WaitEvents();
+    bool IsMinimized();
+
+    // Returns true once after the framebuffer changed size
+    bool ConsumeResized();
 
     VulkanAPI::RequiredInstanceExtensionsInfo GetRequiredInstanceExtensionsInfo();
-    VkSurfaceKHR CreateVulkanSurface(VkInstance i_instance);
+    VkSurfaceKHR CreateVulkanSurface(VkInstance i_instance, const VkAllocationCallbacks* i_allocator);
 
     Size GetFramebufferSize();
 
+private:
+    static void FramebufferResizeCallback(GLFWwindow* i_window, int i_width, int i_height);
+
 private:
     GLFWwindow* m_window;
+    bool m_framebufferResized;
 
 ///////////////////////////////////////////////////////////////////////////////
 };
\ No newline at end of file
@@ -1,12 +1,12 @@
 #include "stdafx.h"
 #include "Application.h"
+#include "ApplicationConfig.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 
-int main() {
-    Application app;
-
+int main(int argc, char** argv) {
     try {
+        Application app(ApplicationConfig::ParseCommandLine(argc, argv));
         app.Run();
     }
     catch (const std::exception& e) {
@@ -17,4 +17,4 @@ int main() {
     return EXIT_SUCCESS;
 }
 
-///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
+///////////////////////////////////////////////////////////////////////////////
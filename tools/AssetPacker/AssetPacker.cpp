@@ -0,0 +1,202 @@
+#include "stdafx.h"
+
+#include "AssetArchiveFormat.h"
+#include "Compression.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+// Packs loose files into a .lvpk archive that FileSystem::Mount can serve them from.
+// Paths are stored as given on the command line, relative to where the application runs.
+//
+//     AssetPacker [--store] <archive.lvpk> <file or directory>...
+
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
+    // Compressed entries can't be used in place, only worth it when they get noticeably smaller
+    constexpr uint64_t k_minSavingsDivisor = 8;
+
+    struct PackedEntry
+    {
+        std::string path;
+        std::vector<char> data;
+        AssetArchiveFormat::TocEntry toc{};
+    };
+
+    std::vector<char> ReadInput(const std::filesystem::path& i_path)
+    {
+        std::ifstream file(i_path, std::ios::ate | std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open " + i_path.string() + "!");
+        }
+
+        std::vector<char> data(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(data.data(), data.size());
+        return data;
+    }
+
+    uint64_t AlignUp(uint64_t i_value, uint64_t i_alignment)
+    {
+        return (i_value + i_alignment - 1) / i_alignment * i_alignment;
+    }
+
+    void AddFile(std::vector<PackedEntry>& io_entries, const std::filesystem::path& i_path, bool i_compress)
+    {
+        PackedEntry entry;
+        entry.path = AssetArchiveFormat::NormalizePath(i_path.lexically_normal().generic_string());
+        entry.data = ReadInput(i_path);
+        entry.toc.pathHash = AssetArchiveFormat::HashPath(entry.path);
+        entry.toc.size = entry.data.size();
+        entry.toc.compression = AssetArchiveFormat::EntryCompression::None;
+
+        if (i_compress && !entry.data.empty())
+        {
+            std::vector<char> compressed = Compression::Compress(entry.data.data(), entry.data.size());
+            if (compressed.size() < entry.data.size() - entry.data.size() / k_minSavingsDivisor)
+            {
+                entry.data = std::move(compressed);
+                entry.toc.compression = AssetArchiveFormat::EntryCompression::Lz;
+            }
+        }
+        entry.toc.storedSize = entry.data.size();
+
+        io_entries.push_back(std::move(entry));
+    }
+
+    void WriteArchive(const std::string& i_fileName, std::vector<PackedEntry>& io_entries)
+    {
+        using namespace AssetArchiveFormat;
+
+        std::sort(io_entries.begin(), io_entries.end(), [](const PackedEntry& i_a, const PackedEntry& i_b) {
+            return i_a.toc.pathHash != i_b.toc.pathHash ? i_a.toc.pathHash < i_b.toc.pathHash : i_a.path < i_b.path;
+        });
+
+        for (size_t i = 1; i < io_entries.size(); i++)
+        {
+            if (io_entries[i].path == io_entries[i - 1].path) {
+                throw std::runtime_error("failed to pack, " + io_entries[i].path + " was given twice!");
+            }
+        }
+
+        Header header{};
+        header.magic = k_magic;
+        header.version = k_version;
+        header.entryCount = static_cast<uint32_t>(io_entries.size());
+        header.tocOffset = sizeof(Header);
+        header.pathsOffset = header.tocOffset + io_entries.size() * sizeof(TocEntry);
+
+        std::string paths;
+        for (PackedEntry& entry : io_entries)
+        {
+            entry.toc.pathOffset = static_cast<uint32_t>(paths.size());
+            entry.toc.pathSize = static_cast<uint32_t>(entry.path.size());
+            paths += entry.path;
+        }
+        header.pathsSize = static_cast<uint32_t>(paths.size());
+
+        uint64_t offset = AlignUp(header.pathsOffset + paths.size(), k_entryAlignment);
+        for (PackedEntry& entry : io_entries)
+        {
+            entry.toc.offset = offset;
+            offset = AlignUp(offset + entry.toc.storedSize, k_entryAlignment);
+        }
+
+        std::ofstream file(i_fileName, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open " + i_fileName + " for writing!");
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const PackedEntry& entry : io_entries)
+        {
+            file.write(reinterpret_cast<const char*>(&entry.toc), sizeof(entry.toc));
+        }
+        file.write(paths.data(), paths.size());
+
+        const std::vector<char> padding(k_entryAlignment, 0);
+        for (const PackedEntry& entry : io_entries)
+        {
+            const uint64_t position = static_cast<uint64_t>(file.tellp());
+            file.write(padding.data(), static_cast<std::streamsize>(entry.toc.offset - position));
+            file.write(entry.data.data(), entry.data.size());
+        }
+
+        if (!file.good()) {
+            throw std::runtime_error("failed to write " + i_fileName + "!");
+        }
+    }
+}
+///////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+    bool compress = true;
+    std::string archiveFileName;
+    std::vector<std::filesystem::path> inputs;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string argument = argv[i];
+        if (argument == "--store")
+        {
+            compress = false;
+        }
+        else if (archiveFileName.empty())
+        {
+            archiveFileName = argument;
+        }
+        else
+        {
+            inputs.push_back(argument);
+        }
+    }
+
+    if (archiveFileName.empty() || inputs.empty())
+    {
+        std::cerr << "usage: AssetPacker [--store] <archive.lvpk> <file or directory>..." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try {
+        std::vector<PackedEntry> entries;
+        for (const std::filesystem::path& input : inputs)
+        {
+            if (std::filesystem::is_directory(input))
+            {
+                for (const std::filesystem::directory_entry& file : std::filesystem::recursive_directory_iterator(input))
+                {
+                    if (file.is_regular_file())
+                    {
+                        AddFile(entries, file.path(), compress);
+                    }
+                }
+            }
+            else
+            {
+                AddFile(entries, input, compress);
+            }
+        }
+
+        WriteArchive(archiveFileName, entries);
+
+        uint64_t size = 0;
+        uint64_t storedSize = 0;
+        for (const PackedEntry& entry : entries)
+        {
+            size += entry.toc.size;
+            storedSize += entry.toc.storedSize;
+        }
+        std::cout << "packed " << entries.size() << " files into " << archiveFileName
+            << ", " << size << " bytes stored as " << storedSize << std::endl;
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////